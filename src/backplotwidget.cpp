@@ -1,14 +1,20 @@
 #include "backplotwidget.h"
 #include "motion.h"
 #include "geometry.h"
+#include "parallel.h"
+#include "plotcolors.h"
 
+#include <QMouseEvent>
 #include <QOpenGLShaderProgram>
 #include <QWheelEvent>
 #include <QFile>
 
+#include <glm/common.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
+#include <algorithm>
 #include <cmath>
+#include <mutex>
 
 static bool addShaderFromFile(const char *filename,
                               QOpenGLShader::ShaderType type,
@@ -66,9 +72,37 @@ void BackplotWidget::clear()
 {
     m_vertices.clear();
     m_offsets.clear();
+    m_blockNumbers.clear();
+    m_segmentIndex.clear();
+    m_timeline.clear();
+    m_playback.reset();
     m_boundingBox.reset();
 }
 
+void BackplotWidget::releaseBuffers()
+{
+    // clear() keeps the capacity
+    m_vertices = {};
+    m_offsets = {};
+    m_blockNumbers = {};
+    m_segmentIndex = {};
+    m_timeline = {};
+    m_playback.reset();
+    m_boundingBox.reset();
+
+    if (m_trajectoryBuffer.isCreated())
+    {
+        makeCurrent();
+        m_trajectoryBuffer.bind();
+        m_trajectoryBuffer.allocate(0);
+        m_trajectoryBuffer.release();
+        doneCurrent();
+    }
+    m_trajectoryChange = false;
+    m_buffersReleased = true;
+    emit durationChanged(0.0);
+}
+
 void BackplotWidget::initializeGL()
 {
     initializeOpenGLFunctions();
@@ -88,8 +122,8 @@ void BackplotWidget::initializeGL()
     BackgroundVertex::Point topRight {1.0f, 1.0f};
     BackgroundVertex::Point bottomLeft {-1.0f, -1.0f};
     BackgroundVertex::Point bottomRight {1.0f, -1.0f};
-    BackgroundVertex::Color topColor {170, 180, 190};
-    BackgroundVertex::Color bottomColor {210, 220, 230};
+    BackgroundVertex::Color topColor {PlotColors::backgroundTop};
+    BackgroundVertex::Color bottomColor {PlotColors::backgroundBottom};
     BackgroundVertex backgroundBuffer[] {
         {topLeft,     topColor},
         {topRight,    topColor},
@@ -149,9 +183,6 @@ void BackplotWidget::paintGL()
 {
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-    if (m_repaintLocked)
-        return;
-
     // Draw background
     glDisable(GL_DEPTH_TEST);
     m_backgroundVao.bind();
@@ -163,6 +194,14 @@ void BackplotWidget::paintGL()
     glEnable(GL_DEPTH_TEST);
 
     m_trajectoryVao.bind();
+    // the VAO does not restore the GL_ARRAY_BUFFER binding allocate and write work on,
+    // releaseBuffers and other widgets leave it unbound
+    if (!m_trajectoryBuffer.bind())
+    {
+        qWarning("BackplotWidget: cannot bind the trajectory buffer");
+        m_trajectoryVao.release();
+        return;
+    }
     m_trajectoryShaderProgram->bind();
 
     int mvpLocation = m_trajectoryShaderProgram->uniformLocation("uMVP");
@@ -171,87 +210,215 @@ void BackplotWidget::paintGL()
     //m_trajectoryShaderProgram->setUniformValue(mvpLocation, glm::value_ptr(calcViewProjectionMatrix()));
     glUniformMatrix4fv(mvpLocation, 1, GL_FALSE, glm::value_ptr(calcViewProjectionMatrix()));
 
+    const int intensityLocation {m_trajectoryShaderProgram->uniformLocation("uIntensity")};
+    glUniform1f(intensityLocation, 1.0f);
+
+    auto trajByteCount {static_cast<int>(m_vertices.size() * sizeof(Vertex))};
+    auto bboxByteCount {static_cast<int>(m_boundingBoxVertices.size() * sizeof(Vertex))};
     if (m_trajectoryChange)
     {
-        auto trajByteCount {static_cast<int>(m_vertices.size() * sizeof(Vertex))};
-        auto bboxByteCount {static_cast<int>(m_boundingBoxVertices.size() * sizeof(Vertex))};
+        auto toolByteCount {static_cast<int>(m_toolVertices.size() * sizeof(Vertex))};
 
-        m_trajectoryBuffer.allocate(trajByteCount + bboxByteCount);
+        m_trajectoryBuffer.allocate(trajByteCount + bboxByteCount + toolByteCount);
         m_trajectoryBuffer.write(0, m_vertices.data(), trajByteCount);
         if (m_boundingBox.isDefined())
             m_trajectoryBuffer.write(trajByteCount, m_boundingBoxVertices.data(), bboxByteCount);
 
         m_trajectoryChange = false;
     }
+    // a plot after releaseBuffers draws only what was uploaded again
+    if (m_vertices.size() > 1 && m_trajectoryBuffer.size() < trajByteCount + bboxByteCount)
+    {
+        qWarning("BackplotWidget: the trajectory buffer holds %d of %d bytes", m_trajectoryBuffer.size(),
+                 trajByteCount + bboxByteCount);
+        m_trajectoryBuffer.release();
+        m_trajectoryVao.release();
+        return;
+    }
     if (m_vertices.size() > 1)
     {
-        glDrawArrays(GL_LINE_STRIP_ADJACENCY, 0, static_cast<GLsizei>(m_vertices.size()));
+        const auto vertexCount {static_cast<GLsizei>(m_vertices.size())};
+        if (m_playback)
+        {
+            // the strip up to the start vertex of the current segment, then the rest of it faded,
+            // each strip starts and ends with an adjacency vertex
+            const auto cutEnd {static_cast<GLsizei>(m_playback->segment + 1)};
+            glDrawArrays(GL_LINE_STRIP_ADJACENCY, 0, cutEnd + 2);
+            glUniform1f(intensityLocation, fadedIntensity);
+            glDrawArrays(GL_LINE_STRIP_ADJACENCY, cutEnd - 1, vertexCount - (cutEnd - 1));
+            glUniform1f(intensityLocation, 1.0f);
+
+            m_trajectoryBuffer.write(trajByteCount + bboxByteCount, m_toolVertices.data(),
+                                     static_cast<int>(m_toolVertices.size() * sizeof(Vertex)));
+            glDisable(GL_DEPTH_TEST);
+            glDrawArrays(GL_LINES, vertexCount + static_cast<GLint>(m_boundingBoxVertices.size()),
+                         static_cast<GLsizei>(m_toolVertices.size()));
+            glEnable(GL_DEPTH_TEST);
+        }
+        else
+        {
+            glDrawArrays(GL_LINE_STRIP_ADJACENCY, 0, vertexCount);
+        }
         if (m_boundingBox.isDefined())
-            glDrawArrays(GL_LINES, static_cast<GLint>(m_vertices.size()),
-                         static_cast<GLsizei>(m_boundingBoxVertices.size()));
+            glDrawArrays(GL_LINES, vertexCount, static_cast<GLsizei>(m_boundingBoxVertices.size()));
     }
 
+    m_trajectoryBuffer.release();
     m_trajectoryVao.release();
 }
 
-void BackplotWidget::addPoint(const glm::vec3& point, const std::array<GLubyte, 3>& color)
+/**
+ * Plots the motions of a program run. The vertex offset of each motion is known in advance,
+ * so the motions are tessellated in parallel into the preallocated vertex buffer.
+ */
+void BackplotWidget::plot(const MotionList& motions)
 {
-    m_vertices.emplace_back(point, color[0], color[1], color[2]);
-    m_boundingBox.include(point);
-}
+    clear();
 
-void BackplotWidget::saveOffset()
-{
-    m_offsets.push_back(m_vertices.size());
+    const auto& items {motions.items()};
+    m_offsets.resize(items.size());
+    m_blockNumbers.resize(items.size());
+    // the first vertex is duplicated for geometry shader processing LINE_STRIP_ADJACENCY
+    size_t vertexTotal {2};
+    for (size_t i {0}; i < items.size(); i++)
+    {
+        m_offsets[i] = vertexTotal;
+        m_blockNumbers[i] = items[i].blockNumber;
+        vertexTotal += motions.pointCount(i);
+    }
+    // ... and the last one too
+    m_vertices.resize(vertexTotal + 1);
+
+    const glm::vec3 firstPoint {motions.firstPoint()};
+    m_vertices[0] = {firstPoint};
+    m_vertices[1] = m_vertices[0];
+    m_boundingBox.include(firstPoint);
+
+    std::mutex boundingBoxMutex;
+    parallelFor(items.size(), 256, [&](size_t begin, size_t end)
+    {
+        BoundingBox boundingBox;
+        std::vector<glm::dvec3> points;
+        for (size_t i {begin}; i < end; i++)
+        {
+            Vertex* v {&m_vertices[m_offsets[i]]};
+            const auto& color {PlotColors::ofMotion(items[i])};
+            points.resize(motions.pointCount(i));
+            motions.samplePoints(i, points.data());
+            for (const auto& point : points)
+            {
+                *v++ = {point, color[0], color[1], color[2]};
+                boundingBox.include(point);
+            }
+        }
+
+        if (boundingBox.isDefined())
+        {
+            std::lock_guard lock {boundingBoxMutex};
+            m_boundingBox.include(boundingBox.lowerCorner());
+            m_boundingBox.include(boundingBox.upperCorner());
+        }
+    });
+    m_vertices.back() = m_vertices[vertexTotal - 1];
+
+    std::vector<glm::vec3> points(vertexTotal - 1);
+    for (size_t i {0}; i < points.size(); i++)
+        points[i] = m_vertices[i + 1].position;
+    std::vector<size_t> motionSegments(items.size());
+    std::vector<double> motionFeeds(items.size());
+    for (size_t i {0}; i < items.size(); i++)
+    {
+        motionSegments[i] = m_offsets[i] - 2;
+        motionFeeds[i] = items[i].feed;
+    }
+    m_timeline.build(points, motionSegments, motionFeeds);
+
+    updateBoundingBoxVertices();
+    m_trajectoryChange = true;
+    m_buffersReleased = false;
+    update();
+    emit durationChanged(m_timeline.duration());
 }
 
-void BackplotWidget::startTrajectory(const glm::vec3& startPoint)
+std::optional<size_t> BackplotWidget::setPlaybackTime(double seconds)
 {
-    m_repaintLocked = true;
-    clear();
-    addPoint(startPoint, {0, 0, 0});
-    // duplicate first vertex for geometry shader processing LINE_STRIP_ADJACENCY
-    m_vertices.emplace_back(m_vertices.front());
+    update();
+    if (m_timeline.isEmpty() || seconds >= m_timeline.duration())
+    {
+        m_playback.reset();
+        return std::nullopt;
+    }
+
+    m_playback = m_timeline.atTime(seconds);
+    // segment s starts at vertex s + 1
+    const Vertex& start {m_vertices[m_playback->segment + 1]};
+    const Vertex& end {m_vertices[m_playback->segment + 2]};
+    const glm::vec3 tool {glm::mix(start.position, end.position, static_cast<float>(m_playback->parameter))};
+    auto it {m_toolVertices.begin()};
+    *it++ = {start.position, end.color[0], end.color[1], end.color[2]};
+    *it++ = {tool, end.color[0], end.color[1], end.color[2]};
+    const float size {8.0f * pixelSize()};
+    for (int k {0}; k < 3; k++)
+    {
+        glm::vec3 offset {0.0f};
+        offset[k] = size;
+        *it++ = {tool - offset};
+        *it++ = {tool + offset};
+    }
+
+    const auto motion {std::upper_bound(m_offsets.begin(), m_offsets.end(), m_playback->segment + 2)};
+    if (motion == m_offsets.begin())
+        return std::nullopt;
+    return m_blockNumbers[static_cast<size_t>(motion - m_offsets.begin()) - 1];
 }
 
-void BackplotWidget::plot(const LinearMotion& motion)
+std::optional<size_t> BackplotWidget::blockAt(const QPointF& screenPoint)
 {
-    saveOffset();
-    addPoint(motion.getEndPoint(), (motion.getFeed() > 0) ? m_colorLinear : m_colorRapid);
+    glm::vec3 origin;
+    glm::vec3 direction;
+    screenRay(screenPoint, origin, direction);
+    // built on the first pick, most plots are never picked and building takes long for big ones
+    if (m_segmentIndex.isEmpty() && m_vertices.size() > 3)
+    {
+        std::vector<glm::vec3> points(m_vertices.size() - 2);
+        for (size_t i {0}; i < points.size(); i++)
+            points[i] = m_vertices[i + 1].position;
+        m_segmentIndex.build(std::move(points));
+    }
+    const auto hit {m_segmentIndex.pick(origin, direction, pickRadius * pixelSize())};
+    if (!hit)
+        return std::nullopt;
+
+    // the segment ends at vertex segment + 2, it belongs to the last motion starting at or before it
+    const auto it {std::upper_bound(m_offsets.begin(), m_offsets.end(), hit->segment + 2)};
+    if (it == m_offsets.begin())
+        return std::nullopt;
+    return m_blockNumbers[static_cast<size_t>(it - m_offsets.begin()) - 1];
 }
 
-void BackplotWidget::plot(const CircularMotion& motion)
+void BackplotWidget::mousePressEvent(QMouseEvent* event)
 {
-    saveOffset();
-    const auto color {(motion.getFeed() > 0) ? m_colorCircular : m_colorRapid};
-    DirectedArc3Sampler s {motion.getArc()};
-    const int arcPoints {100}; // TODO adaptive precision
-    for (int i {1}; i < arcPoints; i++)
-        addPoint(s.sample((double)i / (double)(arcPoints - 1)), color);
+    m_clickPos = event->pos();
+    OrthographicViewWidget::mousePressEvent(event);
 }
 
-void BackplotWidget::plot(const HelicalMotion& motion)
+void BackplotWidget::mouseReleaseEvent(QMouseEvent* event)
 {
-    saveOffset();
-    const auto color {(motion.getFeed() > 0) ? m_colorCircular : m_colorRapid};
-    HelixSampler s {motion.getHelix()};
-    const int arcPoints = 100 * (motion.getHelix().turn + 1); // TODO adaptive precision
-    for (int i {1}; i < arcPoints; i++)
-        addPoint(s.sample((double)i / (double)(arcPoints - 1)), color);
+    // a click, not the end of a rotation
+    if (event->button() == Qt::LeftButton && (event->pos() - m_clickPos).manhattanLength() <= 2)
+    {
+        if (auto blockNumber {blockAt(event->pos())})
+            emit blockPicked(*blockNumber);
+    }
+    OrthographicViewWidget::mouseReleaseEvent(event);
 }
 
-void BackplotWidget::endTrajectory()
+void BackplotWidget::updateBoundingBoxVertices()
 {
-    m_trajectoryChange = true;
-    m_repaintLocked = false;
-
-    // duplicate last vertex for geometry shader processing LINE_STRIP_ADJACENCY
-    m_vertices.emplace_back(m_vertices.back());
-
     if (m_boundingBox.isDefined())
     {
         auto it = m_boundingBoxVertices.begin();
-#define ADD_POINT(ID) *it++ = {m_boundingBox.corners()[ ID ], 100, 100, 100};
+#define ADD_POINT(ID) *it++ = {m_boundingBox.corners()[ ID ], PlotColors::boundingBox[0], PlotColors::boundingBox[1], PlotColors::boundingBox[2]};
         ADD_POINT(BoundingBox::lower)
         ADD_POINT(BoundingBox::lower_upperX)
         ADD_POINT(BoundingBox::lower)
@@ -280,8 +447,6 @@ void BackplotWidget::endTrajectory()
         setSceneBoundingBox(m_boundingBox);
         setPivotPoint(m_boundingBox.centerPoint());
     }
-
-    update();
 }
 
 BackplotWidget::Vertex::Vertex(const glm::vec3& vec, unsigned char r, unsigned char g, unsigned char b)
@@ -2,7 +2,10 @@
 #define BACKPLOTWIDGET_H
 
 #include "motion.h"
+#include "motionlist.h"
 #include "orthographicviewwidget.h"
+#include "pathtimeline.h"
+#include "segmentindex.h"
 
 #include <QOpenGLFunctions>
 #include <QOpenGLVertexArrayObject>
@@ -10,6 +13,7 @@
 #include <QOpenGLFunctions>
 
 #include <array>
+#include <optional>
 #include <ostream>
 
 
@@ -17,7 +21,7 @@ class QOpenGLShaderProgram;
 
 class BackplotWidget : public OrthographicViewWidget, protected QOpenGLFunctions
 {
-    //Q_OBJECT
+    Q_OBJECT
 public:
     explicit BackplotWidget(QWidget* parent = nullptr);
     ~BackplotWidget();
@@ -28,16 +32,43 @@ public:
     void initializeGL() override;
     void paintGL() override;
 
-    void startTrajectory(const glm::vec3& startPoint);
-    void plot(const LinearMotion& motion);
-    void plot(const CircularMotion& motion);
-    void plot(const HelicalMotion& motion);
-    void endTrajectory();
+    void plot(const MotionList& motions);
+
+    /**
+     * Frees the vertices, the picking and playback data and the GPU buffer of the plot, which
+     * is empty until plotted again.
+     */
+    void releaseBuffers();
+    bool buffersReleased() const noexcept { return m_buffersReleased; }
+
+    /**
+     * Block number of the motion plotted under the point in widget coordinates, if any.
+     */
+    std::optional<size_t> blockAt(const QPointF& screenPoint);
+
+    static constexpr float pickRadius {5.0f}; // in pixels
+
+    // machining time of the plotted motions in seconds
+    double duration() const noexcept { return m_timeline.duration(); }
+    /**
+     * Shows the path up to the tool position at the time, the rest of it faded, without changing
+     * the vertex buffer. Returns the block of the motion at that time, std::nullopt at the end.
+     */
+    std::optional<size_t> setPlaybackTime(double seconds);
+
+    static constexpr float fadedIntensity {0.25f};
+
+signals:
+    void blockPicked(size_t blockNumber);
+    void durationChanged(double seconds);
+
+protected:
+    void mousePressEvent(QMouseEvent* event) override;
+    void mouseReleaseEvent(QMouseEvent* event) override;
 
 private:
-    void addPoint(const glm::vec3& point, const std::array<GLubyte, 3>& color);
-    void saveOffset();
-    
+    void updateBoundingBoxVertices();
+
     QOpenGLVertexArrayObject m_backgroundVao;
     QOpenGLBuffer m_backgroundBuffer{QOpenGLBuffer::VertexBuffer};
     QOpenGLShaderProgram* m_backgroundShaderProgram{nullptr};
@@ -61,16 +92,19 @@ private:
     };
 
     std::vector<Vertex> m_vertices;
-    std::vector<size_t> m_offsets;
+    std::vector<size_t> m_offsets; // first vertex of each motion
+    std::vector<size_t> m_blockNumbers; // of each motion
+    SegmentIndex m_segmentIndex; // over the plotted vertices, without the duplicated first and last one, built by blockAt
+    QPoint m_clickPos;
+    PathTimeline m_timeline; // over the same segments
+    std::optional<PathTimeline::Location> m_playback;
+    // the part of the current segment already cut and the tool cross
+    std::array<Vertex, 8> m_toolVertices;
     bool m_trajectoryChange {false};
-    bool m_repaintLocked {false};
+    bool m_buffersReleased {false};
 
     BoundingBox m_boundingBox;
     std::array<Vertex, 24> m_boundingBoxVertices;
-
-    const std::array<GLubyte, 3> m_colorRapid {255, 50, 50};
-    const std::array<GLubyte, 3> m_colorLinear {50, 255, 50};
-    const std::array<GLubyte, 3> m_colorCircular {40, 180, 255};
 };
 
 
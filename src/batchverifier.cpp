@@ -0,0 +1,274 @@
+#include "batchverifier.h"
+#include "controller.h"
+#include "geometry.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <numeric>
+#include <optional>
+#include <ostream>
+#include <thread>
+
+namespace fs = std::filesystem;
+
+class VerificationListener : public ControllerListener
+{
+public:
+    explicit VerificationListener(BatchVerifier::Result& result)
+        : m_result(result)
+    {}
+
+    void startPoint(const glm::dvec3& point) override
+    {
+        m_position = point;
+        m_result.boundingBox.include(point);
+    }
+    void blockChange(size_t /*blockNumber*/) override {}
+    void linearMotion(const LinearMotion& linearMotion) override
+    {
+        m_result.motionCount++;
+        if (linearMotion.getFeed() <= 0.0)
+            m_result.rapidCount++;
+        m_result.pathLength += glm::length(linearMotion.getEndPoint() - m_position);
+        m_position = linearMotion.getEndPoint();
+        m_result.boundingBox.include(m_position);
+    }
+    void circularMotion(const CircularMotion& circularMotion) override
+    {
+        m_result.motionCount++;
+        const DirectedArc3& arc {circularMotion.getArc()};
+        m_result.pathLength += arcLength(arc.arc2, 0.0, 0);
+        DirectedArc3Sampler {arc}.sampleN(m_points.size(), m_points.data());
+        for (const auto& point : m_points)
+            m_result.boundingBox.include(point);
+        m_position = m_points.back();
+    }
+    void helicalMotion(const HelicalMotion& helicalMotion) override
+    {
+        m_result.motionCount++;
+        const Helix& helix {helicalMotion.getHelix()};
+        m_result.pathLength += arcLength(helix.arc2, helix.zEnd - helix.zStart, helix.turn);
+        HelixSampler {helix}.sampleN(m_points.size(), m_points.data());
+        for (const auto& point : m_points)
+            m_result.boundingBox.include(point);
+        m_position = m_points.back();
+    }
+    void endOfProgram() override {}
+    void alarm(size_t blockNumber, int alarmCode) override
+    {
+        m_result.alarms.emplace_back(blockNumber, alarmCode);
+    }
+    void toolChange(int tool, int /*edge*/) override
+    {
+        // D before any T, T0 unloading the spindle, or a tool selected by name
+        if (tool == 0)
+            return;
+        auto& tools {m_result.tools};
+        const auto it {std::lower_bound(tools.begin(), tools.end(), tool)};
+        if (it == tools.end() || *it != tool)
+            tools.insert(it, tool);
+    }
+
+private:
+    static double arcLength(const DirectedArc2& arc2, double height, unsigned turn)
+    {
+        const double radius {glm::length(arc2.point1 - arc2.center)};
+        const double sweep {std::abs(DirectedArc2Sampler{arc2}.angle()) + turn * glm::two_pi<double>()};
+        return std::hypot(radius * sweep, height);
+    }
+
+    BatchVerifier::Result& m_result;
+    glm::dvec3 m_position {0.0};
+    std::array<glm::dvec3, 32> m_points;
+};
+
+/**
+ * Queue of file indices owned by one worker, the other workers steal from its back.
+ */
+struct WorkQueue
+{
+    std::mutex mutex;
+    std::deque<size_t> items;
+
+    std::optional<size_t> pop(bool steal)
+    {
+        std::lock_guard lock {mutex};
+        if (items.empty())
+            return std::nullopt;
+        size_t item;
+        if (steal)
+        {
+            item = items.back();
+            items.pop_back();
+        }
+        else
+        {
+            item = items.front();
+            items.pop_front();
+        }
+        return item;
+    }
+};
+
+// of a cancellable evaluation, like the evaluation of opened programs
+static constexpr std::chrono::milliseconds sliceTime {100};
+
+/**
+ * Returns false if cancelled, the result is left unverified then.
+ */
+static bool verifyFile(Controller& controller, BatchVerifier::Result& result, const std::atomic<bool>* cancelled)
+{
+    const auto start {std::chrono::steady_clock::now()};
+
+    result.verified = true;
+    std::ifstream file {result.path};
+    result.readable = static_cast<bool>(file);
+    if (result.readable)
+    {
+        VerificationListener listener {result};
+        controller.setListener(&listener);
+        controller.reset();
+        std::string line;
+        while (std::getline(file, line))
+        {
+            if (!line.empty() && line.back() == '\r')
+                line.pop_back();
+            controller.addLine(line);
+            result.blockCount++;
+        }
+        controller.setBudget({cancelled ? sliceTime : std::chrono::milliseconds{0}, 0});
+        controller.run();
+        while (controller.stopReason() == Controller::StopReason::Budget)
+        {
+            if (*cancelled)
+            {
+                controller.setListener(nullptr);
+                BatchVerifier::Result unverified;
+                unverified.path = std::move(result.path);
+                result = std::move(unverified);
+                return false;
+            }
+            controller.resume();
+        }
+        result.jumpLimit = controller.stopReason() == Controller::StopReason::JumpLimit;
+        controller.setListener(nullptr);
+    }
+
+    result.milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    return true;
+}
+
+BatchVerifier::BatchVerifier(unsigned workerCount)
+    : m_workerCount(workerCount > 0 ? workerCount : std::max(1u, std::thread::hardware_concurrency()))
+{
+}
+
+std::vector<BatchVerifier::Result> BatchVerifier::verify(const std::vector<std::string>& paths,
+                                                        const std::function<bool()>& proceed,
+                                                        const std::atomic<bool>* cancelled) const
+{
+    std::vector<Result> results(paths.size());
+    for (size_t i {0}; i < paths.size(); i++)
+        results[i].path = paths[i];
+
+    // largest files first, dealt round-robin, so the queues start out balanced
+    std::vector<std::uintmax_t> sizes(paths.size());
+    for (size_t i {0}; i < paths.size(); i++)
+    {
+        std::error_code error;
+        sizes[i] = fs::file_size(paths[i], error);
+        if (error)
+            sizes[i] = 0;
+    }
+    std::vector<size_t> order(paths.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&sizes](size_t a, size_t b) { return sizes[a] > sizes[b]; });
+
+    const unsigned workerCount {static_cast<unsigned>(std::min<size_t>(m_workerCount, std::max<size_t>(paths.size(), 1)))};
+    std::vector<WorkQueue> queues(workerCount);
+    for (size_t i {0}; i < order.size(); i++)
+        queues[i % workerCount].items.push_back(order[i]);
+
+    std::atomic<bool> stopped {false};
+    auto work = [&queues, &results, &proceed, &stopped, cancelled, workerCount](unsigned worker)
+    {
+        Controller controller;
+        while (!stopped && !(cancelled && *cancelled))
+        {
+            std::optional<size_t> item {queues[worker].pop(false)};
+            for (unsigned k {1}; !item && k < workerCount; k++)
+                item = queues[(worker + k) % workerCount].pop(true);
+            // no work is added while verifying, so empty queues mean we are done
+            if (!item)
+                break;
+            if (!verifyFile(controller, results[*item], cancelled))
+                break;
+            if (proceed && !proceed())
+                stopped = true;
+        }
+    };
+
+    std::vector<std::thread> threads;
+    threads.reserve(workerCount - 1);
+    for (unsigned worker {1}; worker < workerCount; worker++)
+        threads.emplace_back(work, worker);
+    work(0);
+    for (auto& thread : threads)
+        thread.join();
+
+    return results;
+}
+
+std::vector<std::string> BatchVerifier::findPrograms(const std::string& directory)
+{
+    std::vector<std::string> paths;
+    std::error_code error;
+    for (fs::recursive_directory_iterator it {directory, error}, end; !error && it != end; it.increment(error))
+    {
+        if (!it->is_regular_file(error))
+            continue;
+        std::string extension {it->path().extension().string()};
+        std::transform(extension.begin(), extension.end(), extension.begin(),
+                       [](unsigned char c) { return std::tolower(c); });
+        if (extension == ".mpf" || extension == ".spf")
+            paths.push_back(it->path().string());
+    }
+    std::sort(paths.begin(), paths.end());
+    return paths;
+}
+
+void BatchVerifier::writeReport(std::ostream& stream, const std::vector<Result>& results)
+{
+    size_t failed {0};
+    double milliseconds {0.0};
+
+    stream << "path\tstatus\talarms\tblocks\tmotions\tmin x\tmin y\tmin z\tmax x\tmax y\tmax z\tms\n";
+    for (const auto& result : results)
+    {
+        if (result.failed())
+            failed++;
+        milliseconds += result.milliseconds;
+
+        stream << result.path << '\t'
+               << (!result.readable ? "unreadable" : !result.alarms.empty() ? "alarm"
+                                                   : result.jumpLimit ? "jump limit" : "ok") << '\t';
+        // alarms as code@line
+        for (size_t i {0}; i < result.alarms.size(); i++)
+            stream << (i > 0 ? "," : "") << result.alarms[i].second << '@' << result.alarms[i].first + 1;
+        stream << '\t' << result.blockCount << '\t' << result.motionCount;
+        for (const auto& corner : {result.boundingBox.lowerCorner(), result.boundingBox.upperCorner()})
+            for (int k {0}; k < 3; k++)
+                stream << '\t' << (result.boundingBox.isDefined() ? corner[k] : 0.0f);
+        stream << '\t' << static_cast<long long>(result.milliseconds + 0.5) << '\n';
+    }
+    stream << "# " << results.size() << " files, " << failed << " failed, "
+           << static_cast<long long>(milliseconds + 0.5) << " ms total\n";
+}
@@ -0,0 +1,61 @@
+#ifndef BATCHVERIFIER_H
+#define BATCHVERIFIER_H
+
+#include "boundingbox.h"
+
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <iosfwd>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * Parses and evaluates many programs concurrently, one Controller per worker thread.
+ * Files are taken from per-worker queues, idle workers steal from the others.
+ */
+class BatchVerifier
+{
+public:
+    struct Result
+    {
+        std::string path;
+        bool verified {false}; // else skipped after stopping
+        bool readable {false};
+        std::vector<std::pair<std::size_t, int>> alarms; // block index, alarm code
+        bool jumpLimit {false}; // the evaluation stopped at the jump limit, likely an endless loop
+        std::size_t blockCount {0};
+        std::size_t motionCount {0};
+        std::size_t rapidCount {0};
+        double pathLength {0.0};
+        std::vector<int> tools; // selected with T, sorted, without T0
+        BoundingBox boundingBox;
+        double milliseconds {0.0};
+
+        bool failed() const noexcept { return !readable || !alarms.empty() || jumpLimit; }
+    };
+
+    explicit BatchVerifier(unsigned workerCount = 0);
+
+    /**
+     * Verifies the files, results are in the order of paths. proceed() is called by the workers
+     * after each file, once it returns false they skip the files left. With cancelled, files are
+     * evaluated in slices, setting it gives up the files being evaluated within a slice, they are
+     * left unverified.
+     */
+    std::vector<Result> verify(const std::vector<std::string>& paths, const std::function<bool()>& proceed = {},
+                               const std::atomic<bool>* cancelled = nullptr) const;
+
+    /**
+     * Program files in the directory and its subdirectories, sorted by path.
+     */
+    static std::vector<std::string> findPrograms(const std::string& directory);
+
+    static void writeReport(std::ostream& stream, const std::vector<Result>& results);
+
+private:
+    unsigned m_workerCount;
+};
+
+#endif // BATCHVERIFIER_H
@@ -2,9 +2,20 @@
 #include "highlighter.h"
 #include "controller.h"
 #include "backplotwidget.h"
+#include "s840d_alarm.h"
 
+#include <QAction>
+#include <QContextMenuEvent>
+#include <QCryptographicHash>
+#include <QMenu>
 #include <QPainter>
 #include <QTextBlock>
+#include <QTimer>
+
+#include <algorithm>
+#include <cmath>
+#include <thread>
+#include <utility>
 
 
 CodeEditor::CodeEditor(BackplotWidget& backplot, QWidget* parent)
@@ -12,6 +23,10 @@ CodeEditor::CodeEditor(BackplotWidget& backplot, QWidget* parent)
       m_backplot(backplot)
 {
     m_controller.setListener(this);
+    // only pays off if the chunks actually run concurrently
+    m_controller.setParallelEvaluation(std::thread::hardware_concurrency() > 1);
+    // the partial results are shown and the rest evaluated on request
+    m_controller.setBudget({evaluationBudget, 0});
 
     const QFont font("Source Code Pro", 12);
     setFont(font);
@@ -29,23 +44,298 @@ CodeEditor::CodeEditor(BackplotWidget& backplot, QWidget* parent)
     updateLineNumberAreaWidth();
     highlightCurrentLine();
 
-    highlighter = new Highlighter(document());
+    highlighter = new Highlighter(this, m_controller.parser());
+
+    m_goToDefinitionAction = new QAction(tr("Go to definition"), this);
+    m_goToDefinitionAction->setShortcut(Qt::Key_F2);
+    m_goToDefinitionAction->setShortcutContext(Qt::WidgetShortcut);
+    connect(m_goToDefinitionAction, &QAction::triggered, this, &CodeEditor::goToDefinition);
+    addAction(m_goToDefinitionAction);
+    m_findUsagesAction = new QAction(tr("Find usages"), this);
+    m_findUsagesAction->setShortcut(Qt::CTRL | Qt::SHIFT | Qt::Key_U);
+    m_findUsagesAction->setShortcutContext(Qt::WidgetShortcut);
+    connect(m_findUsagesAction, &QAction::triggered, this, &CodeEditor::findUsages);
+    addAction(m_findUsagesAction);
+    m_profileAction = new QAction(tr("Profile evaluation"), this);
+    m_profileAction->setCheckable(true);
+    connect(m_profileAction, &QAction::toggled, this, &CodeEditor::setProfiling);
+    m_continueEvaluationAction = new QAction(tr("Continue evaluation"), this);
+    m_continueEvaluationAction->setEnabled(false);
+    connect(m_continueEvaluationAction, &QAction::triggered, this, &CodeEditor::continueEvaluation);
+    m_continueTimer = new QTimer(this);
+    connect(m_continueTimer, &QTimer::timeout, this, [this]()
+    {
+        m_controller.resume();
+        onEvaluationStop();
+    });
+
+    // emitted before textChanged, so the changed lines are indexed before the evaluation
+    connect(document(), &QTextDocument::contentsChange, this, &CodeEditor::onContentsChange);
+    onContentsChange(0, 0, document()->characterCount());
 
     if (!document()->isEmpty())
         onDocumentChange();
 }
 
+void CodeEditor::setEvaluationCache(EvaluationCache* cache) noexcept
+{
+    m_evaluationCache = cache;
+}
+
+std::string CodeEditor::evaluationCacheKey(const QString& text)
+{
+    QCryptographicHash hash {QCryptographicHash::Sha1};
+    hash.addData(QByteArray::number(Controller::evaluationVersion));
+    hash.addData(text.toUtf8());
+    return hash.result().toHex().toStdString();
+}
+
+void CodeEditor::setCrossReferences(CrossReferenceIndex crossReferences)
+{
+    m_pendingCrossReferences = std::move(crossReferences);
+}
+
+bool CodeEditor::exportMotionLog(const QString& path) const
+{
+    MotionLogWriter motionLog;
+    Controller controller;
+    controller.setListener(&motionLog);
+    for (QTextBlock block = document()->begin(); block.isValid(); block = block.next())
+        controller.addLine(block.text());
+    controller.run();
+
+    return motionLog.write(path.toStdString());
+}
+
 void CodeEditor::onDocumentChange()
 {
+    if (m_evaluationDeferred)
+    {
+        m_evaluationPending = true;
+        m_continuePending = false;
+        m_continueTimer->stop();
+        return;
+    }
+    m_evaluationPending = false;
+
+    m_continueTimer->stop();
+    m_evaluationStop.reset();
+    m_continueEvaluationAction->setEnabled(false);
     m_colorHints.resize(blockCount(), ColorHintType::Unset);
 
     clearLineColorHints();
 
+    // only the document as loaded is cached, edits are evaluated as usual, profiles never
+    EvaluationCache* cache {std::exchange(m_evaluationCache, nullptr)};
+    if (m_profiling)
+        cache = nullptr;
+    std::string cacheKey;
+    if (cache)
+    {
+        cacheKey = evaluationCacheKey(toPlainText());
+        if (cache->load(cacheKey, *this))
+            return;
+        m_recorder = std::make_unique<MotionLogWriter>();
+    }
+
     m_controller.reset();
     for (QTextBlock block = document()->begin(); block.isValid(); block = block.next())
         m_controller.addLine(block.text());
 
     m_controller.run();
+
+    onEvaluationStop();
+
+    // partial evaluations are not cached
+    if (cache)
+    {
+        if (!m_controller.canResume())
+            cache->store(cacheKey, *m_recorder);
+        m_recorder.reset();
+    }
+}
+
+/**
+ * Indexes the blocks containing the changed text again, the blocks before and after them
+ * keep their symbols.
+ */
+void CodeEditor::onContentsChange(int position, int /*charsRemoved*/, int charsAdded)
+{
+    if (auto crossReferences {std::exchange(m_pendingCrossReferences, std::nullopt)};
+        crossReferences && crossReferences->lineCount() == static_cast<size_t>(blockCount()))
+    {
+        m_crossReferences = std::move(*crossReferences);
+        return;
+    }
+
+    QTextBlock first {document()->findBlock(position)};
+    QTextBlock last {document()->findBlock(position + charsAdded)};
+    if (!first.isValid())
+        first = document()->lastBlock();
+    if (!last.isValid())
+        last = document()->lastBlock();
+
+    const auto added {static_cast<size_t>(last.blockNumber() - first.blockNumber() + 1)};
+    const auto lineCount {m_crossReferences.lineCount() + added};
+    const auto removed {lineCount > static_cast<size_t>(blockCount()) ? lineCount - blockCount() : 0};
+    m_crossReferences.replaceLines(static_cast<size_t>(first.blockNumber()), removed, added);
+
+    Parser& parser {m_controller.parser()};
+    for (QTextBlock block {first}; block.isValid() && block.blockNumber() <= last.blockNumber(); block = block.next())
+    {
+        try
+        {
+            m_crossReferences.setLine(static_cast<size_t>(block.blockNumber()), parser.parse(block.text().toStdString()),
+                                      parser);
+        }
+        catch (const S840D_Alarm& /*alarm*/)
+        {
+            // the evaluation reports it, the line has no symbols until it is fixed
+        }
+    }
+}
+
+std::optional<CrossReferenceIndex::Symbol> CodeEditor::symbolUnderCursor() const
+{
+    QTextCursor cursor {textCursor()};
+    cursor.select(QTextCursor::WordUnderCursor);
+    return m_crossReferences.findSymbol(cursor.selectedText().toStdString());
+}
+
+void CodeEditor::goToDefinition()
+{
+    const auto symbol {symbolUnderCursor()};
+    if (!symbol)
+        return;
+    if (const auto line {m_crossReferences.definition(*symbol, static_cast<size_t>(textCursor().blockNumber()))})
+        moveCursorToBlock(*line);
+}
+
+void CodeEditor::findUsages()
+{
+    const auto symbol {symbolUnderCursor()};
+    if (!symbol)
+        return;
+
+    auto usageName = [](CrossReferenceIndex::Usage usage)
+    {
+        switch (usage)
+        {
+        case CrossReferenceIndex::Usage::Definition: return tr("definition");
+        case CrossReferenceIndex::Usage::Write: return tr("write");
+        case CrossReferenceIndex::Usage::Read: return tr("read");
+        case CrossReferenceIndex::Usage::ToolSelect: return tr("tool change");
+        case CrossReferenceIndex::Usage::Jump: return tr("jump");
+        }
+        return QString();
+    };
+
+    // one item per line, a menu with thousands of items is of no use
+    constexpr int maxItems {200};
+    const auto references {m_crossReferences.usages(*symbol)};
+    QMenu menu;
+    int lines {0};
+    for (size_t i {0}; i < references.size();)
+    {
+        const size_t line {references[i].line};
+        QStringList usages;
+        for (; i < references.size() && references[i].line == line; i++)
+        {
+            if (!usages.contains(usageName(references[i].usage)))
+                usages << usageName(references[i].usage);
+        }
+        if (++lines > maxItems)
+            continue;
+
+        const QTextBlock block {document()->findBlockByNumber(static_cast<int>(line))};
+        auto* action {menu.addAction(QStringLiteral("%1: %2 (%3)").arg(line + 1).arg(block.text().trimmed().left(80),
+                                                                                     usages.join(", ")))};
+        action->setData(static_cast<qulonglong>(line));
+    }
+    if (lines > maxItems)
+        menu.addAction(tr("%n more lines", nullptr, lines - maxItems))->setEnabled(false);
+
+    const QAction* chosen {menu.exec(viewport()->mapToGlobal(cursorRect().bottomLeft()))};
+    if (chosen && chosen->data().isValid())
+        moveCursorToBlock(chosen->data().toULongLong());
+}
+
+void CodeEditor::contextMenuEvent(QContextMenuEvent* event)
+{
+    // the symbol under the mouse, unless there is a selection
+    if (!textCursor().hasSelection())
+        setTextCursor(cursorForPosition(event->pos()));
+
+    QMenu* menu {createStandardContextMenu()};
+    menu->addSeparator();
+    menu->addAction(m_goToDefinitionAction);
+    menu->addAction(m_findUsagesAction);
+    menu->addSeparator();
+    menu->addAction(m_profileAction);
+    menu->addAction(m_continueEvaluationAction);
+    menu->exec(event->globalPos());
+    delete menu;
+}
+
+void CodeEditor::continueEvaluation()
+{
+    if (m_controller.canResume())
+        m_continueTimer->start(0);
+}
+
+void CodeEditor::setEvaluationDeferred(bool deferred)
+{
+    if (deferred == m_evaluationDeferred)
+        return;
+    m_evaluationDeferred = deferred;
+    if (deferred)
+    {
+        m_continuePending = m_continueTimer->isActive();
+        m_continueTimer->stop();
+    }
+    else if (m_evaluationPending)
+        onDocumentChange();
+    else if (std::exchange(m_continuePending, false))
+        continueEvaluation();
+}
+
+void CodeEditor::replot()
+{
+    plotMotions();
+}
+
+void CodeEditor::plotMotions()
+{
+    m_backplot.plot(m_motions);
+    m_plottedMotions = m_motions.items().size();
+}
+
+void CodeEditor::onEvaluationStop()
+{
+    // an endless loop would go on forever, the user has to continue again
+    if (m_controller.stopReason() != Controller::StopReason::Budget)
+        m_continueTimer->stop();
+    m_evaluationStop = m_controller.canResume() ? std::optional<size_t>(m_controller.stopBlock()) : std::nullopt;
+    m_continueEvaluationAction->setEnabled(m_evaluationStop.has_value() && !m_continueTimer->isActive());
+
+    const auto& profile {m_controller.profile()};
+    const auto hottest {std::max_element(profile.begin(), profile.end(), [](const auto& a, const auto& b) {
+        return a.nanoseconds < b.nanoseconds;
+    })};
+    m_profileMaxTime = hottest != profile.end() ? hottest->nanoseconds : 0;
+    lineNumberArea->update();
+}
+
+void CodeEditor::setProfiling(bool enabled)
+{
+    if (enabled == m_profiling)
+        return;
+    m_profiling = enabled;
+    m_profileAction->setChecked(enabled);
+    m_controller.setProfiling(enabled);
+    updateLineNumberAreaWidth();
+    onDocumentChange();
+    lineNumberArea->update();
 }
 
 void CodeEditor::onBlockCountChange()
@@ -55,36 +345,72 @@ void CodeEditor::onBlockCountChange()
 
 void CodeEditor::startPoint(const glm::dvec3& point)
 {
-    m_backplot.startTrajectory(glm::vec3(point));
+    m_motions.startPoint(point);
+    m_plottedMotions = 0;
+    m_cycleTime.startPoint(point);
+    if (m_recorder)
+        m_recorder->startPoint(point);
 }
 
 void CodeEditor::blockChange(size_t blockNumber)
 {
+    m_motions.blockChange(blockNumber);
+    m_cycleTime.blockChange(blockNumber);
+    if (m_recorder)
+        m_recorder->blockChange(blockNumber);
     m_currentBlockNumber = blockNumber;
     setLineColorHint(blockNumber, ColorHintType::NoMotion);
 }
 
 void CodeEditor::linearMotion(const LinearMotion& linearMotion)
 {
-    m_backplot.plot(linearMotion);
+    m_motions.linearMotion(linearMotion);
+    m_cycleTime.linearMotion(linearMotion);
+    if (m_recorder)
+        m_recorder->linearMotion(linearMotion);
     setLineColorHint(m_currentBlockNumber, linearMotion.getFeed() == 0 ? ColorHintType::RapidMotion : ColorHintType::LinearMotion);
 }
 
 void CodeEditor::circularMotion(const CircularMotion& circularMotion)
 {
-    m_backplot.plot(circularMotion);
+    m_motions.circularMotion(circularMotion);
+    m_cycleTime.circularMotion(circularMotion);
+    if (m_recorder)
+        m_recorder->circularMotion(circularMotion);
     setLineColorHint(m_currentBlockNumber, ColorHintType::CircularMotion);
 }
 
 void CodeEditor::helicalMotion(const HelicalMotion& helicalMotion)
 {
-    m_backplot.plot(helicalMotion);
+    m_motions.helicalMotion(helicalMotion);
+    m_cycleTime.helicalMotion(helicalMotion);
+    if (m_recorder)
+        m_recorder->helicalMotion(helicalMotion);
     setLineColorHint(m_currentBlockNumber, ColorHintType::CircularMotion);
 }
 
 void CodeEditor::endOfProgram()
 {
-    m_backplot.endTrajectory();
+    m_motions.endOfProgram();
+    // kept as long as the tab, while the backplot may release its copy
+    m_motions.shrinkToFit();
+    m_cycleTime.endOfProgram();
+    if (m_recorder)
+        m_recorder->endOfProgram();
+    plotMotions();
+    emit cycleTimeChanged(m_cycleTime.totalTime());
+}
+
+/**
+ * Plotting the motions so far after every continued slice would plot the beginning over and over,
+ * once they doubled the plotting takes as long as all the plotting before. Waiting for the user
+ * to continue, all of them are shown.
+ */
+void CodeEditor::evaluationPaused()
+{
+    if (!m_continueTimer->isActive() || m_motions.items().size() >= 2 * m_plottedMotions)
+        plotMotions();
+    emit cycleTimeChanged(m_cycleTime.totalTime());
 }
 
 
@@ -101,7 +427,7 @@ int CodeEditor::lineNumberAreaWidth()
     // at least space for 3 digits
     //digits = qMax(digits, 3);
     constexpr int padding = 4;
-    return padding + motionColorHintLineWidth +
+    return padding + motionColorHintLineWidth + (m_profiling ? profileHeatBarWidth + 1 : 0) +
             fontMetrics().horizontalAdvance('9') * digits;
 }
 
@@ -111,6 +437,15 @@ void CodeEditor::setLineColorHint(size_t lineNumber, ColorHintType colorHintType
         m_colorHints[lineNumber] = colorHintType;
 }
 
+void CodeEditor::moveCursorToBlock(size_t blockNumber)
+{
+    const QTextBlock block {document()->findBlockByNumber(static_cast<int>(blockNumber))};
+    if (!block.isValid())
+        return;
+    setTextCursor(QTextCursor(block));
+    centerCursor();
+}
+
 void CodeEditor::clearLineColorHints()
 {
     for (auto& colorHint : m_colorHints)
@@ -215,6 +550,30 @@ void CodeEditor::highlightCurrentLine()
     setExtraSelections(extraSelections);
 }
 
+QString CodeEditor::lineNumberAreaToolTip(int y) const
+{
+    const QTextBlock block {cursorForPosition(QPoint(0, y)).block()};
+    const auto& blockTimes {m_cycleTime.blockTimes()};
+    const auto& profile {m_controller.profile()};
+    const auto blockNumber {static_cast<size_t>(block.blockNumber())};
+    if (!block.isValid())
+        return QString();
+
+    QStringList lines;
+    if (m_evaluationStop == blockNumber)
+    {
+        lines << (m_controller.stopReason() == Controller::StopReason::JumpLimit ?
+                  tr("Evaluation stopped here after too many jumps, an endless loop?") :
+                  tr("Evaluation stopped here after %1 ms").arg(evaluationBudget.count()));
+    }
+    if (blockNumber < blockTimes.size() && blockTimes[blockNumber] > 0.0)
+        lines << tr("Block time: %1 s").arg(blockTimes[blockNumber], 0, 'f', 3);
+    if (blockNumber < profile.size() && profile[blockNumber].count > 0)
+        lines << tr("Evaluated %1 times in %2 ms").arg(profile[blockNumber].count)
+                 .arg(profile[blockNumber].nanoseconds / 1e6, 0, 'f', 3);
+    return lines.join('\n');
+}
+
 void CodeEditor::lineNumberAreaPaintEvent(QPaintEvent* event)
 {
     const QColor textColor {100, 100, 100};
@@ -224,6 +583,8 @@ void CodeEditor::lineNumberAreaPaintEvent(QPaintEvent* event)
     const QColor linearMotionColor {20, 170, 40};
     const QColor circularMotionColor {40, 180, 255};
     const QColor noMotionColor {0, 75, 175};
+    const QColor hotColor {255, 90, 0};
+    const QColor evaluationStopColor {220, 0, 0};
 
     QPainter painter(lineNumberArea);
     painter.fillRect(event->rect(), backgroundColor);
@@ -233,7 +594,13 @@ void CodeEditor::lineNumberAreaPaintEvent(QPaintEvent* event)
     int top = qRound(blockBoundingGeometry(block).translated(contentOffset()).top());
     int bottom = top + qRound(blockBoundingRect(block).height());
 
-    int textWidth = lineNumberArea->width() - motionColorHintLineWidth - 2;
+    const int motionColorHintX {lineNumberArea->width() - motionColorHintLineWidth - 1};
+    const int heatBarX {motionColorHintX - 1 - profileHeatBarWidth};
+    int textWidth = (m_profiling ? heatBarX : motionColorHintX) - 1;
+
+    // logarithmic, a few slow blocks would leave the others blank
+    const auto& profile {m_controller.profile()};
+    const double maxHeat {std::log1p(m_profileMaxTime / 1000.0)};
 
     painter.setFont(font());
     painter.setPen(textColor);
@@ -255,7 +622,19 @@ void CodeEditor::lineNumberAreaPaintEvent(QPaintEvent* event)
                 motionType == ColorHintType::NoMotion ? &noMotionColor :
                 nullptr};
             if (color)
-                painter.fillRect(textWidth + 1, top, motionColorHintLineWidth, fontHeight, *color);
+                painter.fillRect(motionColorHintX, top, motionColorHintLineWidth, fontHeight, *color);
+
+            const auto index {static_cast<size_t>(blockNumber)};
+            if (m_profiling && index < profile.size() && profile[index].count > 0 && maxHeat > 0.0)
+            {
+                const double heat {std::log1p(profile[index].nanoseconds / 1000.0) / maxHeat};
+                const QColor heatColor {QColor::fromRgbF(backgroundColor.redF() + heat * (hotColor.redF() - backgroundColor.redF()),
+                                                         backgroundColor.greenF() + heat * (hotColor.greenF() - backgroundColor.greenF()),
+                                                         backgroundColor.blueF() + heat * (hotColor.blueF() - backgroundColor.blueF()))};
+                painter.fillRect(heatBarX, top, profileHeatBarWidth, fontHeight, heatColor);
+            }
+            if (m_evaluationStop == index)
+                painter.fillRect(0, top, lineNumberArea->width(), 2, evaluationStopColor);
         }
 
         block = block.next();
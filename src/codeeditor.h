@@ -2,9 +2,18 @@
 #define CODEEDITOR_H
 
 #include "controller.h"
+#include "crossreferenceindex.h"
+#include "cycletimeestimator.h"
+#include "evaluationcache.h"
+#include "motionlist.h"
+#include "motionlog.h"
 
+#include <QHelpEvent>
 #include <QPlainTextEdit>
+#include <QToolTip>
 
+class QAction;
+class QTimer;
 class Highlighter;
 class BackplotWidget;
 
@@ -18,6 +27,10 @@ public:
 
     void lineNumberAreaPaintEvent(QPaintEvent* event);
     int lineNumberAreaWidth();
+    /**
+     * Machining time and profile of the block at y in the line number area, empty if it has none.
+     */
+    QString lineNumberAreaToolTip(int y) const;
 
     enum class ColorHintType
     {
@@ -28,9 +41,46 @@ public:
         NoMotion,
     };
 
+    /**
+     * The next evaluation of the unmodified document is loaded from or stored to the cache.
+     */
+    void setEvaluationCache(EvaluationCache* cache) noexcept;
+    /** of the document text, the same for evaluations of the text elsewhere */
+    static std::string evaluationCacheKey(const QString& text);
+    bool exportMotionLog(const QString& path) const;
+    /**
+     * The index of the text the document is set to next, built elsewhere, is taken instead of
+     * indexing all of its lines. Ignored if the line counts differ.
+     */
+    void setCrossReferences(CrossReferenceIndex crossReferences);
+
+    double cycleTime() const noexcept { return m_cycleTime.totalTime(); } // in seconds
+
     void setLineColorHint(size_t lineNumber, ColorHintType colorHintType);
+    void moveCursorToBlock(size_t blockNumber);
     void clearLineColorHints();
 
+    /** of the symbol under the cursor, like R17, T5, a label or a DEF variable */
+    void goToDefinition();
+    void findUsages();
+
+    /** Evaluates again measuring each block, shown as a heat bar in the line number area. */
+    void setProfiling(bool enabled);
+
+    /**
+     * Continues an evaluation stopped by its time budget or the jump limit, in slices between
+     * the events of the GUI. Edits start over.
+     */
+    void continueEvaluation();
+
+    /**
+     * While deferred, edits are evaluated once evaluation is no longer deferred, like in hidden
+     * tabs. A continued evaluation goes on then too.
+     */
+    void setEvaluationDeferred(bool deferred);
+    /** Plots the motions of the last evaluation again, after the backplot released its buffers. */
+    void replot();
+
     // ControllerListener interface
     void startPoint(const glm::dvec3& point) override;
     void blockChange(size_t blockNumber) override;
@@ -38,8 +88,13 @@ public:
     void circularMotion(const CircularMotion& circularMotion) override;
     void helicalMotion(const HelicalMotion& helicalMotion) override;
     void endOfProgram() override;
+    void evaluationPaused() override;
+
+signals:
+    void cycleTimeChanged(double seconds);
 
 protected:
+    void contextMenuEvent(QContextMenuEvent* event) override;
     void resizeEvent(QResizeEvent* event) override;
     void wheelEvent(QWheelEvent* event) override;
 
@@ -51,14 +106,38 @@ private slots:
 private:
     void onBlockCountChange();
     void onDocumentChange();
+    void onContentsChange(int position, int charsRemoved, int charsAdded);
+    void onEvaluationStop();
+    void plotMotions();
+    std::optional<CrossReferenceIndex::Symbol> symbolUnderCursor() const;
     BackplotWidget& m_backplot;
     QWidget* lineNumberArea;
     Highlighter* highlighter;
     QFontDatabase fontDatabase;
     static constexpr int motionColorHintLineWidth {3}; // in pixels
+    static constexpr int profileHeatBarWidth {4}; // in pixels
+    static constexpr std::chrono::milliseconds evaluationBudget {250}; // of a run or a continued slice
     std::vector<ColorHintType> m_colorHints;
     Controller m_controller;
+    MotionList m_motions; // columns of the last evaluation, the backplot is restored from them
+    size_t m_plottedMotions {0}; // of the motions so far, plotted again once they doubled
+    CycleTimeEstimator m_cycleTime;
+    EvaluationCache* m_evaluationCache {};
+    std::unique_ptr<MotionLogWriter> m_recorder;
     size_t m_currentBlockNumber {};
+    CrossReferenceIndex m_crossReferences;
+    std::optional<CrossReferenceIndex> m_pendingCrossReferences;
+    QAction* m_goToDefinitionAction;
+    QAction* m_findUsagesAction;
+    QAction* m_profileAction;
+    QAction* m_continueEvaluationAction;
+    QTimer* m_continueTimer;
+    std::optional<size_t> m_evaluationStop; // the block where the last slice stopped
+    bool m_evaluationDeferred {false};
+    bool m_evaluationPending {false};
+    bool m_continuePending {false};
+    bool m_profiling {false};
+    uint64_t m_profileMaxTime {0}; // in nanoseconds, the hottest block
 };
 
 
@@ -81,6 +160,24 @@ protected:
         m_editor->lineNumberAreaPaintEvent(event);
     }
 
+    bool event(QEvent* event) override
+    {
+        if (event->type() == QEvent::ToolTip)
+        {
+            auto helpEvent {static_cast<QHelpEvent*>(event)};
+            const QString text {m_editor->lineNumberAreaToolTip(helpEvent->pos().y())};
+            if (text.isEmpty())
+            {
+                QToolTip::hideText();
+                event->ignore();
+            }
+            else
+                QToolTip::showText(helpEvent->globalPos(), text, this);
+            return true;
+        }
+        return QWidget::event(event);
+    }
+
 private:
     CodeEditor* m_editor;
 };
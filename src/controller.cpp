@@ -1,5 +1,7 @@
 #include "controller.h"
 #include "motion.h"
+#include "motionlist.h"
+#include "parallel.h"
 #include "value.h"
 #include "util.h"
 #include "scopedtimer.h"
@@ -9,6 +11,8 @@
 
 #include <QString>
 
+#include <chrono>
+
 
 inline static bool equalsIgnoreCase(const std::string& a, const std::string& b)
 {
@@ -38,9 +42,25 @@ void Controller::setListener(ControllerListener* listener) noexcept
     m_listener = listener;
 }
 
+void Controller::setParallelEvaluation(bool enabled, std::size_t chunkSize) noexcept
+{
+    m_chunkSize = enabled ? std::max<std::size_t>(chunkSize, 1) : 0;
+}
+
+void Controller::setBudget(const Budget& budget) noexcept
+{
+    m_budget = budget;
+}
+
+void Controller::setProfiling(bool enabled) noexcept
+{
+    m_profiling = enabled;
+}
+
 void Controller::reset() noexcept
 {
     m_sourceBlocks.clear();
+    m_stopReason = StopReason::EndOfProgram;
     m_variables.clear();
     initVariables();
     m_defAllowed = true;
@@ -56,22 +76,31 @@ void Controller::addLine(const std::string& line)
     m_sourceBlocks.push_back(line);
 }
 
+Parser& Controller::parser()
+{
+    // created on first use, the controllers evaluating parallel chunks never parse
+    if (!m_parser)
+        m_parser = std::make_unique<Parser>();
+    return *m_parser;
+}
+
 void Controller::run()
 {
     {ScopedTimer t{"parsing"};
     // parse
-    m_parser.reset();
+    parser().reset();
     m_parsedBlocks.clear();
     m_parsedBlocks.reserve(m_sourceBlocks.size());
     for (auto& source : m_sourceBlocks)
     {
         try
         {
-            m_parsedBlocks.push_back(m_parser.parse(source));
+            m_parsedBlocks.push_back(m_parser->parse(source));
         }
         catch (const S840D_Alarm& alarm)
         {
-            std::cout << "Alarm: " << alarm.getAlarmCode() << std::endl;
+            if (m_listener)
+                m_listener->alarm(m_parsedBlocks.size(), alarm.getAlarmCode());
             break;
         }
     }
@@ -79,19 +108,97 @@ void Controller::run()
 
     {ScopedTimer t{"evaluation"};
 
+    findStraightLineRegions();
+    m_profile.assign(m_profiling ? m_parsedBlocks.size() : 0, BlockProfile{});
+
     gcodeResetValues();
     m_currentPointWCS = m_firstPoint;
     m_currentPointMCS = m_firstPoint;
     m_actFrame = Frame{};
+    m_feed = 0.0;
+    m_tool = 0;
+    m_toolName.clear();
+    m_toolEdge = 0;
 
     if (m_listener)
         m_listener->startPoint(m_currentPointWCS);
 
-    size_t jumpCount{0};
-    for (m_currentBlock = 0;
-         m_currentBlock < m_parsedBlocks.size();
-         )
+    m_currentBlock = 0;
+    m_sequentialEnd = 0;
+    m_jumpCount = 0;
+    evaluate();
+
+    }//ScopedTimer
+}
+
+void Controller::resume()
+{
+    if (!canResume())
+        return;
+    // budget slices count on, an endless loop stops at the limit however it is sliced
+    if (m_stopReason == StopReason::JumpLimit)
+        m_jumpCount = 0;
+    evaluate();
+}
+
+/**
+ * Evaluates from m_currentBlock until the program ends, an alarm, the jump limit or the
+ * budget, where m_currentBlock is left.
+ */
+void Controller::evaluate()
+{
+    // a clock read per block, only if asked for
+    using Clock = std::chrono::steady_clock;
+    auto addProfile = [this](std::size_t begin, std::size_t end, Clock::time_point start)
     {
+        const auto nanoseconds {static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count())};
+        for (std::size_t block {begin}; block < end; block++)
+        {
+            m_profile[block].count++;
+            m_profile[block].nanoseconds += nanoseconds / (end - begin);
+        }
+    };
+
+    const auto deadline {Clock::now() + m_budget.time};
+    size_t evaluatedBlocks{0};
+    size_t nextClockRead{64}; // in evaluated blocks
+    m_stopReason = StopReason::EndOfProgram;
+    while (m_currentBlock < m_parsedBlocks.size())
+    {
+        bool overBudget {m_budget.blocks > 0 && evaluatedBlocks >= m_budget.blocks};
+        if (m_budget.time.count() > 0 && evaluatedBlocks >= nextClockRead)
+        {
+            overBudget = overBudget || Clock::now() >= deadline;
+            nextClockRead = evaluatedBlocks + 64;
+        }
+        if (overBudget)
+        {
+            m_stopReason = StopReason::Budget;
+            break;
+        }
+
+        if (m_currentBlock >= m_sequentialEnd &&
+            m_currentBlock < m_straightLineEnd.size() &&
+            m_straightLineEnd[m_currentBlock] - m_currentBlock >= 2 * m_chunkSize)
+        {
+            // within a budget a window at a time, the next pass goes on with the region
+            std::size_t end {m_straightLineEnd[m_currentBlock]};
+            if (m_budget.blocks > 0)
+                end = std::min(end, m_currentBlock + std::max(m_budget.blocks - evaluatedBlocks, 2 * m_chunkSize));
+            if (m_budget.time.count() > 0)
+                end = std::min(end, m_currentBlock + chunksPerWindow * m_chunkSize);
+
+            const std::size_t begin {m_currentBlock};
+            const auto start {m_profiling ? Clock::now() : Clock::time_point{}};
+            m_currentBlock = evaluateStraightLine(m_currentBlock, end, &m_sequentialEnd);
+            if (m_profiling)
+                addProfile(begin, m_currentBlock, start);
+            evaluatedBlocks += m_currentBlock - begin;
+            continue;
+        }
+
+        const auto start {m_profiling ? Clock::now() : Clock::time_point{}};
         if (m_listener)
             m_listener->blockChange(m_currentBlock);
 
@@ -104,35 +211,51 @@ void Controller::run()
         }
         catch (const S840D_Alarm& alarm)
         {
-            std::cout << "Alarm: " << alarm.getAlarmCode() << std::endl;
+            if (m_listener)
+                m_listener->alarm(m_currentBlock, alarm.getAlarmCode());
+            m_stopReason = StopReason::Alarm;
             break;
         }
         catch (const std::exception& e)
         {
-            std::cout << "evaluation failed: exception " << e.what() << std::endl;
+            std::cerr << "evaluation failed: exception " << e.what() << std::endl;
         }
         catch (...)
         {
-            std::cout << "evaluation failed: unknown error" << std::endl;
+            std::cerr << "evaluation failed: unknown error" << std::endl;
         }
+        if (m_profiling)
+            addProfile(m_currentBlock, m_currentBlock + 1, start);
+        evaluatedBlocks++;
         if (m_nextBlock == END_OF_PROGRAM)
             break;
 
         if (m_nextBlock != UNSET)
         {
             m_currentBlock = m_nextBlock;
-            jumpCount++;
-            // infinite loop protection
-            if (jumpCount > m_maxJumpCount)
-                break; // TODO warn user
+            m_jumpCount++;
+            // infinite loop protection, resuming after the limit starts counting again
+            if (m_jumpCount > m_maxJumpCount)
+            {
+                m_stopReason = StopReason::JumpLimit;
+                break;
+            }
         }
         else
             m_currentBlock++;
     }
-    if (m_listener)
+    // the blocks after a parse alarm are missing
+    if (m_stopReason == StopReason::EndOfProgram && m_currentBlock == m_parsedBlocks.size() &&
+        m_parsedBlocks.size() < m_sourceBlocks.size())
+        m_stopReason = StopReason::Alarm;
+
+    if (!m_listener)
+        return;
+    // listeners keep their look-ahead for the rest of the program
+    if (m_stopReason == StopReason::Budget)
+        m_listener->evaluationPaused();
+    else
         m_listener->endOfProgram();
-
-    }//ScopedTimer
 }
 
 bool Controller::handleGCodeGroup1(GCommands& gCommands, int gcode)
@@ -299,7 +422,7 @@ bool Controller::handleGCodeGroup15(GCommands& gCommands, int gcode)
     return false;
 }
 
-void Controller::visit(AddressAssign& addressAssign)
+void Controller::visit(const AddressAssign& addressAssign)
 {
     // TODO check if non-default addressAssign.m_coordType is allowed
 
@@ -403,16 +526,33 @@ void Controller::visit(AddressAssign& addressAssign)
         auto value {assignCastInt(addressAssign.m_expr->evaluate(m_variables))};
         m_currentBlockState.intAddr[addressAssign.m_address] = value;
     }
+    else if (equalsIgnoreCase(addressAssign.m_address, "T"))
+    {
+        if (m_currentBlockState.intAddr.count("T") || m_currentBlockState.toolName)
+            throw S840D_Alarm{12010};
+        // tool management selects tools by name
+        Value value {addressAssign.m_expr->evaluate(m_variables)};
+        if (const auto* name = std::get_if<s840d_string_t>(&value))
+            m_currentBlockState.toolName = *name;
+        else
+            m_currentBlockState.intAddr["T"] = assignCastInt(value);
+    }
+    else if (equalsIgnoreCase(addressAssign.m_address, "D"))
+    {
+        if (m_currentBlockState.intAddr.count("D"))
+            throw S840D_Alarm{12010};
+        m_currentBlockState.intAddr["D"] = assignCastInt(addressAssign.m_expr->evaluate(m_variables));
+    }
 }
 
-void Controller::visit(LValueAssign& lvalueAssign)
+void Controller::visit(const LValueAssign& lvalueAssign)
 {
     lvalueAssign.m_lvalueExpr->setValue(
         lvalueAssign.m_expr->evaluate(m_variables),
         m_variables);
 }
 
-void Controller::visit(ExtAddressAssign& extAddressAssign)
+void Controller::visit(const ExtAddressAssign& extAddressAssign)
 {
     if (equalsIgnoreCase(extAddressAssign.m_address, "G"))
     {
@@ -438,7 +578,7 @@ void Controller::visit(ExtAddressAssign& extAddressAssign)
     }
 }
 
-void Controller::visit(GCommand& func)
+void Controller::visit(const GCommand& func)
 {
     auto group3 = [](GCommands& gCommands, g_group_3 gGroupCode)
     {
@@ -509,7 +649,7 @@ void Controller::visit(GCommand& func)
 #undef COMMAND
 }
 
-void Controller::visit(GotoStmt& gotoStmt)
+void Controller::visit(const GotoStmt& gotoStmt)
 {
     const Value target {gotoStmt.m_expr->evaluate(m_variables)};
     if (getValueType(target) != ValueType::STRING)
@@ -518,13 +658,19 @@ void Controller::visit(GotoStmt& gotoStmt)
     const std::string targetStr {std::get<s840d_string_t>(target)};
     const bool isBlockNum {isdigit(targetStr[0]) != 0};
 
-    std::function<bool(NCProgramBlock&)> blockNumberCondition = [&targetStr](NCProgramBlock& block)
+    // no block can match a number or label the parser hasn't seen
+    const auto blockNumber {isBlockNum ? m_parser->findBlockNumber(targetStr) : std::nullopt};
+    const auto label {isBlockNum ? std::nullopt : m_parser->findName(targetStr)};
+    std::function<bool(NCProgramBlock&)> blockNumberCondition = [&blockNumber](NCProgramBlock& block)
     {
-        return block.blockNumber.m_number == targetStr;
+        return blockNumber.has_value() &&
+               block.blockNumber.m_type != BlockNumber::None &&
+               block.blockNumber.m_number == blockNumber->m_number &&
+               block.blockNumber.m_interned == blockNumber->m_interned;
     };
-    std::function<bool(NCProgramBlock&)> labelCondition = [&targetStr](NCProgramBlock& block)
+    std::function<bool(NCProgramBlock&)> labelCondition = [&label](NCProgramBlock& block)
     {
-        return block.label == targetStr;
+        return label.has_value() && block.label == label.value();
     };
     auto searchCondition = isBlockNum ? blockNumberCondition : labelCondition;
 
@@ -554,22 +700,22 @@ void Controller::visit(GotoStmt& gotoStmt)
         throw S840D_Alarm{14080};//destination not found
 }
 
-void Controller::visit(ConditionalGotoStmt& gotoStmt)
+void Controller::visit(const ConditionalGotoStmt& gotoStmt)
 {
-    ConditionalGotoStmt* stmt = &gotoStmt;
+    const ConditionalGotoStmt* stmt = &gotoStmt;
     do
     {
         Value condition {stmt->m_conditionExpr->evaluate(m_variables)};
         if (std::get<s840d_bool_t>(condition)) //TODO convert to bool?
         {
-            stmt->m_gotoStmt->accept(*this);
+            visit(*stmt->m_gotoStmt);
             break;
         }
     }
     while ((stmt = stmt->m_next.get()) != nullptr);
 }
 
-void Controller::visit(ForStmt& forStmt)
+void Controller::visit(const ForStmt& forStmt)
 {
     if (m_endforJump)
     {
@@ -586,7 +732,7 @@ void Controller::visit(ForStmt& forStmt)
     else
     {
         // Assign initial value to the loop counter (only before first iteration)
-        forStmt.m_assignment->accept(*this);
+        visit(*forStmt.m_assignment);
     }
 
     // Evaluate loop condition
@@ -601,7 +747,7 @@ void Controller::visit(ForStmt& forStmt)
         auto searchCondition = [=](NCProgramBlock& block)
         {
             return block.blockContent.size() == 1 &&
-                   dynamic_cast<EndForStmt*>(block.blockContent[0]) &&
+                   std::holds_alternative<EndForStmt>(block.blockContent[0]) &&
                    block.nestingLevel == level;
         };
 
@@ -612,13 +758,13 @@ void Controller::visit(ForStmt& forStmt)
     }
 }
 
-void Controller::visit(EndForStmt& /*endForStmt*/)
+void Controller::visit(const EndForStmt& /*endForStmt*/)
 {
     int level = m_parsedBlocks[m_currentBlock].nestingLevel;
     auto searchCondition = [=](NCProgramBlock& block)
     {
         return block.blockContent.size() == 1 &&
-               dynamic_cast<ForStmt*>(block.blockContent[0]) &&
+               std::holds_alternative<ForStmt>(block.blockContent[0]) &&
                block.nestingLevel == level;
     };
 
@@ -631,7 +777,7 @@ void Controller::visit(EndForStmt& /*endForStmt*/)
         throw S840D_Alarm{12640}; //invalid nesting of control structures
 }
 
-void Controller::visit(IfStmt& ifStmt)
+void Controller::visit(const IfStmt& ifStmt)
 {
     Value condition {ifStmt.m_expr->evaluate(m_variables)};
     if (!std::get<s840d_bool_t>(condition))
@@ -640,8 +786,8 @@ void Controller::visit(IfStmt& ifStmt)
         auto searchCondition = [=](NCProgramBlock& block)
         {
             return block.blockContent.size() == 1 &&
-                   (dynamic_cast<ElseStmt*>(block.blockContent[0]) ||
-                    dynamic_cast<EndIfStmt*>(block.blockContent[0])) &&
+                   (std::holds_alternative<ElseStmt>(block.blockContent[0]) ||
+                    std::holds_alternative<EndIfStmt>(block.blockContent[0])) &&
                    block.nestingLevel == level;
         };
         if (auto index {blockSearchFwd(searchCondition)})
@@ -654,13 +800,13 @@ void Controller::visit(IfStmt& ifStmt)
     }
 }
 
-void Controller::visit(ElseStmt& /*elseStmt*/)
+void Controller::visit(const ElseStmt& /*elseStmt*/)
 {
     int level = m_parsedBlocks[m_currentBlock].nestingLevel;
     auto searchCondition = [=](NCProgramBlock& block)
     {
         return block.blockContent.size() == 1 &&
-               dynamic_cast<EndIfStmt*>(block.blockContent[0]) &&
+               std::holds_alternative<EndIfStmt>(block.blockContent[0]) &&
                block.nestingLevel == level;
     };
     if (auto index {blockSearchFwd(searchCondition)})
@@ -672,12 +818,12 @@ void Controller::visit(ElseStmt& /*elseStmt*/)
         throw S840D_Alarm{12640}; //invalid nesting of control structures
 }
 
-void Controller::visit(EndIfStmt& /*endIfStmt*/)
+void Controller::visit(const EndIfStmt& /*endIfStmt*/)
 {
     // ENDIF serves the only purpose - it is a branch target
 }
 
-void Controller::visit(DefStmt& defStmt)
+void Controller::visit(const DefStmt& defStmt)
 {
     auto resultHandler = [](Variables::DefineResult result) {
         switch (result)
@@ -746,8 +892,8 @@ void Controller::evaluateBlock(NCProgramBlock& block)
             throw S840D_Alarm{14500}; // illegal DEF or PROC instruction in the part program
     }
 
-    for (auto content : block.blockContent)
-        content->accept(*this);
+    for (const auto& content : block.blockContent)
+        std::visit([this](const auto& c) { visit(c); }, content);
 
     int gGroup1 = m_currentBlockState.gCommands.group1 != g_group_1::UNDEF;
     int gGroup2 = m_currentBlockState.gCommands.group2 != g_group_2::UNDEF;
@@ -758,6 +904,28 @@ void Controller::evaluateBlock(NCProgramBlock& block)
 
     copyDefinedModalGFunctions(m_currentBlockState.gCommands, m_gCommands);
 
+    auto tool {m_currentBlockState.intAddr.find("T")};
+    auto toolEdge {m_currentBlockState.intAddr.find("D")};
+    if (tool != m_currentBlockState.intAddr.end() || toolEdge != m_currentBlockState.intAddr.end() ||
+        m_currentBlockState.toolName)
+    {
+        if (tool != m_currentBlockState.intAddr.end())
+        {
+            m_tool = tool->second;
+            m_toolName.clear();
+        }
+        else if (m_currentBlockState.toolName)
+        {
+            m_tool = 0;
+            m_toolName = *m_currentBlockState.toolName;
+        }
+        if (toolEdge != m_currentBlockState.intAddr.end())
+            m_toolEdge = toolEdge->second;
+        // listeners know tools by number, a tool selected by name is tool 0 to them
+        if (m_listener)
+            m_listener->toolChange(m_tool, m_toolEdge);
+    }
+
     if (m_currentBlockState.gCommands.group3 != g_group_3::UNDEF)
     {
         switch (m_currentBlockState.gCommands.group3)
@@ -925,7 +1093,284 @@ void Controller::evaluateBlock(NCProgramBlock& block)
 
 bool Controller::isDefSectionBlock(const NCProgramBlock& block) const noexcept
 {
-    return block.blockContent.size() == 1 && dynamic_cast<DefStmt*>(block.blockContent.front());
+    return block.blockContent.size() == 1 && std::holds_alternative<DefStmt>(block.blockContent.front());
+}
+
+bool Controller::isStraightLineBlock(const NCProgramBlock& block) const
+{
+    // only literal address words, so the block neither reads nor writes variables,
+    // does not jump and does not change the frame
+    for (const auto& content : block.blockContent)
+    {
+        const auto* addressAssign {std::get_if<AddressAssign>(&content)};
+        if (!addressAssign)
+            return false;
+
+        const Expr* expr {addressAssign->m_expr.get()};
+        if (auto unary = dynamic_cast<const UnaryOpExpr*>(expr); unary && unary->m_op == UnaryOpExpr::UMINUS)
+            expr = unary->m_arg.get();
+        const auto* literal {dynamic_cast<const LiteralExpr*>(expr)};
+        if (!literal)
+            return false;
+
+        // tool changes are reported to the listener, which chunk evaluation does not record
+        if (equalsIgnoreCase(addressAssign->m_address, "T") || equalsIgnoreCase(addressAssign->m_address, "D"))
+            return false;
+
+        if (equalsIgnoreCase(addressAssign->m_address, "M"))
+        {
+            try
+            {
+                auto mcode {assignCastInt(literal->m_value)};
+                if (mcode == 2 || mcode == 17 || mcode == 30)
+                    return false;
+            }
+            catch (...)
+            {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+void Controller::findStraightLineRegions()
+{
+    m_straightLineEnd.clear();
+    if (m_chunkSize == 0)
+        return;
+
+    m_straightLineEnd.resize(m_parsedBlocks.size());
+    std::size_t end {m_parsedBlocks.size()};
+    for (std::size_t i {m_parsedBlocks.size()}; i-- > 0; )
+    {
+        if (!isStraightLineBlock(m_parsedBlocks[i]))
+            end = i;
+        m_straightLineEnd[i] = end;
+    }
+}
+
+void Controller::decodeStraightLineBlock(const NCProgramBlock& block, StraightLineBlock& data)
+{
+    m_currentBlockState = {};
+    for (const auto& content : block.blockContent)
+        visit(std::get<AddressAssign>(content));
+
+    data.gCommands = m_currentBlockState.gCommands;
+    data.xyz = m_currentBlockState.xyz;
+    if (auto it = m_currentBlockState.realAddr.find("F"); it != m_currentBlockState.realAddr.end())
+        data.feed = it->second;
+    else
+        data.feed.reset();
+    data.hasArcData = m_currentBlockState.ijk.hasAnyValue() ||
+            (m_currentBlockState.realAddr.count("CR") && m_currentBlockState.xyz.hasAnyValue());
+}
+
+/**
+ * Evaluates the straight-line blocks [begin, end) in chunks of m_chunkSize blocks.
+ *
+ * The chunk-entry modal state is an exclusive scan over the per-chunk merge of the
+ * block G functions and feeds, both computed in parallel. The chunk-entry positions
+ * are a scan over the decoded blocks, replaying the same operations as evaluateBlock
+ * so the result is bit-identical to the sequential evaluation. The chunks are then
+ * evaluated in parallel and their recorded motions are reported in order.
+ *
+ * Returns the block to continue with. If a block could not be evaluated in parallel,
+ * *sequentialEnd is set behind it and the evaluation continues before it sequentially,
+ * which reports the error the same way as without parallel evaluation.
+ */
+std::size_t Controller::evaluateStraightLine(std::size_t begin, std::size_t end, std::size_t* sequentialEnd)
+{
+    const std::size_t noFailure {std::numeric_limits<std::size_t>::max()};
+
+    while (m_chunkControllers.size() < chunksPerWindow)
+        m_chunkControllers.push_back(std::make_unique<Controller>());
+    for (auto& controller : m_chunkControllers)
+    {
+        controller->m_axisConfig = m_axisConfig;
+        controller->m_arcTolerance = m_arcTolerance;
+        controller->m_actFrame = m_actFrame;
+        controller->m_defAllowed = false;
+    }
+
+    const glm::dmat4 actTransform {m_actFrame.toMat()};
+    const glm::dmat4 actTransformInv {glm::inverse(actTransform)};
+    m_defAllowed = false;
+
+    std::vector<StraightLineBlock> blocks;
+    std::vector<ChunkState> chunks;
+    std::vector<std::size_t> failures;
+    std::vector<MotionList> motions(chunksPerWindow);
+
+    for (std::size_t windowBegin {begin}; windowBegin < end; )
+    {
+        std::size_t windowEnd {std::min(end, windowBegin + chunksPerWindow * m_chunkSize)};
+        auto chunkCount = [&] { return (windowEnd - windowBegin + m_chunkSize - 1) / m_chunkSize; };
+        auto chunkBegin = [&](std::size_t chunk) { return windowBegin + chunk * m_chunkSize; };
+        auto chunkEnd = [&](std::size_t chunk) { return std::min(windowEnd, chunkBegin(chunk + 1)); };
+
+        // decode the blocks and merge the modal state of each chunk
+        blocks.resize(windowEnd - windowBegin);
+        chunks.assign(chunkCount() + 1, ChunkState{});
+        failures.assign(chunkCount(), noFailure);
+        parallelFor(chunkCount(), 1, [&](std::size_t first, std::size_t last)
+        {
+            for (auto chunk {first}; chunk < last; chunk++)
+            {
+                Controller& controller {*m_chunkControllers[chunk]};
+                ChunkState& merged {chunks[chunk + 1]};
+                merged.feed = 0.0;
+                for (auto i {chunkBegin(chunk)}; i < chunkEnd(chunk); i++)
+                {
+                    StraightLineBlock& data {blocks[i - windowBegin]};
+                    try
+                    {
+                        controller.decodeStraightLineBlock(m_parsedBlocks[i], data);
+                    }
+                    catch (...)
+                    {
+                        failures[chunk] = i;
+                        break;
+                    }
+                    copyDefinedModalGFunctions(data.gCommands, merged.gCommands);
+                    if (data.feed)
+                        merged.feed = *data.feed;
+                }
+            }
+        });
+
+        // blocks behind a decoding error may depend on its evaluation
+        std::size_t failure {*std::min_element(failures.begin(), failures.end())};
+        if (failure != noFailure)
+        {
+            windowEnd = failure;
+            if (windowEnd == windowBegin)
+            {
+                *sequentialEnd = failure + 1;
+                return failure;
+            }
+            chunks.resize(chunkCount() + 1);
+        }
+
+        // exclusive scan of the modal state
+        chunks[0] = {m_gCommands, m_feed, m_currentPointMCS};
+        for (std::size_t chunk {1}; chunk <= chunkCount(); chunk++)
+        {
+            GCommands gCommands {chunks[chunk - 1].gCommands};
+            copyDefinedModalGFunctions(chunks[chunk].gCommands, gCommands);
+            chunks[chunk].gCommands = gCommands;
+            if (chunks[chunk].feed == 0.0)
+                chunks[chunk].feed = chunks[chunk - 1].feed;
+        }
+
+        // resolve which blocks move and how their coordinates apply
+        parallelFor(chunkCount(), 1, [&](std::size_t first, std::size_t last)
+        {
+            for (auto chunk {first}; chunk < last; chunk++)
+            {
+                GCommands gCommands {chunks[chunk].gCommands};
+                for (auto i {chunkBegin(chunk)}; i < chunkEnd(chunk); i++)
+                {
+                    StraightLineBlock& data {blocks[i - windowBegin]};
+                    copyDefinedModalGFunctions(data.gCommands, gCommands);
+                    data.isMotion = gCommands.group1 != g_group_1::UNDEF &&
+                            (((gCommands.group1 == g_group_1::G0 || gCommands.group1 == g_group_1::G1 || gCommands.group1 == g_group_1::CIP) &&
+                              data.xyz.hasAnyValue()) ||
+                             ((gCommands.group1 == g_group_1::G2 || gCommands.group1 == g_group_1::G3) &&
+                              data.hasArcData));
+                    data.coordType = gCommands.group14 == g_group_14::G90 ? AddressAssign::AC : AddressAssign::IC;
+                }
+            }
+        });
+
+        // scan of the positions, same operations as in evaluateBlock
+        glm::dvec3 pointMCS {m_currentPointMCS};
+        for (std::size_t chunk {0}; chunk < chunkCount(); chunk++)
+        {
+            chunks[chunk].pointMCS = pointMCS;
+            for (auto i {chunkBegin(chunk)}; i < chunkEnd(chunk); i++)
+            {
+                const StraightLineBlock& data {blocks[i - windowBegin]};
+                if (data.isMotion)
+                {
+                    glm::dvec3 pointWCS = actTransformInv * glm::dvec4(pointMCS, 1.0);
+                    data.xyz.set_dvec3(pointWCS, data.coordType);
+                    pointMCS = actTransform * glm::dvec4(pointWCS, 1.0);
+                }
+            }
+        }
+
+        // evaluate the chunks
+        failures.assign(chunkCount(), noFailure);
+        parallelFor(chunkCount(), 1, [&](std::size_t first, std::size_t last)
+        {
+            for (auto chunk {first}; chunk < last; chunk++)
+            {
+                Controller& controller {*m_chunkControllers[chunk]};
+                controller.m_gCommands = chunks[chunk].gCommands;
+                controller.m_feed = chunks[chunk].feed;
+                controller.m_currentPointMCS = chunks[chunk].pointMCS;
+                controller.m_currentPointWCS = actTransformInv * glm::dvec4(chunks[chunk].pointMCS, 1.0);
+                controller.m_listener = &motions[chunk];
+                motions[chunk].clear();
+                for (auto i {chunkBegin(chunk)}; i < chunkEnd(chunk); i++)
+                {
+                    motions[chunk].blockChange(i);
+                    controller.m_nextBlock = UNSET;
+                    try
+                    {
+                        controller.evaluateBlock(m_parsedBlocks[i]);
+                    }
+                    catch (...)
+                    {
+                        failures[chunk] = i;
+                        break;
+                    }
+                }
+            }
+        });
+
+        // report the chunks in order, up to the first failing one
+        for (std::size_t chunk {0}; chunk < chunkCount(); chunk++)
+        {
+            if (failures[chunk] != noFailure)
+            {
+                m_gCommands = chunks[chunk].gCommands;
+                m_feed = chunks[chunk].feed;
+                m_currentPointMCS = chunks[chunk].pointMCS;
+                m_currentPointWCS = actTransformInv * glm::dvec4(m_currentPointMCS, 1.0);
+                *sequentialEnd = failures[chunk] + 1;
+                return chunkBegin(chunk);
+            }
+
+            const auto& items {motions[chunk].items()};
+            size_t item {0};
+            for (auto i {chunkBegin(chunk)}; i < chunkEnd(chunk); i++)
+            {
+                if (m_listener)
+                    m_listener->blockChange(i);
+                for (; item < items.size() && items[item].blockNumber == i; ++item)
+                {
+                    if (m_listener)
+                        motions[chunk].replay(item, *m_listener);
+                }
+            }
+        }
+
+        const Controller& last {*m_chunkControllers[chunkCount() - 1]};
+        m_gCommands = last.m_gCommands;
+        m_feed = last.m_feed;
+        m_currentPointMCS = last.m_currentPointMCS;
+        m_currentPointWCS = last.m_currentPointWCS;
+
+        if (failure != noFailure)
+        {
+            *sequentialEnd = failure + 1;
+            return failure;
+        }
+        windowBegin = windowEnd;
+    }
+    return end;
 }
 
 void Controller::gcodeResetValues()
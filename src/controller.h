@@ -13,6 +13,8 @@
 #include <glm/gtc/matrix_transform.hpp>
 
 #include <array>
+#include <chrono>
+#include <cstdint>
 #include <optional>
 #include <vector>
 #include <memory>
@@ -29,13 +31,23 @@ public:
     virtual void linearMotion(const LinearMotion& linearMotion) = 0;
     virtual void circularMotion(const CircularMotion& circularMotion) = 0;
     virtual void helicalMotion(const HelicalMotion& helicalMotion) = 0;
+    /** The evaluation ended, also when stopped by an alarm or the jump limit. */
     virtual void endOfProgram() = 0;
+    /** The budget stopped a run or resume, the motions so far were reported, optional. */
+    virtual void evaluationPaused() {}
+    /** The alarm stopped parsing or evaluation at the block, optional. */
+    virtual void alarm(size_t /*blockNumber*/, int /*alarmCode*/) {}
+    /**
+     * T or D selected a tool or cutting edge, before the motion of the block, optional.
+     * A tool selected by name is reported as tool 0.
+     */
+    virtual void toolChange(int /*tool*/, int /*edge*/) {}
 };
 
 /**
  * Represents a S840D controller.
  */
-class Controller : public BlockContentVisitor
+class Controller
 {
 public:
     Controller() noexcept;
@@ -47,24 +59,71 @@ public:
     Controller& operator=(Controller&&) = delete;
 
     void setListener(ControllerListener* listener) noexcept;
+    void setParallelEvaluation(bool enabled, std::size_t chunkSize = defaultChunkSize) noexcept;
+    /** Measures the evaluation of each block in the next runs, off by default. */
+    void setProfiling(bool enabled) noexcept;
     void addLine(const QString& line);
     void addLine(const std::string& line);
     void reset() noexcept;
     void run();
 
-    // BlockContentVisitor interface
-    void visit(AddressAssign& addressAssign) override;
-    void visit(LValueAssign& lvalueAssign) override;
-    void visit(ExtAddressAssign& extAddressAssign) override;
-    void visit(GCommand& func) override;
-    void visit(GotoStmt& gotoStmt) override;
-    void visit(ConditionalGotoStmt& gotoStmt) override;
-    void visit(ForStmt& forStmt) override;
-    void visit(EndForStmt& /*endForStmt*/) override;
-    void visit(IfStmt& ifStmt) override;
-    void visit(ElseStmt& /*elseStmt*/) override;
-    void visit(EndIfStmt& /*endIfStmt*/) override;
-    void visit(DefStmt& defStmt) override;
+    /** Limits each run or resume, zero is unlimited. */
+    struct Budget
+    {
+        std::chrono::milliseconds time {0};
+        std::size_t blocks {0}; // evaluated blocks, loops count each pass, a block moves once at most
+    };
+    void setBudget(const Budget& budget) noexcept;
+
+    enum class StopReason
+    {
+        EndOfProgram,
+        Alarm,
+        JumpLimit, // likely an endless loop
+        Budget
+    };
+    /**
+     * Why the last run or resume stopped, the listener's evaluationPaused is called for the budget
+     * and endOfProgram otherwise. Stopped at stopBlock(), where resume() continues.
+     */
+    StopReason stopReason() const noexcept { return m_stopReason; }
+    std::size_t stopBlock() const noexcept { return m_currentBlock; }
+    bool canResume() const noexcept { return m_stopReason == StopReason::JumpLimit || m_stopReason == StopReason::Budget; }
+    /** Continues the evaluation with a new budget, the listener gets the following motions. */
+    void resume();
+
+    /** The parser is created on first use, it is also used for syntax highlighting. */
+    Parser& parser();
+
+    struct BlockProfile
+    {
+        uint64_t count {0}; // evaluations, loops evaluate blocks repeatedly
+        uint64_t nanoseconds {0}; // including the listener
+    };
+    /**
+     * By block index, of the last run with profiling, else empty. Blocks of parallel evaluated
+     * straight-line regions share the region's time.
+     */
+    const std::vector<BlockProfile>& profile() const noexcept { return m_profile; }
+
+    // block content evaluation
+    void visit(const AddressAssign& addressAssign);
+    void visit(const LValueAssign& lvalueAssign);
+    void visit(const ExtAddressAssign& extAddressAssign);
+    void visit(const GCommand& func);
+    void visit(const GotoStmt& gotoStmt);
+    void visit(const ConditionalGotoStmt& gotoStmt);
+    void visit(const ForStmt& forStmt);
+    void visit(const EndForStmt& /*endForStmt*/);
+    void visit(const IfStmt& ifStmt);
+    void visit(const ElseStmt& /*elseStmt*/);
+    void visit(const EndIfStmt& /*endIfStmt*/);
+    void visit(const DefStmt& defStmt);
+
+    static constexpr std::size_t defaultChunkSize {1024};
+
+    /** Changes whenever parsing or evaluation results change, invalidates cached evaluations. */
+    static constexpr unsigned evaluationVersion {2};
 
 private:
     struct GCommands
@@ -203,6 +262,7 @@ private:
         std::map<std::string, CoordValue> coordAddr;
         std::map<std::string, s840d_real_t> realAddr;
         std::map<std::string, s840d_int_t> intAddr;
+        std::optional<s840d_string_t> toolName; // T="name"
         GCommands gCommands = {};
     };
 
@@ -288,8 +348,36 @@ private:
 
 
 
+    /**
+     * Per-block data needed to scan a straight-line region without evaluating it.
+     */
+    struct StraightLineBlock
+    {
+        GCommands gCommands;
+        CoordVector xyz;
+        std::optional<double> feed;
+        bool hasArcData;
+        bool isMotion;
+        AddressAssign::CoordType coordType;
+    };
+
+    /**
+     * Modal state at the entry of a chunk of a straight-line region.
+     */
+    struct ChunkState
+    {
+        GCommands gCommands;
+        double feed;
+        glm::dvec3 pointMCS;
+    };
+
     void initVariables();
+    void evaluate();
     void evaluateBlock(NCProgramBlock& block);
+    bool isStraightLineBlock(const NCProgramBlock& block) const;
+    void findStraightLineRegions();
+    void decodeStraightLineBlock(const NCProgramBlock& block, StraightLineBlock& data);
+    std::size_t evaluateStraightLine(std::size_t begin, std::size_t end, std::size_t* sequentialEnd);
     bool isDefSectionBlock(const NCProgramBlock& block) const noexcept;
     void gcodeResetValues();
 
@@ -319,7 +407,21 @@ private:
     Variables m_variables;
     std::vector<std::string> m_sourceBlocks;
     std::vector<NCProgramBlock> m_parsedBlocks;
-    Parser m_parser;
+    std::unique_ptr<Parser> m_parser;
+
+    // parallel evaluation of straight-line regions, disabled if m_chunkSize is 0
+    std::size_t m_chunkSize {0};
+    static constexpr std::size_t chunksPerWindow {64}; // evaluated in parallel at a time
+    std::vector<std::size_t> m_straightLineEnd;
+    std::vector<std::unique_ptr<Controller>> m_chunkControllers;
+
+    Budget m_budget;
+    StopReason m_stopReason {StopReason::EndOfProgram};
+    std::size_t m_sequentialEnd {0}; // of the parallel evaluated straight-line region
+    std::size_t m_jumpCount {0}; // since the run or the resume after the jump limit
+
+    bool m_profiling {false};
+    std::vector<BlockProfile> m_profile;
 
     glm::dvec3 m_firstPoint {0.0};//for now
     glm::dvec3 m_currentPointWCS {m_firstPoint};
@@ -343,6 +445,9 @@ private:
 
     // current settings
     double m_feed {0.0};
+    int m_tool {0};
+    s840d_string_t m_toolName; // of the tool selected by name, then m_tool is 0
+    int m_toolEdge {0};
     double m_arcTolerance {0.015};
 
     bool m_defAllowed {true};
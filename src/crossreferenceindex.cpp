@@ -0,0 +1,323 @@
+#include "crossreferenceindex.h"
+#include "parser.h"
+#include "util.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <variant>
+
+void CrossReferenceIndex::clear() noexcept
+{
+    m_entries.clear();
+    m_freeEntries.clear();
+    m_lineEntries.clear();
+    m_occurrences.clear();
+}
+
+std::string CrossReferenceIndex::key(SymbolKind kind, const std::string& name)
+{
+    return static_cast<char>('0' + static_cast<int>(kind)) + name;
+}
+
+void CrossReferenceIndex::replaceLines(std::size_t first, std::size_t removed, std::size_t added)
+{
+    first = std::min(first, m_lineEntries.size());
+    removed = std::min(removed, m_lineEntries.size() - first);
+
+    for (std::size_t line {first}; line < first + removed; line++)
+    {
+        clearLine(line);
+        m_freeEntries.push_back(m_lineEntries[line]);
+    }
+
+    std::vector<uint32_t> entries(added);
+    for (auto& entry : entries)
+    {
+        if (!m_freeEntries.empty())
+        {
+            entry = m_freeEntries.back();
+            m_freeEntries.pop_back();
+        }
+        else
+        {
+            entry = static_cast<uint32_t>(m_entries.size());
+            m_entries.emplace_back();
+        }
+    }
+    const auto begin {m_lineEntries.begin() + static_cast<std::ptrdiff_t>(first)};
+    m_lineEntries.insert(m_lineEntries.erase(begin, begin + static_cast<std::ptrdiff_t>(removed)),
+                         entries.begin(), entries.end());
+
+    const std::size_t end {removed == added ? first + added : m_lineEntries.size()};
+    for (std::size_t line {first}; line < end; line++)
+        m_entries[m_lineEntries[line]].line = line;
+}
+
+void CrossReferenceIndex::clearLine(std::size_t line)
+{
+    if (line >= m_lineEntries.size())
+        return;
+
+    auto& references {m_entries[m_lineEntries[line]].references};
+    for (const auto& reference : references)
+    {
+        auto it {m_occurrences.find(reference.key)};
+        if (it == m_occurrences.end())
+            continue;
+        // the last occurrence takes the slot, possibly one of this line not cleared yet
+        auto& occurrences {it->second};
+        const Occurrence moved {occurrences.back()};
+        occurrences[reference.slot] = moved;
+        m_entries[moved.entry].references[moved.reference].slot = reference.slot;
+        occurrences.pop_back();
+        if (occurrences.empty())
+            m_occurrences.erase(it);
+    }
+    references.clear();
+}
+
+namespace
+{
+
+/**
+ * Collects the symbols of the block contents, in order.
+ */
+struct SymbolCollector
+{
+    using SymbolKind = CrossReferenceIndex::SymbolKind;
+    using Usage = CrossReferenceIndex::Usage;
+
+    std::vector<std::pair<CrossReferenceIndex::Symbol, Usage>> symbols;
+
+    void add(SymbolKind kind, std::string name, Usage usage)
+    {
+        if (!name.empty())
+            symbols.push_back({{kind, std::move(name)}, usage});
+    }
+
+    /** integral numbers without a fraction, strings as they are */
+    static std::string literalText(const Expr* expr)
+    {
+        const auto* literal {dynamic_cast<const LiteralExpr*>(expr)};
+        if (!literal)
+            return {};
+        if (const auto* i = std::get_if<s840d_int_t>(&literal->m_value))
+            return std::to_string(*i);
+        if (const auto* r = std::get_if<s840d_real_t>(&literal->m_value))
+        {
+            if (std::trunc(*r) == *r && std::abs(*r) < 1e9)
+                return std::to_string(static_cast<long long>(*r));
+        }
+        if (const auto* s = std::get_if<s840d_string_t>(&literal->m_value))
+            return *s;
+        return {};
+    }
+
+    void variable(const Expr* expr, Usage usage)
+    {
+        if (const auto* variableExpr = dynamic_cast<const VariableExpr*>(expr))
+        {
+            add(SymbolKind::Variable, to_upper_copy(variableExpr->m_varName), usage);
+        }
+        else if (const auto* arrayExpr = dynamic_cast<const ArrayExpr*>(expr))
+        {
+            const std::string name {to_upper_copy(arrayExpr->m_varName)};
+            const std::string index {arrayExpr->m_indicies.size() == 1 ? literalText(arrayExpr->m_indicies[0])
+                                                                         : std::string{}};
+            // R[R1] may be any R parameter
+            if (name == "R" && !index.empty())
+                add(SymbolKind::RParameter, index, usage);
+            else
+                add(SymbolKind::Variable, name, usage);
+            for (const auto* indexExpr : arrayExpr->m_indicies)
+                read(indexExpr);
+        }
+    }
+
+    void read(const Expr* expr)
+    {
+        if (!expr)
+            return;
+        if (dynamic_cast<const LValueExpr*>(expr))
+            variable(expr, Usage::Read);
+        else if (const auto* binary = dynamic_cast<const BinaryOpExpr*>(expr))
+        {
+            read(binary->m_lhs.get());
+            read(binary->m_rhs.get());
+        }
+        else if (const auto* unary = dynamic_cast<const UnaryOpExpr*>(expr))
+            read(unary->m_arg.get());
+        else if (const auto* func1 = dynamic_cast<const ArithmeticFunc1ArgExpr*>(expr))
+            read(func1->m_arg.get());
+        else if (const auto* func2 = dynamic_cast<const ArithmeticFunc2ArgExpr*>(expr))
+        {
+            read(func2->m_arg1.get());
+            read(func2->m_arg2.get());
+        }
+    }
+
+    void operator()(const AddressAssign& addressAssign)
+    {
+        const std::string tool {addressAssign.m_address == "T" || addressAssign.m_address == "t"
+                                ? literalText(addressAssign.m_expr.get()) : std::string{}};
+        if (!tool.empty())
+            add(SymbolKind::Tool, tool, Usage::ToolSelect);
+        else
+            read(addressAssign.m_expr.get());
+    }
+    void operator()(const LValueAssign& lvalueAssign)
+    {
+        variable(lvalueAssign.m_lvalueExpr.get(), Usage::Write);
+        read(lvalueAssign.m_expr.get());
+    }
+    void operator()(const ExtAddressAssign& extAddressAssign)
+    {
+        read(extAddressAssign.m_ext.get());
+        read(extAddressAssign.m_expr.get());
+    }
+    void operator()(const GotoStmt& gotoStmt)
+    {
+        // the parser turns the target into a string, computed targets are only read
+        const auto* literal {dynamic_cast<const LiteralExpr*>(gotoStmt.m_expr.get())};
+        const auto* target {literal ? std::get_if<s840d_string_t>(&literal->m_value) : nullptr};
+        if (!target || target->empty())
+            read(gotoStmt.m_expr.get());
+        else if (std::isdigit(static_cast<unsigned char>((*target)[0])))
+            add(SymbolKind::BlockNumber, *target, Usage::Jump);
+        else
+            add(SymbolKind::Label, *target, Usage::Jump);
+    }
+    void operator()(const ConditionalGotoStmt& gotoStmt)
+    {
+        for (const auto* stmt {&gotoStmt}; stmt; stmt = stmt->m_next.get())
+        {
+            read(stmt->m_conditionExpr.get());
+            (*this)(*stmt->m_gotoStmt);
+        }
+    }
+    void operator()(const ForStmt& forStmt)
+    {
+        (*this)(*forStmt.m_assignment);
+        read(forStmt.m_expr.get());
+    }
+    void operator()(const IfStmt& ifStmt)
+    {
+        read(ifStmt.m_expr.get());
+    }
+    void operator()(const DefStmt& defStmt)
+    {
+        for (const auto& def : defStmt.m_defs)
+            add(SymbolKind::Variable, to_upper_copy(def.varName), Usage::Definition);
+        for (const auto& arrayDef : defStmt.m_arrayDefs)
+            add(SymbolKind::Variable, to_upper_copy(arrayDef.varName), Usage::Definition);
+    }
+    void operator()(const GCommand& /*gCommand*/) {}
+    void operator()(const EndForStmt& /*endForStmt*/) {}
+    void operator()(const ElseStmt& /*elseStmt*/) {}
+    void operator()(const EndIfStmt& /*endIfStmt*/) {}
+};
+
+}
+
+void CrossReferenceIndex::setLine(std::size_t line, const NCProgramBlock& block, const Parser& parser)
+{
+    if (line >= m_lineEntries.size())
+        return;
+    clearLine(line);
+
+    SymbolCollector collector;
+    if (block.blockNumber.m_type != BlockNumber::None)
+    {
+        collector.add(SymbolKind::BlockNumber, block.blockNumber.m_interned ? parser.name(block.blockNumber.m_number)
+                                                                            : std::to_string(block.blockNumber.m_number),
+                      Usage::Definition);
+    }
+    if (block.label != NCProgramBlock::noLabel)
+        collector.add(SymbolKind::Label, parser.name(block.label), Usage::Definition);
+    for (const auto& content : block.blockContent)
+        std::visit(collector, content);
+
+    const uint32_t entryIndex {m_lineEntries[line]};
+    auto& references {m_entries[entryIndex].references};
+    for (auto& [symbol, usage] : collector.symbols)
+    {
+        std::string symbolKey {key(symbol.kind, symbol.name)};
+        auto& occurrences {m_occurrences[symbolKey]};
+        occurrences.push_back({entryIndex, static_cast<uint32_t>(references.size()), usage});
+        references.push_back({std::move(symbolKey), usage, static_cast<uint32_t>(occurrences.size() - 1)});
+    }
+}
+
+std::vector<CrossReferenceIndex::Reference> CrossReferenceIndex::usages(const Symbol& symbol) const
+{
+    std::vector<Reference> references;
+    auto it {m_occurrences.find(key(symbol.kind, symbol.name))};
+    if (it == m_occurrences.end())
+        return references;
+
+    // the occurrences are unordered, within a line the references of the entry are in block order
+    std::vector<std::pair<Reference, uint32_t>> ordered;
+    ordered.reserve(it->second.size());
+    for (const auto& occurrence : it->second)
+        ordered.push_back({{m_entries[occurrence.entry].line, occurrence.usage}, occurrence.reference});
+    std::sort(ordered.begin(), ordered.end(), [](const auto& a, const auto& b) {
+        return a.first.line != b.first.line ? a.first.line < b.first.line : a.second < b.second;
+    });
+    references.reserve(ordered.size());
+    for (const auto& [reference, order] : ordered)
+        references.push_back(reference);
+    return references;
+}
+
+std::optional<std::size_t> CrossReferenceIndex::definition(const Symbol& symbol, std::size_t line) const
+{
+    std::optional<std::size_t> forward;
+    std::optional<std::size_t> backward;
+    auto it {m_occurrences.find(key(symbol.kind, symbol.name))};
+    if (it == m_occurrences.end())
+        return std::nullopt;
+
+    for (const auto& occurrence : it->second)
+    {
+        if (occurrence.usage != Usage::Definition)
+            continue;
+        const std::size_t definitionLine {m_entries[occurrence.entry].line};
+        if (definitionLine > line)
+        {
+            if (!forward || definitionLine < *forward)
+                forward = definitionLine;
+        }
+        else if (!backward || definitionLine > *backward)
+            backward = definitionLine;
+    }
+    return forward ? forward : backward;
+}
+
+std::optional<CrossReferenceIndex::Symbol> CrossReferenceIndex::findSymbol(const std::string& word) const
+{
+    auto indexed = [this](SymbolKind kind, const std::string& name) -> std::optional<Symbol>
+    {
+        if (m_occurrences.count(key(kind, name)) == 0)
+            return std::nullopt;
+        return Symbol {kind, name};
+    };
+
+    const std::string upper {to_upper_copy(word)};
+    const bool addressWord {upper.size() > 1 && std::all_of(upper.begin() + 1, upper.end(),
+                                                            [](unsigned char c) { return std::isdigit(c); })};
+    // without leading zeros like the parsed numbers
+    auto number = [&upper]() { return std::to_string(std::stoll(upper.substr(1))); };
+    if (addressWord && upper.size() <= 10 && upper[0] == 'R')
+        return indexed(SymbolKind::RParameter, number());
+    if (addressWord && upper.size() <= 10 && upper[0] == 'T')
+        return indexed(SymbolKind::Tool, number());
+    if (addressWord && upper[0] == 'N')
+        return indexed(SymbolKind::BlockNumber, upper.substr(1));
+    if (!word.empty() && std::all_of(word.begin(), word.end(), [](unsigned char c) { return std::isdigit(c); }))
+        return indexed(SymbolKind::BlockNumber, word);
+
+    if (auto label {indexed(SymbolKind::Label, word)})
+        return label;
+    return indexed(SymbolKind::Variable, upper);
+}
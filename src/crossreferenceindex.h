@@ -0,0 +1,119 @@
+#ifndef CROSSREFERENCEINDEX_H
+#define CROSSREFERENCEINDEX_H
+
+#include "ncprogramblock.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+class Parser;
+
+/**
+ * Maps the symbols of a program (R parameters, variables, tools, labels and block numbers)
+ * to the lines using them, built from the parsed blocks. Edits replace a range of lines,
+ * only the changed lines are indexed again.
+ */
+class CrossReferenceIndex
+{
+public:
+    enum class SymbolKind : uint8_t
+    {
+        RParameter,     // name is the number, "17" for R17
+        Variable,       // DEF and system variables, upper case
+        Tool,           // T number or name
+        Label,
+        BlockNumber     // name is the digits
+    };
+
+    enum class Usage : uint8_t
+    {
+        Definition,     // DEF, label or block number of the line
+        Write,
+        Read,
+        ToolSelect,
+        Jump
+    };
+
+    struct Symbol
+    {
+        SymbolKind kind;
+        std::string name;
+
+        bool operator==(const Symbol& other) const noexcept
+        {
+            return kind == other.kind && name == other.name;
+        }
+    };
+
+    struct Reference
+    {
+        std::size_t line;
+        Usage usage;
+    };
+
+    std::size_t lineCount() const noexcept { return m_lineEntries.size(); }
+    void clear() noexcept;
+
+    /**
+     * Replaces removed lines from first on with added lines without symbols,
+     * which are then indexed by setLine.
+     */
+    void replaceLines(std::size_t first, std::size_t removed, std::size_t added);
+
+    /**
+     * Indexes the line from its parsed block, the parser resolves the names of labels.
+     */
+    void setLine(std::size_t line, const NCProgramBlock& block, const Parser& parser);
+
+    /** for lines which cannot be parsed */
+    void clearLine(std::size_t line);
+
+    /** sorted by line, the usages within a line in block order */
+    std::vector<Reference> usages(const Symbol& symbol) const;
+
+    /**
+     * The line defining the symbol, the nearest after line or else the nearest up to line,
+     * like GOTO searches. R parameters and tools have none.
+     */
+    std::optional<std::size_t> definition(const Symbol& symbol, std::size_t line = 0) const;
+
+    /**
+     * The indexed symbol a word of the program text refers to, like "R17", "T5", "N100",
+     * a label or a variable.
+     */
+    std::optional<Symbol> findSymbol(const std::string& word) const;
+
+private:
+    static std::string key(SymbolKind kind, const std::string& name);
+
+    struct EntryReference
+    {
+        std::string key;
+        Usage usage;
+        uint32_t slot; // in the occurrences of the key
+    };
+    struct Entry
+    {
+        std::vector<EntryReference> references; // in block order
+        std::size_t line;
+    };
+    struct Occurrence
+    {
+        uint32_t entry;
+        uint32_t reference; // in the references of the entry
+        Usage usage;
+    };
+    std::vector<Entry> m_entries;
+    std::vector<uint32_t> m_freeEntries;
+    // entries are kept while lines move, so an edit touches the symbols of the changed lines only
+    std::vector<uint32_t> m_lineEntries;
+    // unordered, each occurrence knows its slot, so clearing a line takes constant time per symbol
+    std::unordered_map<std::string, std::vector<Occurrence>> m_occurrences;
+};
+
+#endif // CROSSREFERENCEINDEX_H
@@ -0,0 +1,230 @@
+#include "cycletimeestimator.h"
+#include "geometry.h"
+#include "motion.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+static constexpr double minLength {1e-9};
+
+CycleTimeEstimator::CycleTimeEstimator()
+    : CycleTimeEstimator(MachineLimits{})
+{
+}
+
+CycleTimeEstimator::CycleTimeEstimator(const MachineLimits& limits)
+    : m_limits(limits)
+{
+}
+
+void CycleTimeEstimator::clear() noexcept
+{
+    m_window.clear();
+    m_committedExit = 0.0;
+    m_position = glm::dvec3{0.0};
+    m_lastDirection = glm::dvec3{0.0};
+    m_lastMaxVelocity = 0.0;
+    m_currentBlock = 0;
+    m_blockTimes.clear();
+    m_totalTime = 0.0;
+}
+
+void CycleTimeEstimator::startPoint(const glm::dvec3& point)
+{
+    clear();
+    m_position = point;
+}
+
+void CycleTimeEstimator::blockChange(size_t blockNumber)
+{
+    m_currentBlock = blockNumber;
+    if (m_blockTimes.size() <= blockNumber)
+        m_blockTimes.resize(blockNumber + 1, 0.0);
+}
+
+void CycleTimeEstimator::linearMotion(const LinearMotion& linearMotion)
+{
+    const glm::dvec3 delta {linearMotion.getEndPoint() - m_position};
+    m_position = linearMotion.getEndPoint();
+    const double length {glm::length(delta)};
+    if (length < minLength)
+        return;
+
+    const glm::dvec3 direction {delta / length};
+    const double axisVelocity {axisLimit(m_limits.maxVelocity, direction) / 60.0};
+    const double feed {linearMotion.getFeed() / 60.0};
+    addSegment(length, feed > 0.0 ? std::min(feed, axisVelocity) : axisVelocity, direction, direction,
+               axisLimit(m_limits.maxAcceleration, direction), axisLimit(m_limits.maxJerk, direction));
+}
+
+void CycleTimeEstimator::circularMotion(const CircularMotion& circularMotion)
+{
+    const DirectedArc3& arc {circularMotion.getArc()};
+    addArc(arc.arc2, arc.transform, arc.z, arc.z, 0, circularMotion.getFeed());
+}
+
+void CycleTimeEstimator::helicalMotion(const HelicalMotion& helicalMotion)
+{
+    const Helix& helix {helicalMotion.getHelix()};
+    addArc(helix.arc2, helix.transform, helix.zStart, helix.zEnd, helix.turn, helicalMotion.getFeed());
+}
+
+void CycleTimeEstimator::endOfProgram()
+{
+    while (!m_window.empty())
+        commitFront();
+}
+
+/**
+ * The direction changes along the arc, so the lowest axis limits apply.
+ */
+void CycleTimeEstimator::addArc(const DirectedArc2& arc2, const glm::dmat4& transform, double zStart, double zEnd,
+                                unsigned turn, double feed)
+{
+    m_position = transform * glm::dvec4(arc2.point2, zEnd, 1.0);
+
+    const double radius {glm::length(arc2.point1 - arc2.center)};
+    const double sweep {std::abs(DirectedArc2Sampler{arc2}.angle()) + turn * 2.0 * glm::pi<double>()};
+    const double planarLength {radius * sweep};
+    const double height {zEnd - zStart};
+    const double length {std::hypot(planarLength, height)};
+    if (length < minLength)
+        return;
+
+    auto tangent = [&](const glm::dvec2& point)
+    {
+        const glm::dvec2 r {point - arc2.center};
+        const glm::dvec2 t {arc2.dir == DirectedArc2::cclw ? glm::dvec2(-r.y, r.x) : glm::dvec2(r.y, -r.x)};
+        const double tLength {glm::length(t)};
+        const glm::dvec2 planar {tLength > 0.0 ? t / tLength * (planarLength / length) : glm::dvec2(0.0)};
+        return glm::normalize(glm::dvec3(transform * glm::dvec4(planar, height / length, 0.0)));
+    };
+
+    const double acceleration {std::min({m_limits.maxAcceleration.x, m_limits.maxAcceleration.y, m_limits.maxAcceleration.z})};
+    const double jerk {std::min({m_limits.maxJerk.x, m_limits.maxJerk.y, m_limits.maxJerk.z})};
+    double maxVelocity {std::min({m_limits.maxVelocity.x, m_limits.maxVelocity.y, m_limits.maxVelocity.z}) / 60.0};
+    if (feed > 0.0)
+        maxVelocity = std::min(maxVelocity, feed / 60.0);
+    // centripetal acceleration v² / r
+    if (radius > 0.0)
+        maxVelocity = std::min(maxVelocity, std::sqrt(acceleration * radius));
+    addSegment(length, maxVelocity, tangent(arc2.point1), tangent(arc2.point2), acceleration, jerk);
+}
+
+void CycleTimeEstimator::addSegment(double length, double maxVelocity, const glm::dvec3& entryDirection,
+                                    const glm::dvec3& exitDirection, double acceleration, double jerk)
+{
+    // junction velocity from the allowed deviation of a circle touching both directions
+    double maxEntry {0.0};
+    if (m_lastMaxVelocity > 0.0)
+    {
+        const double limit {std::min(m_lastMaxVelocity, maxVelocity)};
+        const double cosTheta {-glm::dot(m_lastDirection, entryDirection)};
+        if (cosTheta < -0.999999)
+        {
+            maxEntry = limit;
+        }
+        else if (cosTheta < 0.999999)
+        {
+            const double sinHalfTheta {std::sqrt(0.5 * (1.0 - cosTheta))};
+            maxEntry = std::min(limit, std::sqrt(acceleration * m_limits.cornerDeviation * sinHalfTheta /
+                                                 (1.0 - sinHalfTheta)));
+        }
+    }
+    m_lastDirection = exitDirection;
+    m_lastMaxVelocity = maxVelocity;
+
+    // the window ends with a stop
+    m_window.push_back({m_currentBlock, length, maxVelocity, maxEntry,
+                        std::min(maxEntry, std::sqrt(2.0 * acceleration * length)), acceleration, jerk});
+
+    // appending only raises the entries, the pass ends at the first one that doesn't change
+    for (size_t i {m_window.size() - 1}; i-- > 0;)
+    {
+        Segment& segment {m_window[i]};
+        const double nextEntry {m_window[i + 1].entry};
+        const double entry {std::min(segment.maxEntry,
+                                     std::sqrt(nextEntry * nextEntry + 2.0 * segment.acceleration * segment.length))};
+        if (entry == segment.entry)
+            break;
+        segment.entry = entry;
+    }
+
+    if (m_window.size() > m_limits.lookAhead)
+        commitFront();
+}
+
+/**
+ * Fixes the velocities of the oldest segment in the window and adds its time.
+ */
+void CycleTimeEstimator::commitFront()
+{
+    const Segment segment {m_window.front()};
+    m_window.pop_front();
+
+    const double entry {m_committedExit};
+    const double nextEntry {m_window.empty() ? 0.0 : m_window.front().entry};
+    const double exit {std::min(nextEntry, std::sqrt(entry * entry + 2.0 * segment.acceleration * segment.length))};
+    m_committedExit = exit;
+
+    const double time {segmentTime(segment, entry, exit)};
+    if (m_blockTimes.size() <= segment.block)
+        m_blockTimes.resize(segment.block + 1, 0.0);
+    m_blockTimes[segment.block] += time;
+    m_totalTime += time;
+}
+
+double CycleTimeEstimator::axisLimit(const glm::dvec3& limits, const glm::dvec3& direction) const
+{
+    double limit {std::numeric_limits<double>::max()};
+    for (int k {0}; k < 3; k++)
+    {
+        if (std::abs(direction[k]) > 1e-12)
+            limit = std::min(limit, limits[k] / std::abs(direction[k]));
+    }
+    return limit;
+}
+
+/**
+ * Time of a jerk-limited velocity change, the acceleration ramps up and down with the jerk.
+ */
+static double accelerationTime(double deltaVelocity, double acceleration, double jerk)
+{
+    return deltaVelocity >= acceleration * acceleration / jerk ? deltaVelocity / acceleration + acceleration / jerk
+                                                                : 2.0 * std::sqrt(deltaVelocity / jerk);
+}
+
+double CycleTimeEstimator::segmentTime(const Segment& segment, double entry, double exit) const
+{
+    const double a {segment.acceleration};
+    const double j {segment.jerk};
+    // the S-curve is symmetric, its mean velocity is the mean of start and end velocity
+    auto distance = [entry, exit, a, j](double peak)
+    {
+        return (entry + peak) * 0.5 * accelerationTime(peak - entry, a, j) +
+               (peak + exit) * 0.5 * accelerationTime(peak - exit, a, j);
+    };
+
+    double peak {segment.maxVelocity};
+    if (distance(peak) > segment.length)
+    {
+        double low {std::max(entry, exit)};
+        double high {peak};
+        if (distance(low) > segment.length)
+        {
+            // the plan assumed constant acceleration, the S-curve needs more distance
+            return segment.length / std::max((entry + exit) * 0.5, 1e-9);
+        }
+        for (int i {0}; i < 24; i++)
+        {
+            const double middle {(low + high) * 0.5};
+            (distance(middle) > segment.length ? high : low) = middle;
+        }
+        peak = low;
+    }
+
+    const double cruise {segment.length - distance(peak)};
+    return accelerationTime(peak - entry, a, j) + accelerationTime(peak - exit, a, j) +
+           (peak > 0.0 ? cruise / peak : 0.0);
+}
@@ -0,0 +1,78 @@
+#ifndef CYCLETIMEESTIMATOR_H
+#define CYCLETIMEESTIMATOR_H
+
+#include "controller.h"
+#include "geometry.h"
+
+#include <glm/mat4x4.hpp>
+#include <glm/vec3.hpp>
+
+#include <deque>
+#include <vector>
+
+/**
+ * Estimates the machining time of a program run from its motions. Velocities are planned over a
+ * bounded look-ahead window of motions like the controller does, limited by the feed, the axis
+ * velocities, accelerations and jerks, the corner deviation and the centripetal acceleration on arcs.
+ * Acceleration phases are jerk-limited S-curves. Feeds are taken as mm/min.
+ */
+class CycleTimeEstimator : public ControllerListener
+{
+public:
+    struct MachineLimits
+    {
+        glm::dvec3 maxVelocity {30000.0};     // in mm/min, also the rapid feed
+        glm::dvec3 maxAcceleration {2000.0};  // in mm/s²
+        glm::dvec3 maxJerk {50000.0};         // in mm/s³
+        double cornerDeviation {0.02};        // in mm, allowed deviation at corners
+        std::size_t lookAhead {64};           // motions
+    };
+
+    CycleTimeEstimator();
+    explicit CycleTimeEstimator(const MachineLimits& limits);
+
+    void clear() noexcept;
+    double totalTime() const noexcept { return m_totalTime; } // in seconds
+    // machining time of each block in seconds, blocks without motion have 0
+    const std::vector<double>& blockTimes() const noexcept { return m_blockTimes; }
+
+    // ControllerListener interface
+    void startPoint(const glm::dvec3& point) override;
+    void blockChange(size_t blockNumber) override;
+    void linearMotion(const LinearMotion& linearMotion) override;
+    void circularMotion(const CircularMotion& circularMotion) override;
+    void helicalMotion(const HelicalMotion& helicalMotion) override;
+    void endOfProgram() override;
+
+private:
+    struct Segment
+    {
+        size_t block;
+        double length;
+        double maxVelocity;   // in mm/s
+        double maxEntry;      // at the junction with the previous segment
+        double entry;         // planned entry velocity, assuming a stop at the end of the window
+        double acceleration;
+        double jerk;
+    };
+
+    void addArc(const DirectedArc2& arc2, const glm::dmat4& transform, double zStart, double zEnd, unsigned turn,
+                double feed);
+    void addSegment(double length, double maxVelocity, const glm::dvec3& entryDirection,
+                    const glm::dvec3& exitDirection, double acceleration, double jerk);
+    void commitFront();
+    double axisLimit(const glm::dvec3& limits, const glm::dvec3& direction) const;
+    double segmentTime(const Segment& segment, double entry, double exit) const;
+
+    MachineLimits m_limits;
+    std::deque<Segment> m_window;
+    double m_committedExit {0.0}; // entry velocity of the front segment
+    glm::dvec3 m_position {0.0};
+    glm::dvec3 m_lastDirection {0.0};
+    double m_lastMaxVelocity {0.0};
+    size_t m_currentBlock {};
+    std::vector<double> m_blockTimes;
+    double m_totalTime {0.0};
+};
+
+#endif // CYCLETIMEESTIMATOR_H
@@ -1,18 +1,62 @@
 #include "documentview.h"
 #include "codeeditor.h"
 #include "backplotwidget.h"
+#include "playbackbar.h"
 
+#include <QHideEvent>
+#include <QShowEvent>
 #include <QTextBlock>
+#include <QTimer>
+#include <QVBoxLayout>
 
 
-DocumentView::DocumentView(const QString& text, QWidget* parent)
+DocumentView::DocumentView(const QString& text, EvaluationCache* cache,
+                           std::optional<CrossReferenceIndex> crossReferences, QWidget* parent)
     : QSplitter(parent),
       m_backplotWidget(new BackplotWidget),
-      m_codeEditor(new CodeEditor(*m_backplotWidget))
+      m_codeEditor(new CodeEditor(*m_backplotWidget)),
+      m_playbackBar(new PlaybackBar),
+      m_idleTimer(new QTimer(this))
 {
+    auto* backplotPane {new QWidget};
+    auto* layout {new QVBoxLayout(backplotPane)};
+    layout->setContentsMargins(0, 0, 0, 0);
+    layout->setSpacing(0);
+    layout->addWidget(m_backplotWidget, 1);
+    layout->addWidget(m_playbackBar);
+
     addWidget(m_codeEditor);
-    addWidget(m_backplotWidget);
+    addWidget(backplotPane);
+
+    connect(m_backplotWidget, &BackplotWidget::blockPicked, this, [this](size_t blockNumber)
+    {
+        m_codeEditor->moveCursorToBlock(blockNumber);
+        m_codeEditor->setFocus();
+    });
+    connect(m_backplotWidget, &BackplotWidget::durationChanged, this, [this](double seconds)
+    {
+        // a new plot or released buffers, the block of the old one means nothing
+        m_playbackBlock.reset();
+        m_playbackBar->setDuration(seconds);
+    });
+    connect(m_playbackBar, &PlaybackBar::positionChanged, this, [this](double seconds)
+    {
+        // follow the tool in the editor, but only move the cursor when the block changes
+        const auto blockNumber {m_backplotWidget->setPlaybackTime(seconds)};
+        if (blockNumber && blockNumber != m_playbackBlock)
+            m_codeEditor->moveCursorToBlock(*blockNumber);
+        m_playbackBlock = blockNumber;
+    });
+
+    m_idleTimer->setSingleShot(true);
+    m_idleTimer->setInterval(idleReleaseTimeout);
+    connect(m_idleTimer, &QTimer::timeout, m_backplotWidget, &BackplotWidget::releaseBuffers);
 
+    // evaluated when shown, views opened at once don't evaluate all
+    m_codeEditor->setEvaluationDeferred(!text.isEmpty());
+    m_codeEditor->setEvaluationCache(cache);
+    if (crossReferences)
+        m_codeEditor->setCrossReferences(std::move(*crossReferences));
     document()->setPlainText(text);
     document()->setModified(false);
 }
@@ -22,5 +66,33 @@ QTextDocument* DocumentView::document() const
     return m_codeEditor->document();
 }
 
+void DocumentView::showEvent(QShowEvent* event)
+{
+    // switching tabs, not minimizing the window
+    if (event->spontaneous())
+    {
+        QSplitter::showEvent(event);
+        return;
+    }
+    m_idleTimer->stop();
+    m_codeEditor->setEvaluationDeferred(false);
+    // the motions of the editor are the compact copy of the plot
+    if (m_backplotWidget->buffersReleased())
+        m_codeEditor->replot();
+    QSplitter::showEvent(event);
+}
+
+void DocumentView::hideEvent(QHideEvent* event)
+{
+    if (event->spontaneous())
+    {
+        QSplitter::hideEvent(event);
+        return;
+    }
+    m_codeEditor->setEvaluationDeferred(true);
+    m_idleTimer->start();
+    QSplitter::hideEvent(event);
+}
+
 
 
@@ -2,21 +2,28 @@
 #define DOCUMENTVIEW_H
 
 #include "controller.h"
+#include "crossreferenceindex.h"
 
 #include <QSplitter>
 #include <QString>
 
 #include <memory>
+#include <optional>
 
 class CodeEditor;
 class BackplotWidget;
+class PlaybackBar;
+class EvaluationCache;
 class QTextDocument;
+class QTimer;
 
 class DocumentView : public QSplitter
 {
     Q_OBJECT
 public:
-    explicit DocumentView(const QString& text, QWidget* parent = nullptr);
+    /** The cross references of the text are indexed unless given. */
+    explicit DocumentView(const QString& text, EvaluationCache* cache = nullptr,
+                          std::optional<CrossReferenceIndex> crossReferences = std::nullopt, QWidget* parent = nullptr);
 
     CodeEditor* editor() const { return m_codeEditor; }
     BackplotWidget* backplot() const { return m_backplotWidget; }
@@ -26,9 +33,19 @@ public:
 
     QTextDocument* document() const;
 
+    /** hidden views release the backplot's buffers after this */
+    static constexpr int idleReleaseTimeout {60000}; // in milliseconds
+
+protected:
+    void showEvent(QShowEvent* event) override;
+    void hideEvent(QHideEvent* event) override;
+
 private:
     BackplotWidget* m_backplotWidget;
     CodeEditor* m_codeEditor;
+    PlaybackBar* m_playbackBar;
+    std::optional<size_t> m_playbackBlock;
+    QTimer* m_idleTimer;
     QString m_path;
 };
 
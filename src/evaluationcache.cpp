@@ -0,0 +1,110 @@
+#include "evaluationcache.h"
+
+#include <algorithm>
+#include <functional>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+EvaluationCache::EvaluationCache(std::filesystem::path directory, std::uintmax_t maxSize)
+    : m_directory(std::move(directory)),
+      m_maxSize(maxSize)
+{
+}
+
+bool EvaluationCache::load(const std::string& key, ControllerListener& listener) const
+{
+    const fs::path path {entryPath(key)};
+    MotionLogReader reader;
+    if (!reader.readFile(path.string()))
+        return false;
+
+    // mark the entry as recently used
+    std::error_code error;
+    fs::last_write_time(path, fs::file_time_type::clock::now(), error);
+
+    reader.replay(listener);
+    return true;
+}
+
+bool EvaluationCache::store(const std::string& key, const MotionLogWriter& motionLog)
+{
+    if (motionLog.isEmpty())
+        return false;
+
+    std::error_code error;
+    fs::create_directories(m_directory, error);
+    if (error)
+        return false;
+
+    // write to a temporary file first, so a concurrent load never sees a partial entry,
+    // programs with the same text are stored by several threads or instances at once
+    const fs::path path {entryPath(key)};
+    fs::path tempPath {path};
+    tempPath += "." + std::to_string(std::hash<std::thread::id>{}(std::this_thread::get_id())) + "." +
+                std::to_string(m_nextTempFile++) + ".tmp";
+    if (!motionLog.write(tempPath.string()))
+    {
+        fs::remove(tempPath, error);
+        return false;
+    }
+    fs::rename(tempPath, path, error);
+    if (error)
+    {
+        fs::remove(tempPath, error);
+        return false;
+    }
+
+    evict();
+    return true;
+}
+
+bool EvaluationCache::contains(const std::string& key) const
+{
+    std::error_code error;
+    return fs::exists(entryPath(key), error);
+}
+
+fs::path EvaluationCache::entryPath(const std::string& key) const
+{
+    return m_directory / (key + ".cache");
+}
+
+void EvaluationCache::evict()
+{
+    // one at a time, the others would remove the same entries again
+    std::lock_guard lock {m_evictMutex};
+
+    struct Entry
+    {
+        fs::path path;
+        fs::file_time_type lastUse;
+        std::uintmax_t size;
+    };
+    std::vector<Entry> entries;
+    std::uintmax_t totalSize {0};
+
+    std::error_code error;
+    for (const auto& dirEntry : fs::directory_iterator(m_directory, error))
+    {
+        if (dirEntry.path().extension() != ".cache")
+            continue;
+        Entry entry {dirEntry.path(), dirEntry.last_write_time(error), dirEntry.file_size(error)};
+        if (error)
+            continue;
+        totalSize += entry.size;
+        entries.push_back(std::move(entry));
+    }
+
+    std::sort(entries.begin(), entries.end(),
+              [](const Entry& a, const Entry& b) { return a.lastUse < b.lastUse; });
+    for (const auto& entry : entries)
+    {
+        if (totalSize <= m_maxSize)
+            break;
+        if (fs::remove(entry.path, error))
+            totalSize -= entry.size;
+    }
+}
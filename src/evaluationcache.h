@@ -0,0 +1,44 @@
+#ifndef EVALUATIONCACHE_H
+#define EVALUATIONCACHE_H
+
+#include "controller.h"
+#include "motionlog.h"
+
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <string>
+
+/**
+ * Directory of motion logs of program runs, so an unchanged program does not need to be evaluated again.
+ * The key identifies the program text and the evaluating version. Entries are evicted least recently
+ * used first when the directory grows beyond its size limit. Entries can be stored from several threads.
+ */
+class EvaluationCache
+{
+public:
+    static constexpr std::uintmax_t defaultMaxSize {512 * 1024 * 1024};
+
+    explicit EvaluationCache(std::filesystem::path directory, std::uintmax_t maxSize = defaultMaxSize);
+
+    /**
+     * Replays the recorded run to the listener. Returns false, without calling the listener,
+     * if there is no valid entry for the key.
+     */
+    bool load(const std::string& key, ControllerListener& listener) const;
+    bool store(const std::string& key, const MotionLogWriter& motionLog);
+    /** without reading the entry or marking it as used */
+    bool contains(const std::string& key) const;
+
+private:
+    std::filesystem::path entryPath(const std::string& key) const;
+    void evict();
+
+    std::filesystem::path m_directory;
+    std::uintmax_t m_maxSize;
+    std::atomic<unsigned> m_nextTempFile {0};
+    std::mutex m_evictMutex;
+};
+
+#endif // EVALUATIONCACHE_H
@@ -143,6 +143,39 @@ glm::dvec2 DirectedArc2Sampler::sample(const double param) const
     return m_arc2.center + glm::rotate(m_centerToPoint1, m_angle * param);
 }
 
+/**
+ * Calls func(k, v) with v rotated by angle * k / count for k = 1..count.
+ * Rotates incrementally, every 64th and the last vector are calculated exactly.
+ */
+template <typename Func>
+static void rotateN(const glm::dvec2& v0, const double angle, const std::size_t count, Func func)
+{
+    constexpr std::size_t exactInterval {64};
+    const double step {angle / static_cast<double>(count)};
+    const double c {std::cos(step)};
+    const double s {std::sin(step)};
+    glm::dvec2 v {v0};
+    for (std::size_t k {1}; k <= count; k++)
+    {
+        if (k % exactInterval == 0 || k == count)
+            v = glm::rotate(v0, step * static_cast<double>(k));
+        else
+            v = glm::dvec2 {c * v.x - s * v.y, s * v.x + c * v.y};
+        func(k, v);
+    }
+}
+
+/**
+ * Writes the points for the params k / count, k = 1..count.
+ */
+void DirectedArc2Sampler::sampleN(const std::size_t count, glm::dvec2* out) const
+{
+    rotateN(m_centerToPoint1, m_angle, count, [this, out](std::size_t k, const glm::dvec2& v)
+    {
+        out[k - 1] = m_arc2.center + v;
+    });
+}
+
 double DirectedArc2Sampler::angle(const glm::dvec2& v1, const glm::dvec2& v2, const DirectedArc2::ArcDirection dir)
 {
     auto a {glm::orientedAngle(glm::normalize(v1), glm::normalize(v2))};
@@ -186,6 +219,22 @@ glm::dvec3 DirectedArc3Sampler::sample(const double param) const
     return m_arc3.transform * glm::dvec4(v, m_arc3.z, 1.0);
 }
 
+/**
+ * Writes the points for the params k / count, k = 1..count.
+ */
+void DirectedArc3Sampler::sampleN(const std::size_t count, glm::dvec3* out) const
+{
+    const auto& t {m_arc3.transform};
+    const glm::dvec3 origin {t * glm::dvec4(m_arc3.arc2.center, m_arc3.z, 1.0)};
+    const glm::dvec3 axisX {t[0]};
+    const glm::dvec3 axisY {t[1]};
+    rotateN(m_arc2sampler.m_centerToPoint1, m_arc2sampler.m_angle, count,
+            [&](std::size_t k, const glm::dvec2& v)
+    {
+        out[k - 1] = origin + axisX * v.x + axisY * v.y;
+    });
+}
+
 HelixSampler::HelixSampler(const Helix& helix)
     : m_helix(helix),
       m_arc2sampler(helix.arc2)
@@ -210,3 +259,24 @@ glm::dvec3 HelixSampler::sample(const double param) const
 
     return m_helix.transform * glm::dvec4(m_arc2sampler.sample(sampleParam), z, 1.0);
 }
+
+/**
+ * Writes the points for the params k / count, k = 1..count.
+ */
+void HelixSampler::sampleN(const std::size_t count, glm::dvec3* out) const
+{
+    // the full turns and the last arc, all around the same center
+    const auto turnAngle {std::copysign(m_helix.turn * 2 * glm::pi<double>(), m_arc2sampler.m_angle)};
+    const auto totalAngle {turnAngle + m_arc2sampler.m_angle};
+
+    const auto& t {m_helix.transform};
+    const glm::dvec3 origin {t * glm::dvec4(m_helix.arc2.center, m_helix.zStart, 1.0)};
+    const glm::dvec3 axisX {t[0]};
+    const glm::dvec3 axisY {t[1]};
+    const glm::dvec3 zStep {glm::dvec3(t[2]) * ((m_helix.zEnd - m_helix.zStart) / static_cast<double>(count))};
+    rotateN(m_arc2sampler.m_centerToPoint1, totalAngle, count,
+            [&](std::size_t k, const glm::dvec2& v)
+    {
+        out[k - 1] = origin + axisX * v.x + axisY * v.y + zStep * static_cast<double>(k);
+    });
+}
@@ -9,6 +9,7 @@
 #include <glm/gtc/constants.hpp>
 
 #include <optional>
+#include <cstddef>
 
 
 struct DirectedArc2
@@ -70,11 +71,15 @@ class DirectedArc2Sampler
     const DirectedArc2& m_arc2;
     const glm::dvec2 m_centerToPoint1;
     const double m_angle;
+    friend class DirectedArc3Sampler;
     friend class HelixSampler;
 public:
     explicit DirectedArc2Sampler(const DirectedArc2& arc2);
 
     glm::dvec2 sample(const double param) const;
+    void sampleN(std::size_t count, glm::dvec2* out) const;
+    // swept angle, negative for clockwise arcs
+    double angle() const { return m_angle; }
 
 private:
     constexpr static double eps {1e-10};
@@ -91,6 +96,7 @@ public:
     explicit DirectedArc3Sampler(const DirectedArc3& arc3);
 
     glm::dvec3 sample(const double param) const;
+    void sampleN(std::size_t count, glm::dvec3* out) const;
 };
 
 class HelixSampler
@@ -102,6 +108,7 @@ public:
     explicit HelixSampler(const Helix& helix);
 
     glm::dvec3 sample(const double param) const;
+    void sampleN(std::size_t count, glm::dvec3* out) const;
 };
 
 #endif // GEOMETRY_H
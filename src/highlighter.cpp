@@ -1,78 +1,179 @@
 #include "highlighter.h"
 #include "parser.h"
 
-#include <QRegularExpression>
+#include <QElapsedTimer>
+#include <QPlainTextEdit>
+#include <QTextBlock>
+#include <QTextLayout>
 
+#include <algorithm>
 
-Highlighter::Highlighter(QTextDocument* doc)
-    : QSyntaxHighlighter(doc)
-{
-    highlightingRules.reserve(10);
-
-    HighlightingRule rule;
-    QTextCharFormat format;
-
-    format.setForeground(QColor(0xCD0000));
-    rule.pattern = QRegularExpression(R"((?:\b|\d)([gG]0+)(?=\D|$))");
-    rule.nth = 1;
-    rule.format = format;
-    highlightingRules.push_back(rule);
-
-    format.setForeground(QColor(0x14AA28));
-    rule.pattern = QRegularExpression(R"((?:\b|\d)([gG]0*1)(?=\D|$))");
-    rule.nth = 2;
-    rule.format = format;
-    highlightingRules.push_back(rule);
 
-    format.setForeground(QColor(0x00C8F0));
-    rule.pattern = QRegularExpression(R"((?:\b|\d)([gG]0*[23])(?=\D|$))");
-    rule.nth = 2;
-    rule.format = format;
-    highlightingRules.push_back(rule);
-
-    format.setForeground(QColor(0x004BAF));
-    rule.pattern = QRegularExpression(R"((?:\b|\d)([dD]\d{1,3})(?=\D|$))");
-    rule.nth = 2;
-    rule.format = format;
-    highlightingRules.push_back(rule);
+Highlighter::Highlighter(QPlainTextEdit* editor, const Parser& parser)
+    : QObject(editor),
+      m_editor(editor),
+      m_parser(parser)
+{
+    m_rapidMotionFormat.setForeground(QColor(0xCD0000));
+    m_linearMotionFormat.setForeground(QColor(0x14AA28));
+    m_circularMotionFormat.setForeground(QColor(0x00C8F0));
+    m_functionFormat.setForeground(QColor(0x004BAF));
+    m_keywordFormat.setForeground(QColor(0x8B008B));
+    m_keywordFormat.setFontWeight(QFont::Bold);
+    m_arithmeticFunctionFormat.setForeground(QColor(0x8B008B));
+    m_identifierFormat.setForeground(QColor(0x8C6400));
+    m_stringFormat.setForeground(QColor(0xC05800));
+    m_commentFormat.setForeground(QColor(0x828C96));
 
-    rule.pattern = QRegularExpression(R"((?:\b|\d)([dD][lL](=(QU\(_+\)|[0-6])|\[[_+]\]=([-+]?\d+[.]?\d*(?:EX[-+]?\d+)?|QU\(_+\))))(?=\D|$))");
-    highlightingRules.push_back(rule);
+    m_timer.setSingleShot(true);
+    m_timer.setInterval(0);
+    connect(&m_timer, &QTimer::timeout, this, &Highlighter::highlightVisibleBlocks);
 
-    rule.pattern = QRegularExpression(R"((?:\b|\d)([sS](\d{1,5}|(\d*|\[[A-Za-z_]\w{0,30}\])=(\d+|[A-Za-z_]\w{0,30}(\[_+\])?|QU\(_+\))))(?=\D|$))");
-    highlightingRules.push_back(rule);
+    connect(m_editor->document(), &QTextDocument::contentsChange, this, &Highlighter::onContentsChange);
+    // scrolling, resizing and editing
+    connect(m_editor, &QPlainTextEdit::updateRequest, &m_timer, qOverload<>(&QTimer::start));
 
-    rule.pattern = QRegularExpression(R"((?:\b|\d)([fF][zZ]?(=?(\d+(\.\d+)?)|=QU\(_+\)))(?=\D|$))");
-    highlightingRules.push_back(rule);
+    if (!m_editor->document()->isEmpty())
+        m_timer.start();
+}
 
-    rule.pattern = QRegularExpression(R"((?:\b|\d)([mM](\d{1,10}|(\d*|\[[A-Za-z_]\w{0,30}\])=(\d+|QU\(_+\))))(?=\D|$))");
-    highlightingRules.push_back(rule);
+void Highlighter::onContentsChange(int position, int /*charsRemoved*/, int charsAdded)
+{
+    if (m_formatting)
+        return;
 
-    rule.pattern = QRegularExpression(R"((?:\b|\d)([hH](\d{1,10}|(\d*|\[[A-Za-z_]\w{0,30}\])=([-+]?\d+[.]?\d*(?:EX[-+]?\d+)?|QU\(_+\))))(?=\D|$))");
-    highlightingRules.push_back(rule);
+    QTextDocument* document {m_editor->document()};
+    if (position == 0 && charsAdded >= document->characterCount() - 1)
+    {
+        // the whole text was replaced
+        m_generation++;
+    }
+    else
+    {
+        const QTextBlock end {document->findBlock(position + charsAdded).next()};
+        for (QTextBlock block {document->findBlock(position)}; block.isValid() && block != end; block = block.next())
+            block.setUserState(-1);
+    }
+    m_timer.start();
+}
 
-    rule.pattern = QRegularExpression(R"((?:\b|\d)([tT](\d+(=\d+)?|(\[[A-Za-z_]\w{0,30}\])?=("[^"]*"|\d+|QU\(_+\))))(?=\D|$))");
-    highlightingRules.push_back(rule);
+void Highlighter::highlightVisibleBlocks()
+{
+    QElapsedTimer elapsed;
+    elapsed.start();
+
+    const QTextDocument* document {m_editor->document()};
+    const QTextBlock first {m_editor->cursorForPosition(QPoint(0, 0)).block()};
+    const QTextBlock last {m_editor->cursorForPosition(QPoint(0, m_editor->viewport()->height())).block()};
+    const int begin {std::max(0, first.blockNumber() - margin)};
+    const int end {std::min(document->blockCount(), last.blockNumber() + 1 + margin)};
+
+    // the visible blocks and the margin below first, then the margin above
+    if (!highlightBlocks(first, end, elapsed) ||
+        !highlightBlocks(document->findBlockByNumber(begin), first.blockNumber(), elapsed))
+        m_timer.start();
+}
 
-    m_commentFormat.setForeground(QColor(0x828C96));
+bool Highlighter::highlightBlocks(QTextBlock block, int endBlockNumber, const QElapsedTimer& elapsed)
+{
+    for (; block.isValid() && block.blockNumber() < endBlockNumber; block = block.next())
+    {
+        if (block.userState() == m_generation)
+            continue;
+        if (elapsed.elapsed() >= timeSlice)
+            return false;
+        highlightBlock(block);
+    }
+    return true;
 }
 
-void Highlighter::highlightBlock(const QString& text)
+void Highlighter::highlightBlock(QTextBlock& block)
 {
-    constexpr auto captureGroup = 1;
-    for (auto& rule : highlightingRules)
+    using Category = Parser::TokenCategory;
+
+    const QString text {block.text()};
+    const int commentPos {static_cast<int>(Parser::findCommentStartPos<QString>(text.begin(), text.end()))};
+    // one byte per UTF-16 code unit, the token positions are valid in the QString
+    const QByteArray code {text.left(commentPos).toLatin1()};
+    m_parser.tokenize(code.constData(), code.constData() + code.size(), m_tokens);
+
+    QVector<QTextLayout::FormatRange> ranges;
+    for (size_t i {0}; i < m_tokens.size(); i++)
     {
-        QRegularExpressionMatchIterator matchIterator {rule.pattern.globalMatch(text)};
-        while (matchIterator.hasNext())
+        const Parser::LexicalToken& token {m_tokens[i]};
+        // a letter and the number directly after it form a word
+        const int position {static_cast<int>(token.position)};
+        const bool hasValue {i + 1 < m_tokens.size() && m_tokens[i + 1].category == Category::Number &&
+                             m_tokens[i + 1].position == token.position + token.length};
+        const QTextCharFormat* format {};
+        bool isWord {false};
+        switch (token.category)
+        {
+        case Category::GFunction:
+            format = &m_functionFormat;
+            isWord = hasValue;
+            if (hasValue)
+            {
+                bool ok;
+                const int g {code.mid(position + static_cast<int>(token.length),
+                                      static_cast<int>(m_tokens[i + 1].length)).toInt(&ok)};
+                if (ok && g == 0)
+                    format = &m_rapidMotionFormat;
+                else if (ok && g == 1)
+                    format = &m_linearMotionFormat;
+                else if (ok && (g == 2 || g == 3))
+                    format = &m_circularMotionFormat;
+            }
+            break;
+        case Category::AuxiliaryFunction:
+            format = &m_functionFormat;
+            isWord = hasValue;
+            break;
+        case Category::AddressLetter:
+            // feed
+            if (token.length == 1 && (code[position] == 'F' || code[position] == 'f'))
+            {
+                format = &m_functionFormat;
+                isWord = hasValue;
+            }
+            break;
+        case Category::Keyword:
+            format = &m_keywordFormat;
+            break;
+        case Category::Function:
+            format = &m_arithmeticFunctionFormat;
+            break;
+        case Category::Identifier:
+            format = &m_identifierFormat;
+            break;
+        case Category::String:
+            format = &m_stringFormat;
+            break;
+        default:
+            break;
+        }
+
+        if (format)
         {
-            const QRegularExpressionMatch match = matchIterator.next();
-            setFormat(match.capturedStart(captureGroup), match.capturedLength(captureGroup), rule.format);
+            const size_t length {isWord ? m_tokens[i + 1].position + m_tokens[i + 1].length - token.position : token.length};
+            ranges.append({position, static_cast<int>(length), *format});
         }
+        if (isWord)
+            i++;
     }
 
-    int commentPos {static_cast<int>(Parser::findCommentStartPos<QString>(text.begin(), text.end()))};
     if (commentPos < text.length())
     {
-        setFormat(commentPos, text.length() - commentPos, m_commentFormat);
+        ranges.append({commentPos, text.length() - commentPos, m_commentFormat});
     }
+
+    block.setUserState(m_generation);
+    QTextLayout* layout {block.layout()};
+    if (ranges.isEmpty() && layout->formats().isEmpty())
+        return;
+
+    layout->setFormats(ranges);
+    m_formatting = true;
+    m_editor->document()->markContentsDirty(block.position(), block.length());
+    m_formatting = false;
 }
@@ -1,28 +1,55 @@
 #ifndef HIGHLIGHTER_H
 #define HIGHLIGHTER_H
 
-#include <QSyntaxHighlighter>
-#include <QRegularExpression>
+#include "parser.h"
+
+#include <QObject>
+#include <QTextCharFormat>
+#include <QTimer>
 
 #include <vector>
 
-class Highlighter : public QSyntaxHighlighter
+class QElapsedTimer;
+class QPlainTextEdit;
+class QTextBlock;
+
+/**
+ * Syntax highlighting of the blocks around the viewport of an editor. The blocks are formatted
+ * in idle time, a time slice at a time, and are not formatted again until their text changes.
+ * The text is split by the lexer of the parser, so the highlighting follows the grammar.
+ */
+class Highlighter : public QObject
 {
     Q_OBJECT
 public:
-    explicit Highlighter(QTextDocument* doc = nullptr);
+    Highlighter(QPlainTextEdit* editor, const Parser& parser);
 
-protected:
-    void highlightBlock(const QString &text) override;
+    static constexpr int margin {100}; // blocks above and below the viewport
+    static constexpr int timeSlice {10}; // in milliseconds
 
 private:
-    struct HighlightingRule
-    {
-        QRegularExpression pattern;
-        int nth;
-        QTextCharFormat format;
-    };
-    std::vector<HighlightingRule> highlightingRules;
+    void onContentsChange(int position, int charsRemoved, int charsAdded);
+    void highlightVisibleBlocks();
+    bool highlightBlocks(QTextBlock block, int endBlockNumber, const QElapsedTimer& elapsed);
+    void highlightBlock(QTextBlock& block);
+
+    QPlainTextEdit* m_editor;
+    QTimer m_timer;
+    // blocks with this user state are up to date, incremented to invalidate all of them at once
+    int m_generation {0};
+    bool m_formatting {false};
+
+    const Parser& m_parser;
+    std::vector<Parser::LexicalToken> m_tokens;
+
+    QTextCharFormat m_rapidMotionFormat;
+    QTextCharFormat m_linearMotionFormat;
+    QTextCharFormat m_circularMotionFormat;
+    QTextCharFormat m_functionFormat;
+    QTextCharFormat m_keywordFormat;
+    QTextCharFormat m_arithmeticFunctionFormat;
+    QTextCharFormat m_identifierFormat;
+    QTextCharFormat m_stringFormat;
     QTextCharFormat m_commentFormat;
 };
 
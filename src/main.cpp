@@ -1,22 +1,212 @@
 #include "mainwindow.h"
+#include "batchverifier.h"
+#include "controller.h"
+#include "motionlist.h"
+#include "pathrasterizer.h"
+#include "programtransform.h"
 
 #include <QApplication>
 #include <QCommandLineParser>
 #include <QSurfaceFormat>
 
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+
+/**
+ * Whether the arguments ask for --verify, --thumbnails or --transform, which run without
+ * a window, before there is an application to parse them.
+ */
+static bool isCommandLineRun(int argc, char *argv[])
+{
+    for (int i {1}; i < argc; i++)
+    {
+        for (const char* option : {"--verify", "--thumbnails", "--transform"})
+        {
+            const size_t length {std::strlen(option)};
+            if (std::strncmp(argv[i], option, length) == 0 && (argv[i][length] == '\0' || argv[i][length] == '='))
+                return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Writes the backplot of each program to a PNG file next to it, named like the program
+ * with .png appended. Returns whether all of them were written.
+ */
+static bool writeThumbnails(const std::vector<std::string>& paths, int size)
+{
+    bool ok {true};
+    Controller controller;
+    MotionList motions;
+    PathRasterizer rasterizer;
+    controller.setListener(&motions);
+    for (const auto& path : paths)
+    {
+        std::ifstream file {path};
+        controller.reset();
+        std::string line;
+        while (std::getline(file, line))
+        {
+            if (!line.empty() && line.back() == '\r')
+                line.pop_back();
+            controller.addLine(line);
+        }
+        // alarms stop the program, the motions up to them are plotted
+        controller.run();
+        rasterizer.plot(motions);
+
+        const QString imagePath {QString::fromStdString(path + ".png")};
+        if (!rasterizer.thumbnail(size).save(imagePath, "PNG"))
+        {
+            std::cerr << "cannot write " << imagePath.toStdString() << '\n';
+            ok = false;
+        }
+    }
+    return ok;
+}
+
+/**
+ * Transforms the program to output, or to stdout if output is empty, and reports to stderr.
+ * Returns whether the program was read and the output written.
+ */
+static bool transformProgram(const std::string& path, const std::string& output, const ProgramTransform::Options& options)
+{
+    std::ifstream in {path, std::ios::binary};
+    if (!in)
+    {
+        std::cerr << "cannot read " << path << '\n';
+        return false;
+    }
+    std::ofstream file;
+    if (!output.empty())
+    {
+        file.open(output, std::ios::binary);
+        if (!file)
+        {
+            std::cerr << "cannot write " << output << '\n';
+            return false;
+        }
+    }
+    std::ostream& out {output.empty() ? std::cout : file};
+
+    const auto result {ProgramTransform{options}.transform(in, out)};
+    std::cerr << path << ": " << result.changedBlocks << " of " << result.blockCount << " blocks changed, "
+              << result.skippedWords << " words with computed values and " << result.alarmCount
+              << " blocks with alarms kept\n";
+    return static_cast<bool>(out.flush());
+}
+
 int main(int argc, char *argv[])
 {
-    QApplication app(argc, argv);
+    // the command line runs need no display
+    std::unique_ptr<QCoreApplication> app;
+    if (isCommandLineRun(argc, argv))
+        app = std::make_unique<QCoreApplication>(argc, argv);
+    else
+    {
+        QSurfaceFormat fmt;
+        fmt.setProfile(QSurfaceFormat::CoreProfile);
+        fmt.setSamples(4);
+        fmt.setVersion(3, 3);
+        QSurfaceFormat::setDefaultFormat(fmt);
+        app = std::make_unique<QApplication>(argc, argv);
+    }
+
+    QCommandLineParser parser;
+    parser.addHelpOption();
+    const QCommandLineOption verifyOption {"verify", "Verify all programs in <directory> and print a report.", "directory"};
+    parser.addOption(verifyOption);
+    const QCommandLineOption thumbnailsOption {"thumbnails", "Write a PNG backplot next to each program in <directory>.", "directory"};
+    parser.addOption(thumbnailsOption);
+    const QCommandLineOption thumbnailSizeOption {"thumbnail-size", "Width and height of the thumbnails, 512 by default.", "pixels", "512"};
+    parser.addOption(thumbnailSizeOption);
+    const QCommandLineOption transformOption {"transform", "Transform <program> with the options below.", "program"};
+    parser.addOption(transformOption);
+    const QCommandLineOption outputOption {"output", "Write the transformed program to <file> instead of stdout.", "file"};
+    parser.addOption(outputOption);
+    const QCommandLineOption renumberOption {"renumber", "Renumber the blocks from <start> by <step>, GOTO targets follow.", "start,step"};
+    parser.addOption(renumberOption);
+    const QCommandLineOption offsetOption {"offset", "Add the offset to absolute X, Y, Z.", "x,y,z"};
+    parser.addOption(offsetOption);
+    const QCommandLineOption mirrorOption {"mirror", "Mirror the axes, any of xyz.", "axes"};
+    parser.addOption(mirrorOption);
+    const QCommandLineOption feedPercentOption {"feed-percent", "Scale the feeds to <percent>.", "percent", "100"};
+    parser.addOption(feedPercentOption);
+    parser.addPositionalArgument("file", "Program to open.");
+    parser.process(*app);
+
+    if (parser.isSet(verifyOption))
+    {
+        const auto paths {BatchVerifier::findPrograms(parser.value(verifyOption).toStdString())};
+        const auto results {BatchVerifier{}.verify(paths)};
+        BatchVerifier::writeReport(std::cout, results);
+        const bool ok {std::all_of(results.begin(), results.end(), [](const BatchVerifier::Result& result) {
+            return !result.failed();
+        })};
+        return ok ? 0 : 1;
+    }
 
-    QSurfaceFormat fmt;
-    fmt.setProfile(QSurfaceFormat::CoreProfile);
-    fmt.setSamples(4);
-    fmt.setVersion(3, 3);
-    QSurfaceFormat::setDefaultFormat(fmt);
+    if (parser.isSet(thumbnailsOption))
+    {
+        const auto paths {BatchVerifier::findPrograms(parser.value(thumbnailsOption).toStdString())};
+        const int size {std::clamp(parser.value(thumbnailSizeOption).toInt(), 16, 4096)};
+        return writeThumbnails(paths, size) ? 0 : 1;
+    }
+
+    if (parser.isSet(transformOption))
+    {
+        ProgramTransform::Options options;
+        bool ok {true};
+        auto numbers = [&ok](const QString& text, int count)
+        {
+            std::vector<double> values;
+            const auto parts {text.split(',')};
+            ok = ok && parts.size() == count;
+            for (const auto& part : parts)
+            {
+                bool partOk;
+                values.push_back(part.toDouble(&partOk));
+                ok = ok && partOk;
+            }
+            values.resize(static_cast<size_t>(count));
+            return values;
+        };
+        if (parser.isSet(renumberOption))
+        {
+            const auto values {numbers(parser.value(renumberOption), 2)};
+            ok = ok && values[0] >= 0.0 && values[1] >= 1.0;
+            options.renumber = true;
+            options.renumberStart = static_cast<uint32_t>(values[0]);
+            options.renumberStep = static_cast<uint32_t>(values[1]);
+        }
+        if (parser.isSet(offsetOption))
+        {
+            const auto values {numbers(parser.value(offsetOption), 3)};
+            options.offset = {values[0], values[1], values[2]};
+        }
+        for (const QChar axis : parser.value(mirrorOption).toLower())
+        {
+            const int index {QStringLiteral("xyz").indexOf(axis)};
+            ok = ok && index >= 0;
+            if (index >= 0)
+                options.mirror[static_cast<size_t>(index)] = true;
+        }
+        options.feedPercent = numbers(parser.value(feedPercentOption), 1)[0];
+        ok = ok && options.feedPercent > 0.0;
+        if (!ok)
+        {
+            std::cerr << "invalid transform options\n";
+            return 2;
+        }
+        return transformProgram(parser.value(transformOption).toStdString(), parser.value(outputOption).toStdString(),
+                                options) ? 0 : 1;
+    }
 
     MainWindow w;
-    QCommandLineParser parser;
-    parser.process(app);
     if (!parser.positionalArguments().isEmpty())
         w.openFile(parser.positionalArguments().first());
 
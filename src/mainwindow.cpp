@@ -1,23 +1,50 @@
 #include "mainwindow.h"
 #include "ui_mainwindow.h"
+#include "backplotwidget.h"
+#include "batchverifier.h"
 #include "codeeditor.h"
 #include "documentview.h"
-
+#include "motionlog.h"
+#include "parser.h"
+#include "programbrowser.h"
+#include "s840d_alarm.h"
+#include "stocksimulator.h"
+#include "stockview.h"
+#include "transformdialog.h"
+
+#include <QCryptographicHash>
+#include <QDir>
 #include <QTabWidget>
+#include <QTextBlock>
+#include <QTextCursor>
 #include <QKeySequence>
 #include <QFileDialog>
+#include <QFutureWatcher>
+#include <QInputDialog>
+#include <QLabel>
+#include <QStatusBar>
 #include <QTextStream>
 #include <QMessageBox>
+#include <QStandardPaths>
 #include <QTextCodec>
+#include <QtConcurrentRun>
+
+#include <algorithm>
+#include <memory>
+#include <sstream>
 
 
 constexpr std::array DEFAULT_NAME {"Untitled"};
 
 MainWindow::MainWindow(QWidget *parent)
-    : QMainWindow(parent)
+    : QMainWindow(parent),
+      m_evaluationCache((QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/evaluation").toStdString())
 {
     setupUi(this);
 
+    m_cycleTimeLabel = new QLabel(this);
+    statusBar()->addPermanentWidget(m_cycleTimeLabel);
+
     tabWidget->setMovable(true);
     tabWidget->setTabsClosable(true);
     on_actionNew_triggered();
@@ -28,28 +55,193 @@ QSize MainWindow::sizeHint() const
     return QSize{1600, 900};
 }
 
-void MainWindow::openFile(const QString& path)
+MainWindow::~MainWindow()
 {
-    const QFileInfo fileInfo {path};
-    for (int i = 0; i < tabWidget->count(); i++)
+    // the queued work is dropped, the running work stops at its next slice
+    m_closing = true;
+    m_workers.clear();
+    m_workers.waitForDone();
+}
+
+namespace
+{
+/** What the tab of a program is created from, prepared on a worker thread. */
+struct OpenedProgram
+{
+    QString path;
+    QString text;
+    CrossReferenceIndex crossReferences;
+    bool readable {false};
+};
+
+/** The summary and report of Verify folder. */
+struct FolderVerification
+{
+    size_t count {0};
+    size_t failed {0};
+    QString report;
+};
+
+/** The result of Simulate stock. */
+struct StockSimulation
+{
+    QImage image;
+    QString summary;
+};
+
+/** The programs opened at once, the first one ready is shown. */
+struct OpenedBatch
+{
+    size_t remaining;
+    size_t failed {0};
+    bool selected {false};
+};
+}
+
+/**
+ * Evaluates the program into the cache under the key the editor looks up, unless it is there.
+ * Evaluates in slices, so the window closing need not wait for the whole program.
+ */
+static void evaluateIntoCache(const QString& text, const QStringList& lines, EvaluationCache& cache,
+                              const std::atomic<bool>& cancelled)
+{
+    const std::string key {CodeEditor::evaluationCacheKey(text)};
+    if (cache.contains(key))
+        return;
+
+    MotionLogWriter recorder;
+    Controller controller;
+    controller.setListener(&recorder);
+    controller.setBudget({std::chrono::milliseconds{100}, 0});
+    for (const auto& line : lines)
+        controller.addLine(line);
+    controller.run();
+    while (controller.stopReason() == Controller::StopReason::Budget)
     {
-        if (path == documentAt(i)->metaInformation(QTextDocument::DocumentUrl))
-        {
-            tabWidget->setCurrentIndex(i);
+        if (cancelled)
             return;
-        }
+        controller.resume();
     }
+    // like in the editor, runs stopped by the jump limit are not cached
+    if (!controller.canResume())
+        cache.store(key, recorder);
+}
 
+/**
+ * Does the work of the editor for a program opened, its cross references are indexed like
+ * CodeEditor::onContentsChange does.
+ */
+static std::shared_ptr<OpenedProgram> openProgram(const QString& path, EvaluationCache& cache,
+                                                  const std::atomic<bool>& cancelled)
+{
+    auto program {std::make_shared<OpenedProgram>()};
+    program->path = path;
     QFile file {path};
-    if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
-        return;
-
+    if (cancelled || !file.open(QIODevice::ReadOnly | QIODevice::Text))
+        return program;
     QTextStream textStream {&file};
     textStream.setCodec(QTextCodec::codecForName("UTF-8"));
+    program->text = textStream.readAll();
+    program->readable = true;
+    file.close();
 
-    DocumentView* view {createNewView(textStream.readAll())};
+    // a line per block of the document
+    const QStringList lines {program->text.split('\n')};
+    Parser parser;
+    program->crossReferences.replaceLines(0, 0, static_cast<size_t>(lines.size()));
+    for (int line {0}; line < lines.size() && !cancelled; line++)
+    {
+        try
+        {
+            program->crossReferences.setLine(static_cast<size_t>(line), parser.parse(lines[line].toStdString()), parser);
+        }
+        catch (const S840D_Alarm& /*alarm*/)
+        {
+            // the evaluation reports it
+        }
+    }
+
+    // the editor loads the evaluation from the cache when its tab is shown
+    evaluateIntoCache(program->text, lines, cache, cancelled);
+    return program;
+}
+
+void MainWindow::openFile(const QString& path)
+{
+    openFiles({path});
+}
+
+void MainWindow::openFiles(const QStringList& paths)
+{
+    std::vector<QString> pending;
+    for (const auto& path : paths)
+    {
+        const int index {findTab(path)};
+        if (index >= 0)
+            tabWidget->setCurrentIndex(index);
+        else if (std::find(pending.begin(), pending.end(), path) == pending.end())
+            pending.push_back(path);
+    }
+    if (pending.empty())
+        return;
+
+    // largest first, so all of them take about as long as the largest one
+    std::stable_sort(pending.begin(), pending.end(), [](const QString& a, const QString& b) {
+        return QFileInfo(a).size() > QFileInfo(b).size();
+    });
+    statusbar->showMessage(tr("Opening %n programs...", nullptr, static_cast<int>(pending.size())));
+
+    // the watchers belong to the window, so no result arrives after it is gone
+    auto batch {std::make_shared<OpenedBatch>(OpenedBatch{pending.size()})};
+    for (const auto& path : pending)
+    {
+        auto watcher {new QFutureWatcher<std::shared_ptr<OpenedProgram>>(this)};
+        connect(watcher, &QFutureWatcherBase::finished, this, [this, watcher, batch]()
+        {
+            const std::shared_ptr<OpenedProgram> program {watcher->result()};
+            watcher->deleteLater();
+            if (program->readable)
+            {
+                // the others open behind the first one ready
+                addDocumentTab(program->path, program->text, std::move(program->crossReferences),
+                               !std::exchange(batch->selected, true));
+            }
+            else
+                batch->failed++;
+
+            if (--batch->remaining > 0)
+                return;
+            if (batch->failed > 0)
+                statusbar->showMessage(tr("%n programs could not be read.", nullptr, static_cast<int>(batch->failed)), 5000);
+            else
+                statusbar->clearMessage();
+        });
+        watcher->setFuture(QtConcurrent::run(&m_workers, [this, path]()
+        {
+            return openProgram(path, m_evaluationCache, m_closing);
+        }));
+    }
+}
+
+int MainWindow::findTab(const QString& path) const
+{
+    for (int i = 0; i < tabWidget->count(); i++)
+    {
+        if (path == documentAt(i)->metaInformation(QTextDocument::DocumentUrl))
+            return i;
+    }
+    return -1;
+}
+
+void MainWindow::addDocumentTab(const QString& path, const QString& text,
+                                std::optional<CrossReferenceIndex> crossReferences, bool select)
+{
+    // opened meanwhile
+    if (findTab(path) >= 0)
+        return;
+
+    DocumentView* view {createNewView(text, &m_evaluationCache, std::move(crossReferences))};
     view->document()->setMetaInformation(QTextDocument::DocumentUrl, path);
-    file.close();
 
     // remove that one default empty unmodified tab
     if (tabWidget->count() == 1 &&
@@ -60,8 +252,9 @@ void MainWindow::openFile(const QString& path)
         tabWidget->removeTab(0);
     }
 
-    const int tabIndex = tabWidget->addTab(view, fileInfo.fileName());
-    tabWidget->setCurrentIndex(tabIndex);
+    const int tabIndex = tabWidget->addTab(view, QFileInfo(path).fileName());
+    if (select)
+        tabWidget->setCurrentIndex(tabIndex);
 }
 
 void MainWindow::saveDocument(int index, bool saveAs)
@@ -144,13 +337,29 @@ void MainWindow::adoptUIToDocument(int index)
         tabText += " *";
 
     tabWidget->setTabText(tabWidget->currentIndex(), tabText);
+
+    if (auto view {dynamic_cast<DocumentView*>(tabWidget->widget(index))})
+        showCycleTime(view->editor()->cycleTime());
+}
+
+void MainWindow::showCycleTime(double seconds)
+{
+    const auto total {static_cast<long long>(seconds + 0.5)};
+    m_cycleTimeLabel->setText(tr("Cycle time %1:%2:%3").arg(total / 3600)
+                              .arg(total / 60 % 60, 2, 10, QChar('0')).arg(total % 60, 2, 10, QChar('0')));
 }
 
-DocumentView* MainWindow::createNewView(const QString& text)
+DocumentView* MainWindow::createNewView(const QString& text, EvaluationCache* cache,
+                                        std::optional<CrossReferenceIndex> crossReferences)
 {
-    auto view {new DocumentView(text)};
+    auto view {new DocumentView(text, cache, std::move(crossReferences))};
     connect(view->document(), &QTextDocument::modificationChanged, this, &MainWindow::onDocumentModificationChange);
     connect(view->document(), &QTextDocument::contentsChanged, this, &MainWindow::onDocumentChange);
+    connect(view->editor(), &CodeEditor::cycleTimeChanged, this, [this, view](double seconds)
+    {
+        if (tabWidget->currentWidget() == view)
+            showCycleTime(seconds);
+    });
 
     return view;
 }
@@ -173,12 +382,61 @@ void MainWindow::on_actionOpen_triggered()
     QFileDialog dialog(this);
     dialog.setFileMode(QFileDialog::ExistingFiles);
     if (dialog.exec())
+        openFiles(dialog.selectedFiles());
+}
+
+void MainWindow::on_actionBrowseFolder_triggered()
+{
+    const QString directory {QFileDialog::getExistingDirectory(this, tr("Browse folder"))};
+    if (directory.isEmpty())
+        return;
+
+    // one index per folder, next to the evaluation cache
+    const QByteArray key {QCryptographicHash::hash(QDir(directory).canonicalPath().toUtf8(), QCryptographicHash::Sha1).toHex()};
+    const QString indexPath {QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/index/" + key + ".tsv"};
+    ProgramBrowser browser {directory, indexPath, this};
+    if (browser.exec() != QDialog::Accepted)
+        return;
+    openFiles(browser.selectedPaths());
+}
+
+void MainWindow::on_actionVerifyFolder_triggered()
+{
+    const QString directory {QFileDialog::getExistingDirectory(this, tr("Verify folder"))};
+    if (directory.isEmpty())
+        return;
+
+    actionVerifyFolder->setEnabled(false);
+    statusbar->showMessage(tr("Verifying %1...").arg(directory));
+
+    // the workers use all cores, so keep them away from the GUI thread
+    auto watcher {new QFutureWatcher<FolderVerification>(this)};
+    connect(watcher, &QFutureWatcherBase::finished, this, [this, watcher, directory]()
     {
-        QStringList fileNames = dialog.selectedFiles();
-        QStringListIterator iter(fileNames);
-        while (iter.hasNext())
-            openFile(iter.next());
-    }
+        const FolderVerification verification {watcher->result()};
+        watcher->deleteLater();
+        statusbar->clearMessage();
+        actionVerifyFolder->setEnabled(true);
+
+        QMessageBox box {verification.failed > 0 ? QMessageBox::Warning : QMessageBox::Information,
+                         tr("Verify folder"),
+                         tr("%1: %2 programs verified, %3 failed.").arg(directory).arg(verification.count)
+                         .arg(verification.failed),
+                         QMessageBox::Ok, this};
+        box.setDetailedText(verification.report);
+        box.exec();
+    });
+    watcher->setFuture(QtConcurrent::run(&m_workers, [this, directory]()
+    {
+        const auto results {BatchVerifier{}.verify(BatchVerifier::findPrograms(directory.toStdString()),
+                                                   [this]() { return !m_closing; }, &m_closing)};
+        const auto failed {std::count_if(results.begin(), results.end(), [](const BatchVerifier::Result& result) {
+            return result.failed();
+        })};
+        std::ostringstream report;
+        BatchVerifier::writeReport(report, results);
+        return FolderVerification{results.size(), static_cast<size_t>(failed), QString::fromStdString(report.str())};
+    }));
 }
 
 void MainWindow::on_actionSave_triggered()
@@ -196,6 +454,128 @@ void MainWindow::on_actionClose_triggered()
     closeTab(tabWidget->currentIndex());
 }
 
+void MainWindow::on_actionExportMotionLog_triggered()
+{
+    auto view {dynamic_cast<DocumentView*>(tabWidget->currentWidget())};
+    if (!view)
+        return;
+
+    const QString path {QFileDialog::getSaveFileName(this, tr("Export motion log"), QString(),
+                                                     tr("Motion logs (*.cml)"))};
+    if (path.isEmpty())
+        return;
+
+    if (!view->editor()->exportMotionLog(path))
+        QMessageBox::warning(this, tr("Export motion log"), tr("Could not write %1.").arg(path));
+}
+
+void MainWindow::on_actionImportMotionLog_triggered()
+{
+    const QString path {QFileDialog::getOpenFileName(this, tr("Import motion log"), QString(),
+                                                     tr("Motion logs (*.cml)"))};
+    if (path.isEmpty())
+        return;
+
+    MotionLogReader reader;
+    if (!reader.readFile(path.toStdString()))
+    {
+        QMessageBox::warning(this, tr("Import motion log"), tr("%1 is not a valid motion log.").arg(path));
+        return;
+    }
+
+    // the toolpath is shown without a program, editing the empty document replaces it
+    DocumentView* view {createNewView()};
+    reader.replay(*view->editor());
+
+    const int tabIndex = tabWidget->addTab(view, QFileInfo(path).fileName());
+    tabWidget->setCurrentIndex(tabIndex);
+}
+
+void MainWindow::on_actionSimulateStock_triggered()
+{
+    auto view {dynamic_cast<DocumentView*>(tabWidget->currentWidget())};
+    if (!view)
+        return;
+
+    bool ok;
+    const QString toolTable {QInputDialog::getText(this, tr("Simulate stock"),
+                                                   tr("Tools, F for flat end and B for ball end by diameter,\n"
+                                                      "other tools are flat end 10 mm:"),
+                                                   QLineEdit::Normal, m_toolTable, &ok)};
+    if (!ok)
+        return;
+    const auto tools {StockSimulator::parseToolTable(toolTable.toStdString())};
+    if (!tools)
+    {
+        QMessageBox::warning(this, tr("Simulate stock"), tr("Invalid tool table, expected for example T1=F10 T2=B6."));
+        return;
+    }
+    m_toolTable = toolTable;
+
+    std::vector<std::string> lines;
+    for (QTextBlock block = view->document()->begin(); block.isValid(); block = block.next())
+        lines.push_back(block.text().toStdString());
+
+    actionSimulateStock->setEnabled(false);
+    statusbar->showMessage(tr("Simulating stock..."));
+
+    auto watcher {new QFutureWatcher<StockSimulation>(this)};
+    connect(watcher, &QFutureWatcherBase::finished, this, [this, watcher]()
+    {
+        const StockSimulation simulation {watcher->result()};
+        watcher->deleteLater();
+        statusbar->clearMessage();
+        actionSimulateStock->setEnabled(true);
+
+        auto dialog {new StockView(simulation.image, simulation.summary, this)};
+        dialog->setAttribute(Qt::WA_DeleteOnClose);
+        dialog->show();
+    });
+    watcher->setFuture(QtConcurrent::run(&m_workers, [this, tools = *tools, lines = std::move(lines)]()
+    {
+        StockSimulator simulator;
+        for (const auto& [number, tool] : tools)
+            simulator.setTool(number, tool);
+        Controller controller;
+        controller.setListener(&simulator);
+        // in slices, so closing the window need not wait for the whole program
+        controller.setBudget({std::chrono::milliseconds{100}, 0});
+        for (const auto& line : lines)
+            controller.addLine(line);
+        controller.run();
+        while (controller.stopReason() == Controller::StopReason::Budget)
+        {
+            if (m_closing)
+                return StockSimulation{};
+            controller.resume();
+        }
+        return StockSimulation{StockView::render(simulator), StockView::summary(simulator)};
+    }));
+}
+
+void MainWindow::on_actionTransform_triggered()
+{
+    auto view {dynamic_cast<DocumentView*>(tabWidget->currentWidget())};
+    if (!view)
+        return;
+
+    TransformDialog dialog {this};
+    if (dialog.exec() != QDialog::Accepted)
+        return;
+
+    std::istringstream in {view->document()->toPlainText().toStdString()};
+    std::ostringstream out;
+    const auto result {ProgramTransform{dialog.options()}.transform(in, out)};
+
+    // one undo step
+    QTextCursor cursor {view->document()};
+    cursor.select(QTextCursor::Document);
+    cursor.insertText(QString::fromStdString(out.str()));
+
+    statusbar->showMessage(tr("%1 of %2 blocks changed, %3 words with computed values and %4 blocks with alarms kept.")
+                           .arg(result.changedBlocks).arg(result.blockCount).arg(result.skippedWords).arg(result.alarmCount));
+}
+
 void MainWindow::on_actionExit_triggered()
 {
     //TODO: check for modified
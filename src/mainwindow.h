@@ -2,10 +2,17 @@
 #define MAINWINDOW_H
 
 #include "ui_mainwindow.h"
+#include "crossreferenceindex.h"
+#include "evaluationcache.h"
 
 #include <QMainWindow>
+#include <QThreadPool>
+
+#include <atomic>
+#include <optional>
 
 class DocumentView;
+class QLabel;
 class QTabWidget;
 class QTextDocument;
 
@@ -15,16 +22,28 @@ class MainWindow : public QMainWindow, private Ui::MainWindow
 
 public:
     explicit MainWindow(QWidget *parent = nullptr);
+    ~MainWindow() override;
 
     QSize sizeHint() const override;
     void openFile(const QString& path);
+    /**
+     * Reads, evaluates and indexes the programs on the worker threads, a tab is added as each
+     * one is ready. Programs already open are shown.
+     */
+    void openFiles(const QStringList& paths);
 
 private slots:
     void on_actionNew_triggered();
     void on_actionOpen_triggered();
+    void on_actionBrowseFolder_triggered();
+    void on_actionVerifyFolder_triggered();
     void on_actionSave_triggered();
     void on_actionSaveAs_triggered();
     void on_actionClose_triggered();
+    void on_actionExportMotionLog_triggered();
+    void on_actionImportMotionLog_triggered();
+    void on_actionSimulateStock_triggered();
+    void on_actionTransform_triggered();
     void on_actionExit_triggered();
     void onDocumentModificationChange(bool);
     void onDocumentChange();
@@ -33,12 +52,24 @@ private slots:
 
 private:
 
+    int findTab(const QString& path) const;
+    void addDocumentTab(const QString& path, const QString& text, std::optional<CrossReferenceIndex> crossReferences,
+                        bool select);
     void saveDocument(int index, bool saveAs);
     void closeTab(int index);
     QTextDocument* currentDocument() const;
     QTextDocument* documentAt(int index) const;
 
     void adoptUIToDocument(int index);
-    DocumentView* createNewView(const QString& text = QString());
+    void showCycleTime(double seconds);
+    DocumentView* createNewView(const QString& text = QString(), EvaluationCache* cache = nullptr,
+                                std::optional<CrossReferenceIndex> crossReferences = std::nullopt);
+
+    EvaluationCache m_evaluationCache;
+    // for the background work of the window, finished before the window is destroyed
+    QThreadPool m_workers;
+    std::atomic<bool> m_closing {false};
+    QLabel* m_cycleTimeLabel;
+    QString m_toolTable {"T1=F10"};
 };
 #endif // MAINWINDOW_H
@@ -0,0 +1,104 @@
+#include "motionlist.h"
+#include "geometry.h"
+
+static_assert(sizeof(MotionList::Item) == 40, "a motion takes a row of the columns");
+
+void MotionList::clear() noexcept
+{
+    m_firstPoint = glm::dvec3 {0.0};
+    m_items.clear();
+    m_arcs.clear();
+    m_currentBlockNumber = 0;
+}
+
+void MotionList::shrinkToFit()
+{
+    m_items.shrink_to_fit();
+    m_arcs.shrink_to_fit();
+}
+
+MotionList::AnyMotion MotionList::motion(size_t index) const
+{
+    const Item& item {m_items[index]};
+    if (item.arc == noArc)
+        return LinearMotion {item.endPoint, item.feed};
+    const Arc& arc {m_arcs[item.arc]};
+    if (arc.helical)
+        return HelicalMotion {arc.helix, item.feed};
+    return CircularMotion {DirectedArc3 {arc.helix.arc2, arc.helix.transform, arc.helix.zStart}, item.feed};
+}
+
+void MotionList::replay(size_t index, ControllerListener& listener) const
+{
+    std::visit([&listener](const auto& motion)
+    {
+        using T = std::decay_t<decltype(motion)>;
+        if constexpr (std::is_same_v<T, LinearMotion>)
+            listener.linearMotion(motion);
+        else if constexpr (std::is_same_v<T, CircularMotion>)
+            listener.circularMotion(motion);
+        else
+            listener.helicalMotion(motion);
+    }, motion(index));
+}
+
+size_t MotionList::pointCount(size_t index) const
+{
+    constexpr size_t arcPoints {100}; // TODO adaptive precision
+    const Item& item {m_items[index]};
+    if (item.arc == noArc)
+        return 1;
+    return arcPoints * (m_arcs[item.arc].helix.turn + 1) - 1;
+}
+
+void MotionList::samplePoints(size_t index, glm::dvec3* points) const
+{
+    const Item& item {m_items[index]};
+    if (item.arc == noArc)
+    {
+        *points = item.endPoint;
+        return;
+    }
+    const Arc& arc {m_arcs[item.arc]};
+    if (arc.helical)
+        HelixSampler {arc.helix}.sampleN(pointCount(index), points);
+    else
+        DirectedArc3Sampler {DirectedArc3 {arc.helix.arc2, arc.helix.transform, arc.helix.zStart}}
+            .sampleN(pointCount(index), points);
+}
+
+void MotionList::startPoint(const glm::dvec3& point)
+{
+    clear();
+    m_firstPoint = point;
+}
+
+void MotionList::blockChange(size_t blockNumber)
+{
+    m_currentBlockNumber = static_cast<uint32_t>(blockNumber);
+}
+
+void MotionList::linearMotion(const LinearMotion& linearMotion)
+{
+    m_items.push_back({linearMotion.getEndPoint(), linearMotion.getFeed(), m_currentBlockNumber, noArc});
+}
+
+void MotionList::circularMotion(const CircularMotion& circularMotion)
+{
+    const DirectedArc3& arc {circularMotion.getArc()};
+    const glm::dvec3 endPoint {arc.transform * glm::dvec4(arc.arc2.point2, arc.z, 1.0)};
+    m_items.push_back({endPoint, circularMotion.getFeed(), m_currentBlockNumber, static_cast<uint32_t>(m_arcs.size())});
+    m_arcs.push_back({Helix {arc.arc2, arc.transform, arc.z, arc.z, 0}, false});
+}
+
+void MotionList::helicalMotion(const HelicalMotion& helicalMotion)
+{
+    const Helix& helix {helicalMotion.getHelix()};
+    const glm::dvec3 endPoint {helix.transform * glm::dvec4(helix.arc2.point2, helix.zEnd, 1.0)};
+    m_items.push_back({endPoint, helicalMotion.getFeed(), m_currentBlockNumber, static_cast<uint32_t>(m_arcs.size())});
+    m_arcs.push_back({helix, true});
+}
+
+void MotionList::endOfProgram()
+{
+}
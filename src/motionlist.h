@@ -0,0 +1,72 @@
+#ifndef MOTIONLIST_H
+#define MOTIONLIST_H
+
+#include "controller.h"
+#include "motion.h"
+
+#include <glm/vec3.hpp>
+
+#include <cstdint>
+#include <variant>
+#include <vector>
+
+/**
+ * Records the motions of a program run, so they can be processed after the evaluation.
+ * Like the columns of the motion log, a motion takes 40 bytes, circular and helical motions
+ * keep their arc in a separate array.
+ */
+class MotionList : public ControllerListener
+{
+public:
+    using AnyMotion = std::variant<LinearMotion, CircularMotion, HelicalMotion>;
+    struct Item
+    {
+        glm::dvec3 endPoint;
+        double feed;
+        uint32_t blockNumber;
+        uint32_t arc; // in arcs(), noArc for linear motions
+    };
+    static constexpr uint32_t noArc {0xffffffff};
+    struct Arc
+    {
+        Helix helix; // circular motions have no height and turns
+        bool helical;
+    };
+
+    void clear() noexcept;
+    const glm::dvec3& firstPoint() const noexcept { return m_firstPoint; }
+    const std::vector<Item>& items() const noexcept { return m_items; }
+    const std::vector<Arc>& arcs() const noexcept { return m_arcs; }
+    /** Frees the capacity the recording reserved beyond the motions. */
+    void shrinkToFit();
+
+    /** The recorded motion as reported. */
+    AnyMotion motion(size_t index) const;
+    /** Reports the motion to the listener like the controller did. */
+    void replay(size_t index, ControllerListener& listener) const;
+
+    /**
+     * Number of points a motion is plotted with, its start point not counted.
+     */
+    size_t pointCount(size_t index) const;
+    /**
+     * Samples the pointCount(index) plotted points of a motion, without its start point.
+     */
+    void samplePoints(size_t index, glm::dvec3* points) const;
+
+    // ControllerListener interface
+    void startPoint(const glm::dvec3& point) override;
+    void blockChange(size_t blockNumber) override;
+    void linearMotion(const LinearMotion& linearMotion) override;
+    void circularMotion(const CircularMotion& circularMotion) override;
+    void helicalMotion(const HelicalMotion& helicalMotion) override;
+    void endOfProgram() override;
+
+private:
+    glm::dvec3 m_firstPoint {0.0};
+    std::vector<Item> m_items;
+    std::vector<Arc> m_arcs;
+    uint32_t m_currentBlockNumber {};
+};
+
+#endif // MOTIONLIST_H
@@ -0,0 +1,367 @@
+#include "motionlog.h"
+
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <limits>
+#include <string_view>
+#include <type_traits>
+
+static constexpr std::string_view magic {"CNCMLOG\0", 8};
+
+static size_t align8(size_t offset)
+{
+    return (offset + 7) & ~size_t {7};
+}
+
+/**
+ * Stores an integer or double little-endian, independent of the host byte order.
+ */
+template<typename T>
+static void put(std::string& data, size_t offset, T value)
+{
+    static_assert(std::is_arithmetic_v<T> && sizeof(T) <= 8);
+    uint64_t bits {};
+    if constexpr (std::is_floating_point_v<T>)
+    {
+        static_assert(sizeof(T) == 8);
+        std::memcpy(&bits, &value, sizeof(T));
+    }
+    else
+        bits = static_cast<uint64_t>(value);
+
+    for (size_t i {0}; i < sizeof(T); i++)
+        data[offset + i] = static_cast<char>((bits >> (8 * i)) & 0xff);
+}
+
+template<typename T>
+static T get(const std::string& data, size_t offset)
+{
+    static_assert(std::is_arithmetic_v<T> && sizeof(T) <= 8);
+    uint64_t bits {};
+    for (size_t i {0}; i < sizeof(T); i++)
+        bits |= static_cast<uint64_t>(static_cast<unsigned char>(data[offset + i])) << (8 * i);
+
+    if constexpr (std::is_floating_point_v<T>)
+    {
+        T value;
+        std::memcpy(&value, &bits, sizeof(T));
+        return value;
+    }
+    else
+        return static_cast<T>(bits);
+}
+
+MotionLog::Columns MotionLog::columns(size_t motionCount, size_t arcCount, size_t traceCount)
+{
+    size_t offset {headerSize};
+    auto column = [&offset](size_t count, size_t elementSize)
+    {
+        const size_t start {offset};
+        offset = align8(offset + count * elementSize);
+        return start;
+    };
+
+    Columns c;
+    c.block = column(motionCount, sizeof(uint32_t));
+    c.type = column(motionCount, sizeof(uint8_t));
+    c.feed = column(motionCount, sizeof(double));
+    c.endPoint = column(motionCount, 3 * sizeof(double));
+    c.arc = column(motionCount, sizeof(uint32_t));
+    c.center = column(arcCount, 2 * sizeof(double));
+    c.point1 = column(arcCount, 2 * sizeof(double));
+    c.point2 = column(arcCount, 2 * sizeof(double));
+    c.direction = column(arcCount, sizeof(uint8_t));
+    c.transform = column(arcCount, 16 * sizeof(double));
+    c.zStart = column(arcCount, sizeof(double));
+    c.zEnd = column(arcCount, sizeof(double));
+    c.turn = column(arcCount, sizeof(uint32_t));
+    c.traceBlock = column(traceCount, sizeof(uint32_t));
+    c.traceMotionEnd = column(traceCount, sizeof(uint32_t));
+    c.fileSize = offset;
+    return c;
+}
+
+
+void MotionLogWriter::clear() noexcept
+{
+    m_startPoint = glm::dvec3 {0.0};
+    m_motions.clear();
+    m_arcs.clear();
+    m_trace.clear();
+    m_currentBlock = 0;
+}
+
+bool MotionLogWriter::write(std::ostream& stream) const
+{
+    const auto c {MotionLog::columns(m_motions.size(), m_arcs.size(), m_trace.size())};
+    std::string data(c.fileSize, '\0');
+
+    data.replace(0, magic.size(), magic);
+    put(data, 8, MotionLog::version);
+    put(data, 16, static_cast<uint64_t>(m_motions.size()));
+    put(data, 24, static_cast<uint64_t>(m_arcs.size()));
+    put(data, 32, static_cast<uint64_t>(m_trace.size()));
+    for (int k {0}; k < 3; k++)
+        put(data, 40 + k * sizeof(double), m_startPoint[k]);
+
+    uint32_t arc {0};
+    for (size_t i {0}; i < m_motions.size(); i++)
+    {
+        const auto& motion {m_motions[i]};
+        put(data, c.block + i * sizeof(uint32_t), motion.block);
+        put(data, c.type + i, static_cast<uint8_t>(motion.type));
+        put(data, c.feed + i * sizeof(double), motion.feed);
+        for (int k {0}; k < 3; k++)
+            put(data, c.endPoint + (3 * i + k) * sizeof(double), motion.endPoint[k]);
+        put(data, c.arc + i * sizeof(uint32_t), motion.type == MotionLog::Linear ? MotionLog::noArc : arc++);
+    }
+    for (size_t i {0}; i < m_arcs.size(); i++)
+    {
+        const auto& row {m_arcs[i]};
+        for (int k {0}; k < 2; k++)
+        {
+            put(data, c.center + (2 * i + k) * sizeof(double), row.center[k]);
+            put(data, c.point1 + (2 * i + k) * sizeof(double), row.point1[k]);
+            put(data, c.point2 + (2 * i + k) * sizeof(double), row.point2[k]);
+        }
+        put(data, c.direction + i, static_cast<uint8_t>(row.direction));
+        for (int col {0}; col < 4; col++)
+            for (int k {0}; k < 4; k++)
+                put(data, c.transform + (16 * i + 4 * col + k) * sizeof(double), row.transform[col][k]);
+        put(data, c.zStart + i * sizeof(double), row.zStart);
+        put(data, c.zEnd + i * sizeof(double), row.zEnd);
+        put(data, c.turn + i * sizeof(uint32_t), row.turn);
+    }
+    for (size_t i {0}; i < m_trace.size(); i++)
+    {
+        put(data, c.traceBlock + i * sizeof(uint32_t), m_trace[i].block);
+        put(data, c.traceMotionEnd + i * sizeof(uint32_t), m_trace[i].motionEnd);
+    }
+
+    stream.write(data.data(), static_cast<std::streamsize>(data.size()));
+    return static_cast<bool>(stream);
+}
+
+bool MotionLogWriter::write(const std::string& path) const
+{
+    std::ofstream file {path, std::ios::binary | std::ios::trunc};
+    return file && write(file);
+}
+
+void MotionLogWriter::startPoint(const glm::dvec3& point)
+{
+    clear();
+    m_startPoint = point;
+}
+
+void MotionLogWriter::blockChange(size_t blockNumber)
+{
+    m_currentBlock = static_cast<uint32_t>(blockNumber);
+    m_trace.push_back({m_currentBlock, static_cast<uint32_t>(m_motions.size())});
+}
+
+void MotionLogWriter::linearMotion(const LinearMotion& linearMotion)
+{
+    m_motions.push_back({m_currentBlock, MotionLog::Linear, linearMotion.getFeed(), linearMotion.getEndPoint()});
+    if (!m_trace.empty())
+        m_trace.back().motionEnd++;
+}
+
+void MotionLogWriter::circularMotion(const CircularMotion& circularMotion)
+{
+    const auto& arc {circularMotion.getArc()};
+    addArc(arc.arc2, arc.transform, arc.z, arc.z, 0, MotionLog::Circular, circularMotion.getFeed());
+}
+
+void MotionLogWriter::helicalMotion(const HelicalMotion& helicalMotion)
+{
+    const auto& helix {helicalMotion.getHelix()};
+    addArc(helix.arc2, helix.transform, helix.zStart, helix.zEnd, helix.turn, MotionLog::Helical, helicalMotion.getFeed());
+}
+
+void MotionLogWriter::endOfProgram()
+{
+}
+
+void MotionLogWriter::addArc(const DirectedArc2& arc2, const glm::dmat4& transform, double zStart, double zEnd, unsigned turn,
+                             MotionLog::MotionType type, double feed)
+{
+    const glm::dvec3 endPoint {transform * glm::dvec4(arc2.point2, zEnd, 1.0)};
+    m_motions.push_back({m_currentBlock, type, feed, endPoint});
+    m_arcs.push_back({arc2.center, arc2.point1, arc2.point2, arc2.dir, transform, zStart, zEnd, turn});
+    if (!m_trace.empty())
+        m_trace.back().motionEnd++;
+}
+
+
+bool MotionLogReader::read(std::string data)
+{
+    m_data = std::move(data);
+    m_motionCount = m_arcCount = m_traceCount = 0;
+
+    if (m_data.size() < MotionLog::headerSize ||
+        std::string_view(m_data).substr(0, magic.size()) != magic ||
+        get<uint32_t>(m_data, 8) != MotionLog::version)
+    {
+        m_data.clear();
+        return false;
+    }
+
+    // counts beyond 32 bits cannot be indexed by the uint32 columns
+    const auto motionCount {get<uint64_t>(m_data, 16)};
+    const auto arcCount {get<uint64_t>(m_data, 24)};
+    const auto traceCount {get<uint64_t>(m_data, 32)};
+    constexpr uint64_t maxCount {std::numeric_limits<uint32_t>::max()};
+    if (motionCount > maxCount || arcCount > maxCount || traceCount > maxCount)
+    {
+        m_data.clear();
+        return false;
+    }
+
+    m_motionCount = motionCount;
+    m_arcCount = arcCount;
+    m_traceCount = traceCount;
+    m_columns = MotionLog::columns(m_motionCount, m_arcCount, m_traceCount);
+    if (m_data.size() < m_columns.fileSize || !validate())
+    {
+        m_data.clear();
+        m_motionCount = m_arcCount = m_traceCount = 0;
+        return false;
+    }
+    return true;
+}
+
+bool MotionLogReader::read(std::istream& stream)
+{
+    return read(std::string {std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>()});
+}
+
+bool MotionLogReader::readFile(const std::string& path)
+{
+    std::ifstream file {path, std::ios::binary};
+    return file && read(file);
+}
+
+bool MotionLogReader::validate() const
+{
+    size_t arc {0};
+    for (size_t i {0}; i < m_motionCount; i++)
+    {
+        const auto motionType {get<uint8_t>(m_data, m_columns.type + i)};
+        const auto motionArc {get<uint32_t>(m_data, m_columns.arc + i * sizeof(uint32_t))};
+        if (motionType > MotionLog::Helical)
+            return false;
+        if (motionType == MotionLog::Linear ? motionArc != MotionLog::noArc : motionArc != arc++)
+            return false;
+    }
+    if (arc != m_arcCount)
+        return false;
+
+    for (size_t i {0}; i < m_arcCount; i++)
+        if (get<uint8_t>(m_data, m_columns.direction + i) > DirectedArc2::cclw)
+            return false;
+
+    uint32_t motionEnd {0};
+    for (size_t i {0}; i < m_traceCount; i++)
+    {
+        const auto end {get<uint32_t>(m_data, m_columns.traceMotionEnd + i * sizeof(uint32_t))};
+        if (end < motionEnd || end > m_motionCount)
+            return false;
+        motionEnd = end;
+    }
+    return true;
+}
+
+template<typename T>
+T MotionLogReader::value(size_t offset) const
+{
+    return get<T>(m_data, offset);
+}
+
+glm::dvec3 MotionLogReader::startPoint() const
+{
+    if (m_data.empty())
+        return glm::dvec3 {0.0};
+    return {value<double>(40), value<double>(48), value<double>(56)};
+}
+
+uint32_t MotionLogReader::block(size_t motion) const
+{
+    return value<uint32_t>(m_columns.block + motion * sizeof(uint32_t));
+}
+
+MotionLog::MotionType MotionLogReader::type(size_t motion) const
+{
+    return static_cast<MotionLog::MotionType>(value<uint8_t>(m_columns.type + motion));
+}
+
+double MotionLogReader::feed(size_t motion) const
+{
+    return value<double>(m_columns.feed + motion * sizeof(double));
+}
+
+glm::dvec3 MotionLogReader::endPoint(size_t motion) const
+{
+    const size_t offset {m_columns.endPoint + 3 * motion * sizeof(double)};
+    return {value<double>(offset), value<double>(offset + 8), value<double>(offset + 16)};
+}
+
+DirectedArc2 MotionLogReader::arc2(size_t arc) const
+{
+    auto vec2 = [this, arc](size_t column)
+    {
+        const size_t offset {column + 2 * arc * sizeof(double)};
+        return glm::dvec2 {value<double>(offset), value<double>(offset + 8)};
+    };
+    return {vec2(m_columns.center), vec2(m_columns.point1), vec2(m_columns.point2),
+            static_cast<DirectedArc2::ArcDirection>(value<uint8_t>(m_columns.direction + arc))};
+}
+
+glm::dmat4 MotionLogReader::transform(size_t arc) const
+{
+    glm::dmat4 transform;
+    for (int col {0}; col < 4; col++)
+        for (int k {0}; k < 4; k++)
+            transform[col][k] = value<double>(m_columns.transform + (16 * arc + 4 * col + k) * sizeof(double));
+    return transform;
+}
+
+void MotionLogReader::replay(ControllerListener& listener) const
+{
+    auto replayMotion = [this, &listener](size_t motion)
+    {
+        const auto arc {value<uint32_t>(m_columns.arc + motion * sizeof(uint32_t))};
+        switch (type(motion))
+        {
+        case MotionLog::Linear:
+            listener.linearMotion(LinearMotion{endPoint(motion), feed(motion)});
+            break;
+        case MotionLog::Circular:
+            listener.circularMotion(CircularMotion{DirectedArc3{arc2(arc), transform(arc),
+                                                                value<double>(m_columns.zStart + arc * sizeof(double))},
+                                                   feed(motion)});
+            break;
+        case MotionLog::Helical:
+            listener.helicalMotion(HelicalMotion{Helix{arc2(arc), transform(arc),
+                                                       value<double>(m_columns.zStart + arc * sizeof(double)),
+                                                       value<double>(m_columns.zEnd + arc * sizeof(double)),
+                                                       value<uint32_t>(m_columns.turn + arc * sizeof(uint32_t))},
+                                                 feed(motion)});
+            break;
+        }
+    };
+
+    listener.startPoint(startPoint());
+    size_t motion {0};
+    for (size_t i {0}; i < m_traceCount; i++)
+    {
+        listener.blockChange(value<uint32_t>(m_columns.traceBlock + i * sizeof(uint32_t)));
+        const auto motionEnd {value<uint32_t>(m_columns.traceMotionEnd + i * sizeof(uint32_t))};
+        for (; motion < motionEnd; motion++)
+            replayMotion(motion);
+    }
+    for (; motion < m_motionCount; motion++)
+        replayMotion(motion);
+    listener.endOfProgram();
+}
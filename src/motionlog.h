@@ -0,0 +1,184 @@
+#ifndef MOTIONLOG_H
+#define MOTIONLOG_H
+
+#include "controller.h"
+#include "motion.h"
+
+#include <glm/vec2.hpp>
+#include <glm/vec3.hpp>
+#include <glm/mat4x4.hpp>
+
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+/**
+ * Binary motion log, the evaluated toolpath of a program run.
+ *
+ * All values are little-endian. The file starts with a 64 byte header:
+ *
+ *   offset  type        content
+ *        0  char[8]     magic "CNCMLOG\0"
+ *        8  uint32      format version, currently 1
+ *       12  uint32      reserved, 0
+ *       16  uint64      motion count M
+ *       24  uint64      arc count A, number of circular and helical motions
+ *       32  uint64      trace count T, number of evaluated blocks
+ *       40  double[3]   start point
+ *
+ * The header is followed by columns, each of them starting at a multiple of 8 bytes
+ * (padded with zeros), so the file can be memory-mapped and accessed in place:
+ *
+ *   M x uint32      block     block number of the motion
+ *   M x uint8       type      0 linear, 1 circular, 2 helical
+ *   M x double      feed      0 for rapid motions
+ *   M x double[3]   endPoint  end point in machine coordinates
+ *   M x uint32      arc       row in the arc columns, 0xffffffff for linear motions
+ *   A x double[2]   center    arc center in the working plane
+ *   A x double[2]   point1    arc start point in the working plane
+ *   A x double[2]   point2    arc end point in the working plane
+ *   A x uint8       direction 0 clockwise, 1 counterclockwise
+ *   A x double[16]  transform working plane to machine coordinates, column-major
+ *   A x double      zStart    plane height at the start point
+ *   A x double      zEnd      plane height at the end point, equal to zStart for circular motions
+ *   A x uint32      turn      additional full turns of helical motions
+ *   T x uint32      traceBlock     block numbers in order of evaluation
+ *   T x uint32      traceMotionEnd number of motions up to and including this block
+ */
+namespace MotionLog
+{
+    constexpr uint32_t version {1};
+
+    enum MotionType : uint8_t
+    {
+        Linear,
+        Circular,
+        Helical
+    };
+
+    constexpr uint32_t noArc {0xffffffff};
+    constexpr size_t headerSize {64};
+
+    /**
+     * Byte offsets of the columns.
+     */
+    struct Columns
+    {
+        size_t block;
+        size_t type;
+        size_t feed;
+        size_t endPoint;
+        size_t arc;
+        size_t center;
+        size_t point1;
+        size_t point2;
+        size_t direction;
+        size_t transform;
+        size_t zStart;
+        size_t zEnd;
+        size_t turn;
+        size_t traceBlock;
+        size_t traceMotionEnd;
+        size_t fileSize;
+    };
+
+    Columns columns(size_t motionCount, size_t arcCount, size_t traceCount);
+}
+
+/**
+ * Collects the events of a program run and writes them as a motion log.
+ */
+class MotionLogWriter : public ControllerListener
+{
+public:
+    void clear() noexcept;
+    bool isEmpty() const noexcept { return m_trace.empty() && m_motions.empty(); }
+
+    bool write(std::ostream& stream) const;
+    bool write(const std::string& path) const;
+
+    // ControllerListener interface
+    void startPoint(const glm::dvec3& point) override;
+    void blockChange(size_t blockNumber) override;
+    void linearMotion(const LinearMotion& linearMotion) override;
+    void circularMotion(const CircularMotion& circularMotion) override;
+    void helicalMotion(const HelicalMotion& helicalMotion) override;
+    void endOfProgram() override;
+
+private:
+    struct MotionRow
+    {
+        uint32_t block;
+        MotionLog::MotionType type;
+        double feed;
+        glm::dvec3 endPoint;
+    };
+    struct ArcRow
+    {
+        glm::dvec2 center;
+        glm::dvec2 point1;
+        glm::dvec2 point2;
+        DirectedArc2::ArcDirection direction;
+        glm::dmat4 transform;
+        double zStart;
+        double zEnd;
+        uint32_t turn;
+    };
+    struct TraceRow
+    {
+        uint32_t block;
+        uint32_t motionEnd;
+    };
+
+    void addArc(const DirectedArc2& arc2, const glm::dmat4& transform, double zStart, double zEnd, unsigned turn,
+                MotionLog::MotionType type, double feed);
+
+    glm::dvec3 m_startPoint {0.0};
+    std::vector<MotionRow> m_motions;
+    std::vector<ArcRow> m_arcs;
+    std::vector<TraceRow> m_trace;
+    uint32_t m_currentBlock {};
+};
+
+/**
+ * Reads a motion log and reports its motions as if the program was evaluated again.
+ */
+class MotionLogReader
+{
+public:
+    bool read(std::string data);
+    bool read(std::istream& stream);
+    bool readFile(const std::string& path);
+
+    size_t motionCount() const noexcept { return m_motionCount; }
+    size_t arcCount() const noexcept { return m_arcCount; }
+    size_t traceCount() const noexcept { return m_traceCount; }
+    glm::dvec3 startPoint() const;
+
+    uint32_t block(size_t motion) const;
+    MotionLog::MotionType type(size_t motion) const;
+    double feed(size_t motion) const;
+    glm::dvec3 endPoint(size_t motion) const;
+
+    /**
+     * Calls the listener for the evaluated blocks and their motions, in the original order.
+     */
+    void replay(ControllerListener& listener) const;
+
+private:
+    bool validate() const;
+    template<typename T>
+    T value(size_t offset) const;
+    DirectedArc2 arc2(size_t arc) const;
+    glm::dmat4 transform(size_t arc) const;
+
+    std::string m_data;
+    size_t m_motionCount {};
+    size_t m_arcCount {};
+    size_t m_traceCount {};
+
+    MotionLog::Columns m_columns {};
+};
+
+#endif // MOTIONLOG_H
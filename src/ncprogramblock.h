@@ -9,136 +9,109 @@
 #include <string>
 #include <memory>
 #include <vector>
+#include <variant>
+#include <cstdint>
 
-class BlockContentVisitor;
-
-class BlockContent
-{
-public:
-    BlockContent() = default;
-    virtual ~BlockContent() = default;
-    BlockContent(const BlockContent&) = delete;
-    BlockContent& operator=(const BlockContent&) = delete;
-    BlockContent(const BlockContent&&) = delete;
-    BlockContent& operator=(const BlockContent&&) = delete;
-
-    virtual void accept(BlockContentVisitor& visitor) = 0;
-};
-
-class AddressAssign : public BlockContent
+class AddressAssign
 {
 public:
     enum CoordType : int { COORD_TYPE(DEF_TYPE_ENUM) DEFAULT };
 
-    const std::string m_address;
-    const std::unique_ptr<Expr> m_expr;
-    const CoordType m_coordType;
+    std::string m_address;
+    std::unique_ptr<Expr> m_expr;
+    CoordType m_coordType;
 
     explicit AddressAssign(std::string address, std::unique_ptr<Expr> expr, CoordType coordType = DEFAULT);
     static CoordType enumFromStr(const std::string& typeStr);
-    void accept(BlockContentVisitor& visitor) override;
 private:
     static constexpr std::array stringNames { COORD_TYPE(DEF_TYPE_STRING) "" };
 };
 
-class LValueAssign : public BlockContent
+class LValueAssign
 {
 public:
-    const std::unique_ptr<LValueExpr> m_lvalueExpr;
-    const std::unique_ptr<Expr> m_expr;
+    std::unique_ptr<LValueExpr> m_lvalueExpr;
+    std::unique_ptr<Expr> m_expr;
     explicit LValueAssign(std::unique_ptr<LValueExpr> lvalueExpr, std::unique_ptr<Expr> expr);
-    void accept(BlockContentVisitor& visitor) override;
 };
 
-class ExtAddressAssign : public BlockContent
+class ExtAddressAssign
 {
 public:
-    const std::string m_address;
-    const std::unique_ptr<Expr> m_ext;
-    const std::unique_ptr<Expr> m_expr;
+    std::string m_address;
+    std::unique_ptr<Expr> m_ext;
+    std::unique_ptr<Expr> m_expr;
 
     explicit ExtAddressAssign(std::string address,
                               std::unique_ptr<Expr> ext,
                               std::unique_ptr<Expr> expr);
-    void accept(BlockContentVisitor& visitor) override;
 };
 
-class GCommand : public BlockContent
+class GCommand
 {
 public:
     enum FuncType : int { G_COMMANDS(DEF_TYPE_ENUM) };
-    const FuncType m_type;
+    FuncType m_type;
 
     explicit GCommand(FuncType type);
     static FuncType enumFromStr(const std::string& typeStr);
-    void accept(BlockContentVisitor& visitor) override;
 private:
     static constexpr std::array stringNames { G_COMMANDS(DEF_TYPE_STRING) };
 };
 
-class GotoStmt : public BlockContent
+class GotoStmt
 {
 public:
     enum GotoType : int { GOTO_KEYWORDS(DEF_TYPE_ENUM) };
-    const GotoType m_type;
-    const std::unique_ptr<Expr> m_expr;
+    GotoType m_type;
+    std::unique_ptr<Expr> m_expr;
 
     explicit GotoStmt(GotoType type, std::unique_ptr<Expr> expr);
     static GotoType enumFromStr(const std::string& typeStr);
-    void accept(BlockContentVisitor& visitor) override;
 private:
     static constexpr std::array stringNames { GOTO_KEYWORDS(DEF_TYPE_STRING) };
 };
 
-class ConditionalGotoStmt : public BlockContent
+class ConditionalGotoStmt
 {
 public:
-    const std::unique_ptr<Expr> m_conditionExpr;
-    const std::unique_ptr<GotoStmt> m_gotoStmt;
+    std::unique_ptr<Expr> m_conditionExpr;
+    std::unique_ptr<GotoStmt> m_gotoStmt;
     std::unique_ptr<ConditionalGotoStmt> m_next {nullptr};
 
     explicit ConditionalGotoStmt(std::unique_ptr<Expr> conditionExpr, std::unique_ptr<GotoStmt> gotoStmt);
-    void accept(BlockContentVisitor& visitor) override;
 };
 
-class ForStmt : public BlockContent
+class ForStmt
 {
 public:
-    const std::unique_ptr<LValueAssign> m_assignment;
-    const std::unique_ptr<Expr> m_expr;
+    std::unique_ptr<LValueAssign> m_assignment;
+    std::unique_ptr<Expr> m_expr;
 
     explicit ForStmt(std::unique_ptr<LValueAssign> assignment, std::unique_ptr<Expr> expr);
-    void accept(BlockContentVisitor& visitor) override;
 };
 
-class EndForStmt : public BlockContent
+class EndForStmt
 {
-public:
-    void accept(BlockContentVisitor& visitor) override;
 };
 
-class IfStmt : public BlockContent
+class IfStmt
 {
 public:
-    const std::unique_ptr<Expr> m_expr;
+    std::unique_ptr<Expr> m_expr;
 
     explicit IfStmt(std::unique_ptr<Expr> expr);
-    void accept(BlockContentVisitor& visitor) override;
 };
 
-class ElseStmt : public BlockContent
+class ElseStmt
 {
-public:
-    void accept(BlockContentVisitor& visitor) override;
 };
 
-class EndIfStmt : public BlockContent
+class EndIfStmt
 {
-public:
-    void accept(BlockContentVisitor& visitor) override;
 };
 
-class DefStmt : public BlockContent
+class DefStmt
 {
 public:
     struct Def
@@ -152,51 +125,62 @@ public:
         const std::vector<s840d_int_t> arrayDimensions;
         //TODO array initializer here
     };
-    const std::vector<Def> m_defs;
-    const std::vector<ArrayDef> m_arrayDefs;
-    const ValueType m_type;
+    std::vector<Def> m_defs;
+    std::vector<ArrayDef> m_arrayDefs;
+    ValueType m_type;
 
     explicit DefStmt(std::vector<Def> defs, std::vector<ArrayDef> arrayDefs, ValueType type);
-
-    void accept(BlockContentVisitor& visitor) override;
 };
 
-class BlockContentVisitor
+/** block contents are stored by value, most frequent first */
+using BlockContent = std::variant<AddressAssign,
+                                  GCommand,
+                                  ExtAddressAssign,
+                                  LValueAssign,
+                                  DefStmt,
+                                  GotoStmt,
+                                  ConditionalGotoStmt,
+                                  ForStmt,
+                                  EndForStmt,
+                                  IfStmt,
+                                  ElseStmt,
+                                  EndIfStmt>;
+
+struct BlockNumber
 {
-public:
-    BlockContentVisitor() = default;
-    virtual ~BlockContentVisitor() = default;
-    BlockContentVisitor(const BlockContentVisitor&) = delete;
-    BlockContentVisitor& operator=(const BlockContentVisitor&) = delete;
-    BlockContentVisitor(const BlockContentVisitor&&) = delete;
-    BlockContentVisitor& operator=(const BlockContentVisitor&&) = delete;
-
-    virtual void visit(AddressAssign& addressAssign) = 0;
-    virtual void visit(ExtAddressAssign& extAddressAssign) = 0;
-    virtual void visit(LValueAssign& lvalueAssign) = 0;
-    virtual void visit(GCommand& func) = 0;
-    virtual void visit(GotoStmt& gotoStmt) = 0;
-    virtual void visit(ConditionalGotoStmt& gotoStmt) = 0;
-    virtual void visit(ForStmt& gotoStmt) = 0;
-    virtual void visit(EndForStmt& gotoStmt) = 0;
-    virtual void visit(IfStmt& ifStmt) = 0;
-    virtual void visit(ElseStmt& elseStmt) = 0;
-    virtual void visit(EndIfStmt& endIfStmt) = 0;
-    virtual void visit(DefStmt& defStmt) = 0;
+    enum BlockNumberType : uint8_t { None, Regular, Main };
+    uint32_t m_number {0}; // numeric value, or the parser's name id if m_interned
+    BlockNumberType m_type {None};
+    bool m_interned {false}; // numbers with leading zeros or more than 9 digits
 };
 
-struct BlockNumber
+/** view on block contents, the contents are owned by the parser and immutable */
+class BlockContentSpan
 {
-    enum BlockNumberType { Regular, Main };
-    std::string m_number;
-    BlockNumberType m_type {Regular};
+public:
+    BlockContentSpan() = default;
+    BlockContentSpan(const BlockContent* data, std::size_t size) :
+        m_data {data}, m_size {static_cast<uint32_t>(size)} {}
+
+    const BlockContent* begin() const noexcept { return m_data; }
+    const BlockContent* end() const noexcept { return m_data + m_size; }
+    std::size_t size() const noexcept { return m_size; }
+    bool empty() const noexcept { return m_size == 0; }
+    const BlockContent& operator[](std::size_t index) const noexcept { return m_data[index]; }
+    const BlockContent& front() const noexcept { return m_data[0]; }
+
+private:
+    const BlockContent* m_data {nullptr};
+    uint32_t m_size {0};
 };
 
 struct NCProgramBlock
 {
-    std::vector<BlockContent*> blockContent;
+    static constexpr uint32_t noLabel {0};
+
+    BlockContentSpan blockContent;
     BlockNumber blockNumber;
-    std::string label;
+    uint32_t label {noLabel}; // the parser's name id
     union
     {
         int skipLevel {-1}; // for normal blocks
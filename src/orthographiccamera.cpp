@@ -0,0 +1,202 @@
+#include "orthographiccamera.h"
+
+#include <glm/geometric.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <limits>
+
+OrthographicCamera::OrthographicCamera()
+{
+    updateScreenMatrix();
+    updateScaleMatrix();
+}
+
+void OrthographicCamera::setViewportSize(int width, int height)
+{
+    m_width = width;
+    m_height = height;
+    updateProjMatrix(m_near, m_far);
+}
+
+void OrthographicCamera::zoom(float factor, const glm::vec2& ndcPoint)
+{
+    const glm::vec3 zero = glm::inverse(m_view) * glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+    const glm::vec2 deltaNDC {ndcPoint - worldToNDC(zero)};
+
+    m_scaleFactor *= factor;
+    updateScaleMatrix();
+
+    m_trans -= (deltaNDC * (factor - 1.0f));
+    updateScreenMatrix();
+
+    updateNearFar();
+}
+
+void OrthographicCamera::rotate(float xAngle, float yAngle)
+{
+    const glm::dmat4 rotInv = glm::inverse(m_rot);
+    const glm::vec3 xScreen {rotInv * glm::vec4{1.0f, 0.0f, 0.0f, 1.0f}};
+    const glm::vec3 yScreen {rotInv * glm::vec4{0.0f, 1.0f, 0.0f, 1.0f}};
+
+    m_rot = glm::rotate(m_rot, xAngle, xScreen);
+    m_rot = glm::rotate(m_rot, yAngle, yScreen);
+
+    updateViewMatrix();
+    updateNearFar();
+}
+
+void OrthographicCamera::pan(const glm::vec2& deltaNDC)
+{
+    m_trans += deltaNDC;
+    updateScreenMatrix();
+}
+
+void OrthographicCamera::fit(const BoundingBox& box, float margin)
+{
+    if (!box.isDefined())
+        return;
+
+    m_pivotPoint = box.centerPoint();
+    updateViewMatrix();
+
+    BoundingBox b {box};
+    glm::vec2 lower {std::numeric_limits<float>::max()};
+    glm::vec2 upper {std::numeric_limits<float>::lowest()};
+    for (const auto& corner : b.corners())
+    {
+        const glm::vec2 point {m_view * glm::vec4(corner, 1.0f)};
+        lower = glm::min(lower, point);
+        upper = glm::max(upper, point);
+    }
+    // the projection maps x from [-aspect ratio, aspect ratio] and y from [-1, 1] to NDC
+    const glm::vec2 extent {glm::max(upper - lower, glm::vec2(std::numeric_limits<float>::min()))};
+    const float available {2.0f * (1.0f - 2.0f * margin)};
+    m_scaleFactor = available * std::min(calcAspectRatio() / extent.x, 1.0f / extent.y);
+    updateScaleMatrix();
+    setSceneBoundingBox(box);
+
+    m_trans = glm::vec2 {0.0f};
+    updateScreenMatrix();
+    m_trans = -worldToNDC(m_pivotPoint);
+    updateScreenMatrix();
+}
+
+void OrthographicCamera::setPivotPoint(const glm::vec3& pivotPoint)
+{
+    auto zero = glm::vec4{0.0f, 0.0f, 0.0f, 1.0f};
+    const glm::vec2 zeroProjBefore {calcViewProjectionMatrix() * zero};
+    m_pivotPoint = pivotPoint;
+    updateViewMatrix();
+    const glm::vec2 zeroProjAfter {calcViewProjectionMatrix() * zero};
+    m_trans += zeroProjBefore - zeroProjAfter;
+    updateScreenMatrix();
+    updateNearFar();
+}
+
+void OrthographicCamera::screenRay(const glm::vec2& screenPoint, glm::vec3& origin, glm::vec3& direction) const
+{
+    const glm::mat4 inverse {glm::inverse(calcViewProjectionMatrix())};
+    const glm::vec2 ndc {screenToNDC(screenPoint)};
+    const glm::vec4 nearPoint {inverse * glm::vec4(ndc, -1.0f, 1.0f)};
+    const glm::vec4 farPoint {inverse * glm::vec4(ndc, 1.0f, 1.0f)};
+    origin = glm::vec3(nearPoint) / nearPoint.w;
+    direction = glm::vec3(farPoint) / farPoint.w - origin;
+}
+
+float OrthographicCamera::pixelSize() const
+{
+    const glm::mat4 inverse {glm::inverse(calcViewProjectionMatrix())};
+    const glm::vec4 point1 {inverse * glm::vec4(0.0f, 0.0f, 0.0f, 1.0f)};
+    const glm::vec4 point2 {inverse * glm::vec4(2.0f / (float)std::max(1, m_width), 0.0f, 0.0f, 1.0f)};
+    return glm::length(glm::vec3(point2) / point2.w - glm::vec3(point1) / point1.w);
+}
+
+void OrthographicCamera::setSceneBoundingBox(const BoundingBox& b)
+{
+    m_boundingBox = b;
+    updateNearFar();
+}
+
+float OrthographicCamera::calcAspectRatio() const
+{
+    return m_height == 0 ? 1 : (float)m_width / (float)m_height;
+}
+
+void OrthographicCamera::updateScreenMatrix()
+{
+    m_screen = glm::translate(glm::mat4(1.0f), glm::vec3(m_trans, 0.0f));
+    invalidateVPMatrix();
+}
+
+void OrthographicCamera::updateProjMatrix(float _near, float _far)
+{
+    m_near = _near;
+    m_far = _far;
+    const float aspectRatio = calcAspectRatio();
+    m_proj = glm::ortho(-aspectRatio, aspectRatio, -1.0f, 1.0f, _near, _far);
+    invalidateVPMatrix();
+}
+
+void OrthographicCamera::updateViewMatrix()
+{
+    m_view = glm::translate(glm::mat4(1.0f), m_pivotPoint);
+    m_view = m_view * m_rot;
+    m_view = glm::translate(m_view, -m_pivotPoint);
+    invalidateVPMatrix();
+}
+
+void OrthographicCamera::updateScaleMatrix()
+{
+    m_scale = glm::scale(glm::mat4(1.0f), glm::vec3(m_scaleFactor));
+    invalidateVPMatrix();
+}
+
+const glm::mat4& OrthographicCamera::calcViewProjectionMatrix() const
+{
+    if (m_recalcVPMatrix)
+    {
+        m_viewProjectionMatrixCache = m_screen * m_proj * m_scale * m_view;
+        m_recalcVPMatrix = false;
+    }
+    return m_viewProjectionMatrixCache;
+}
+
+void OrthographicCamera::updateNearFar()
+{
+    if (!m_boundingBox.isDefined())
+        return;
+
+    const glm::mat4 view = m_scale * m_view;
+
+    float zMin = std::numeric_limits<float>::max();
+    float zMax = std::numeric_limits<float>::lowest();
+
+    auto& corners = m_boundingBox.corners();
+    for (auto& corner : corners)
+    {
+        float z = (view * glm::vec4(corner, 1.0f)).z;
+        zMin = std::min(zMin, z);
+        zMax = std::max(zMax, z);
+    }
+
+    zMin -= 0.01f;
+    zMax += 0.01f;
+
+    updateProjMatrix(-zMax, -zMin);
+}
+
+void OrthographicCamera::invalidateVPMatrix()
+{
+    m_recalcVPMatrix = true;
+}
+
+glm::vec2 OrthographicCamera::worldToNDC(const glm::vec3& worldPoint) const
+{
+    return glm::vec2(calcViewProjectionMatrix() * glm::vec4(worldPoint, 1.0));
+}
+
+glm::vec2 OrthographicCamera::screenToNDC(const glm::vec2& screenPoint) const
+{
+    return glm::vec2(screenPoint.x / (float)m_width * 2.0f - 1.0f, 1.0f - screenPoint.y / (float)m_height * 2.0f);
+}
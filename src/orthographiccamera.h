@@ -0,0 +1,96 @@
+#ifndef ORTHOGRAPHICCAMERA_H
+#define ORTHOGRAPHICCAMERA_H
+
+#include "boundingbox.h"
+
+#include <glm/mat4x4.hpp>
+#include <glm/vec2.hpp>
+#include <glm/vec3.hpp>
+
+/**
+ * Orthographic projection of a scene into a viewport of a given size in pixels, with zoom,
+ * panning and rotating around a pivot point in model space. Independent of any widget, so
+ * the same view can be drawn by OpenGL or in software.
+ */
+class OrthographicCamera
+{
+public:
+    OrthographicCamera();
+
+    void setViewportSize(int width, int height);
+    int width() const noexcept { return m_width; }
+    int height() const noexcept { return m_height; }
+
+    const glm::mat4& calcViewProjectionMatrix() const;
+    float nearPlane() const noexcept { return m_near; }
+    float farPlane() const noexcept { return m_far; }
+    void setPivotPoint(const glm::vec3& pivotPoint);
+
+    // set bounding box for automatic calculation of near and far planes
+    // depending on camera position and rotation
+    void setSceneBoundingBox(const BoundingBox& b);
+
+    /**
+     * Scales the view by factor, the model point under the point in NDC stays in place.
+     */
+    void zoom(float factor, const glm::vec2& ndcPoint);
+    // angles in radians around the screen axes
+    void rotate(float xAngle, float yAngle);
+    void pan(const glm::vec2& deltaNDC);
+    /**
+     * Pivots around the center of the box and scales it to fill the viewport, leaving margin
+     * (a fraction of the viewport) free on each side. Also sets the box as scene bounding box.
+     */
+    void fit(const BoundingBox& box, float margin = 0.05f);
+
+    /**
+     * The line of sight through a point in viewport pixels, in model space. The origin is on the near plane.
+     */
+    void screenRay(const glm::vec2& screenPoint, glm::vec3& origin, glm::vec3& direction) const;
+    // model space length of one pixel
+    float pixelSize() const;
+
+    glm::vec2 worldToNDC(const glm::vec3& worldPoint) const;
+    glm::vec2 screenToNDC(const glm::vec2& screenPoint) const;
+
+private:
+    int m_width {1};
+    int m_height {1};
+
+    // camera position and rotation matrix.
+    // Note: position of the camera is always determined by
+    // rotating the origin (0,0,0) around the pivot point
+    glm::mat4 m_view {1.0f};
+
+    // orthographic scale matrix, separate from the view matrix
+    glm::mat4 m_scale {1.0f};
+
+    // orthographic projection matrix
+    glm::mat4 m_proj {1.0f};
+
+    // projected view offset
+    glm::mat4 m_screen {1.0f};
+
+    float m_scaleFactor {0.01f};
+    float m_near {-1.0f};
+    float m_far {1.0f};
+
+    glm::vec2 m_trans {0.0f};
+    glm::mat4 m_rot {1.0f};
+
+    BoundingBox m_boundingBox;
+    glm::vec3 m_pivotPoint {0.0f};
+
+    mutable glm::mat4 m_viewProjectionMatrixCache {1.0f};
+    mutable bool m_recalcVPMatrix {true};
+
+    float calcAspectRatio() const;
+    void updateScreenMatrix();
+    void updateProjMatrix(float _near, float _far);
+    void updateViewMatrix();
+    void updateScaleMatrix();
+    void updateNearFar();
+    void invalidateVPMatrix();
+};
+
+#endif // ORTHOGRAPHICCAMERA_H
@@ -0,0 +1,36 @@
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include <algorithm>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+/**
+ * Calls func(begin, end) for consecutive ranges covering [0, count), one range per hardware thread.
+ * Ranges are not made smaller than minChunk. func must not throw.
+ */
+template <typename Func>
+void parallelFor(std::size_t count, std::size_t minChunk, Func func)
+{
+    const std::size_t threadCount {std::max(1u, std::thread::hardware_concurrency())};
+    const std::size_t chunkCount {std::min(threadCount, (count + minChunk - 1) / std::max<std::size_t>(minChunk, 1))};
+    if (chunkCount <= 1)
+    {
+        if (count > 0)
+            func(std::size_t {0}, count);
+        return;
+    }
+
+    const std::size_t chunkSize {(count + chunkCount - 1) / chunkCount};
+    std::vector<std::thread> threads;
+    threads.reserve(chunkCount - 1);
+    for (std::size_t begin {chunkSize}; begin < count; begin += chunkSize)
+        threads.emplace_back(func, begin, std::min(begin + chunkSize, count));
+    func(std::size_t {0}, chunkSize);
+
+    for (auto& thread : threads)
+        thread.join();
+}
+
+#endif // PARALLEL_H
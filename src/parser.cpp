@@ -7,15 +7,19 @@
 #include <parsertl/lookup.hpp>
 #include <parsertl/debug.hpp>
 
+#include <charconv>
+
 
 struct ParserContext
 {
     NCProgramBlock& currentBlock;
+    std::vector<BlockContent>& content;
     int& currentNestingLevel;
     std::vector<std::any>& stack;
     parsertl::state_machine& gsm;
     parsertl::match_results& results;
     parsertl::token<lexertl::citerator>::token_vector& productions;
+    bool cacheable {true};
 
     auto& token(std::size_t index) const
     {
@@ -110,6 +114,19 @@ static void createBinary(ParserContext& context, BinaryOpExpr::BinaryOp binOp)
         new BinaryOpExpr(std::unique_ptr<Expr>(lhs), std::unique_ptr<Expr>(rhs), binOp)));
 }
 
+template <typename T, typename... Args>
+static std::any makeContent(Args&&... args)
+{
+    return std::make_any<BlockContent*>(new BlockContent{std::in_place_type<T>, std::forward<Args>(args)...});
+}
+
+template <typename T>
+static std::unique_ptr<T> takeContent(const std::any& item)
+{
+    std::unique_ptr<BlockContent> content {std::any_cast<BlockContent*>(item)};
+    return std::make_unique<T>(std::get<T>(std::move(*content)));
+}
+
 static void createUnary(ParserContext& context, UnaryOpExpr::UnaryOp unaryOp)
 {
     Expr* expr {std::any_cast<Expr*>(context.stack.back())};
@@ -133,10 +150,42 @@ static void addLexerRules(const std::vector<Token>& tokens,
     }
 }
 
-static void checkControlStructureBlock (const NCProgramBlock& block)
+static Parser::TokenCategory tokenCategory(std::string_view name)
 {
-    if (!block.label.empty() || block.skipLevel >= 0)
+    using Category = Parser::TokenCategory;
+    static const std::unordered_map<std::string_view, Category> categories {
+        {"INTEGER", Category::Number}, {"INTEGER_BIN", Category::Number}, {"INTEGER_HEX", Category::Number},
+        {"FLOAT", Category::Number}, {"FLOAT_EX", Category::Number},
+        {"STRING_LITERAL", Category::String},
+        {"'G'", Category::GFunction}, {"FUNC", Category::GFunction},
+        {"'D'", Category::AuxiliaryFunction}, {"ADDRESS_LETTER_EXT_AUX", Category::AuxiliaryFunction},
+        {"ADDRESS_LETTER_EXT_1", Category::AddressLetter}, {"ADDRESS_LETTER_EXT_2", Category::AddressLetter},
+        {"ADDRESS_NO_AX_EXT", Category::AddressLetter},
+        {"'N'", Category::BlockNumber},
+        {"'R'", Category::Identifier}, {"IDENTIFIER", Category::Identifier},
+        {"ARITHMETIC_FUNC", Category::Function},
+        {"DIV", Category::Keyword}, {"MOD", Category::Keyword}, {"AND", Category::Keyword},
+        {"OR", Category::Keyword}, {"XOR", Category::Keyword}, {"NOT", Category::Keyword},
+        {"B_AND", Category::Keyword}, {"B_OR", Category::Keyword}, {"B_XOR", Category::Keyword},
+        {"B_NOT", Category::Keyword}, {"COORD_TYPE", Category::Keyword}, {"IF", Category::Keyword},
+        {"ELSE", Category::Keyword}, {"ENDIF", Category::Keyword}, {"FOR", Category::Keyword},
+        {"TO", Category::Keyword}, {"ENDFOR", Category::Keyword}, {"DEF", Category::Keyword},
+        {"PROC", Category::Keyword}, {"RET", Category::Keyword}, {"TYPE_STRING", Category::Keyword},
+        {"TYPE_OTHER", Category::Keyword}, {"GOTO", Category::Keyword},
+    };
+
+    auto it {categories.find(name)};
+    return it != categories.end() ? it->second : Category::Other;
+}
+
+static void checkControlStructureBlock (ParserContext& context)
+{
+    const NCProgramBlock& block {context.currentBlock};
+    if (block.label != NCProgramBlock::noLabel || block.skipLevel >= 0)
         throw S840D_Alarm{12630}; //skip ID/label in control structure not allowed
+
+    // nesting level depends on the surrounding blocks
+    context.cacheable = false;
 }
 
 Parser::Parser()
@@ -173,13 +222,18 @@ Parser::Parser()
     m_semanticActionMap[ m_grules.push("block_content_opt", "words")] = [](ParserContext& context)
     {
         std::vector<BlockContent*>* words {std::any_cast<std::vector<BlockContent*>*>(context.stack.back())};
-        context.currentBlock.blockContent = std::move(*words);
+        for (auto word : *words)
+        {
+            context.content.push_back(std::move(*word));
+            delete word;
+        }
         delete words;
     };
     m_semanticActionMap[ m_grules.push("block_content_opt", "stmt")] = [](ParserContext& context)
     {
-        context.currentBlock.blockContent.push_back(std::any_cast<BlockContent*>(context.stack.back()));
+        std::unique_ptr<BlockContent> stmt {std::any_cast<BlockContent*>(context.stack.back())};
         context.stack.pop_back();
+        context.content.push_back(std::move(*stmt));
     };
 
     m_grules.push("block_content_opt", "%empty");
@@ -203,9 +257,9 @@ Parser::Parser()
     {
         Value v {std::any_cast<Value>(context.stack.back())};
         context.stack.pop_back();
-        context.stack.push_back(std::make_any<BlockContent*>(
-            new AddressAssign(context.token(0).str(),
-                              std::make_unique<LiteralExpr>(v))));
+        context.stack.push_back(
+            makeContent<AddressAssign>(context.token(0).str(),
+                                       std::make_unique<LiteralExpr>(v)));
     };
     m_semanticActionMap[ m_grules.push("word", "ADDRESS_LETTER_EXT_1 num")] = literalAddressAssign;
     m_semanticActionMap[ m_grules.push("word", "ADDRESS_LETTER_EXT_AUX num")] = literalAddressAssign;
@@ -213,19 +267,19 @@ Parser::Parser()
     {
         Value v {std::any_cast<Value>(context.stack.back())};
         context.stack.pop_back();
-        context.stack.push_back(std::make_any<BlockContent*>(
-            new AddressAssign(context.token(0).str(),
-                              std::make_unique<UnaryOpExpr>(
-                                  std::make_unique<LiteralExpr>(v), UnaryOpExpr::UMINUS))));
+        context.stack.push_back(
+            makeContent<AddressAssign>(context.token(0).str(),
+                                       std::make_unique<UnaryOpExpr>(
+                                           std::make_unique<LiteralExpr>(v), UnaryOpExpr::UMINUS)));
     };
     m_semanticActionMap[ m_grules.push("word", "address_letter '+' num")] = literalAddressAssign;
     auto exprAddressAssign = [](ParserContext& context)
     {
         std::unique_ptr<Expr> v {std::any_cast<Expr*>(context.stack.back())};
         context.stack.pop_back();
-        context.stack.push_back(std::make_any<BlockContent*>(
-            new AddressAssign(context.token(0).str(),
-                              std::move(v))));
+        context.stack.push_back(
+            makeContent<AddressAssign>(context.token(0).str(),
+                                       std::move(v)));
     };
     auto exprAddressAssignCoordType = [](ParserContext& context)
     {
@@ -234,8 +288,8 @@ Parser::Parser()
         auto coordTypeStr {context.token(2).str()};
         to_upper(coordTypeStr);
         auto coordType {AddressAssign::enumFromStr(coordTypeStr)};
-        context.stack.push_back(std::make_any<BlockContent*>(
-            new AddressAssign(context.token(0).str(), std::move(expr), coordType)));
+        context.stack.push_back(
+            makeContent<AddressAssign>(context.token(0).str(), std::move(expr), coordType));
     };
     m_semanticActionMap[ m_grules.push("word", "address_letter '=' expr")] = exprAddressAssign;
     m_semanticActionMap[ m_grules.push("word", "address_letter '=' COORD_TYPE '(' expr ')'")] = exprAddressAssignCoordType;
@@ -244,8 +298,8 @@ Parser::Parser()
     {
         std::unique_ptr<Expr> expr {std::any_cast<Expr*>(context.stack.back())};
         context.stack.pop_back();
-        context.stack.push_back(std::make_any<BlockContent*>(
-            new AddressAssign(context.token(0).str() + context.token(1).str(), std::move(expr))));
+        context.stack.push_back(
+            makeContent<AddressAssign>(context.token(0).str() + context.token(1).str(), std::move(expr)));
     };
     auto exprExtAddressAssignCoordType = [](ParserContext& context)
     {
@@ -254,8 +308,8 @@ Parser::Parser()
         auto coordTypeStr {context.token(3).str()};
         to_upper(coordTypeStr);
         auto coordType {AddressAssign::enumFromStr(coordTypeStr)};
-        context.stack.push_back(std::make_any<BlockContent*>(
-            new AddressAssign(context.token(0).str() + context.token(1).str(), std::move(expr), coordType)));
+        context.stack.push_back(
+            makeContent<AddressAssign>(context.token(0).str() + context.token(1).str(), std::move(expr), coordType));
     };
     m_semanticActionMap[ m_grules.push("word", "ADDRESS_LETTER_EXT_1 INTEGER '=' expr")] = exprExtAddressAssign;
     m_semanticActionMap[ m_grules.push("word", "ADDRESS_LETTER_EXT_1 INTEGER '=' COORD_TYPE '(' expr ')'")] = exprExtAddressAssignCoordType;
@@ -266,17 +320,17 @@ Parser::Parser()
         context.stack.pop_back();
         std::unique_ptr<Expr> extExpr {std::any_cast<Expr*>(context.stack.back())};
         context.stack.pop_back();
-        context.stack.push_back(std::make_any<BlockContent*>(
-            new ExtAddressAssign(context.token(0).str(), std::move(extExpr), std::move(expr))));
+        context.stack.push_back(
+            makeContent<ExtAddressAssign>(context.token(0).str(), std::move(extExpr), std::move(expr)));
     };
     auto integerAddressAssign = [](ParserContext& context)
     {
         try
         {
             int i = std::stoi(context.token(1).str());
-            context.stack.push_back(std::make_any<BlockContent*>(
-                new AddressAssign(context.token(0).str(),
-                                  std::make_unique<LiteralExpr>(Value{i}))));
+            context.stack.push_back(
+                makeContent<AddressAssign>(context.token(0).str(),
+                                           std::make_unique<LiteralExpr>(Value{i})));
         }
         catch (std::out_of_range&)
         {
@@ -293,10 +347,10 @@ Parser::Parser()
             std::unique_ptr<Expr> expr {std::any_cast<Expr*>(context.stack.back())};
             context.stack.pop_back();
             int i = std::stoi(context.token(2).str());
-            context.stack.push_back(std::make_any<BlockContent*>(
-                new ExtAddressAssign(context.token(0).str(),
-                                     std::make_unique<LiteralExpr>(Value{i}),
-                                     std::move(expr))));
+            context.stack.push_back(
+                makeContent<ExtAddressAssign>(context.token(0).str(),
+                                              std::make_unique<LiteralExpr>(Value{i}),
+                                              std::move(expr)));
         }
         catch (std::out_of_range&)
         {
@@ -310,9 +364,9 @@ Parser::Parser()
         context.stack.pop_back();
         auto id {context.token(0).str()};
 
-        context.stack.push_back(std::make_any<BlockContent*>(
-            new LValueAssign(std::make_unique<VariableExpr>(id),
-                             std::move(expr))));
+        context.stack.push_back(
+            makeContent<LValueAssign>(std::make_unique<VariableExpr>(id),
+                                      std::move(expr)));
     };
     m_semanticActionMap[ m_grules.push("assignment", "r_param '=' expr")] = [](ParserContext& context)
     {
@@ -321,9 +375,9 @@ Parser::Parser()
         auto i {std::any_cast<int>(context.stack.back())};
         context.stack.pop_back();
 
-        context.stack.push_back(std::make_any<BlockContent*>(
-            new LValueAssign(std::make_unique<ArrayExpr>("R", std::vector<Expr*>{new LiteralExpr(i)}),
-                             std::move(expr))));
+        context.stack.push_back(
+            makeContent<LValueAssign>(std::make_unique<ArrayExpr>("R", std::vector<Expr*>{new LiteralExpr(i)}),
+                                      std::move(expr)));
     };
     m_semanticActionMap[ m_grules.push("assignment", "array_expr '=' expr")] = [](ParserContext& context)
     {
@@ -332,8 +386,8 @@ Parser::Parser()
         std::unique_ptr<ArrayExpr> arrayExpr {static_cast<ArrayExpr*>(std::any_cast<Expr*>(context.stack.back()))};
         context.stack.pop_back();
 
-        context.stack.push_back(std::make_any<BlockContent*>(
-            new LValueAssign(std::move(arrayExpr), std::move(expr))));
+        context.stack.push_back(
+            makeContent<LValueAssign>(std::move(arrayExpr), std::move(expr)));
     };
     m_semanticActionMap[ m_grules.push("word", "FUNC")] = [](ParserContext& context)
     {
@@ -344,8 +398,8 @@ Parser::Parser()
         if (func < 0)
             throw std::runtime_error("can not construct object from " + funcStr);
 
-        context.stack.push_back(std::make_any<BlockContent*>(
-            new GCommand(func)));
+        context.stack.push_back(
+            makeContent<GCommand>(func));
     };
 
     m_grules.push("address_letter", "ADDRESS_LETTER_EXT_1 | ADDRESS_LETTER_EXT_2 | ADDRESS_LETTER_EXT_AUX");
@@ -657,22 +711,22 @@ Parser::Parser()
 
     m_semanticActionMap[ m_grules.push("conditional_goto_stmt", "IF expr goto_stmt")] = [](ParserContext& context)
     {
-        auto gotoStmt {dynamic_cast<GotoStmt*>(std::any_cast<BlockContent*>(context.stack.back()))};
+        auto gotoStmt {takeContent<GotoStmt>(context.stack.back())};
         context.stack.pop_back();
         auto expr {std::any_cast<Expr*>(context.stack.back())};
         context.stack.pop_back();
 
-        context.stack.push_back(std::make_any<BlockContent*>(
-            new ConditionalGotoStmt(std::unique_ptr<Expr>{expr},
-                                    std::unique_ptr<GotoStmt>{gotoStmt})));
+        context.stack.push_back(
+            makeContent<ConditionalGotoStmt>(std::unique_ptr<Expr>{expr},
+                                             std::move(gotoStmt)));
     };
 
     m_semanticActionMap[ m_grules.push("conditional_goto_stmts", "conditional_goto_stmts conditional_goto_stmt")] = [](ParserContext& context)
     {
-        auto gotoStmtNext {dynamic_cast<ConditionalGotoStmt*>(std::any_cast<BlockContent*>(context.stack.back()))};
+        auto gotoStmtNext {takeContent<ConditionalGotoStmt>(context.stack.back())};
         context.stack.pop_back();
-        auto gotoStmt {dynamic_cast<ConditionalGotoStmt*>(std::any_cast<BlockContent*>(context.stack.back()))};
-        gotoStmt->m_next.reset(gotoStmtNext);
+        auto gotoStmt {std::get_if<ConditionalGotoStmt>(std::any_cast<BlockContent*>(context.stack.back()))};
+        gotoStmt->m_next = std::move(gotoStmtNext);
     };
 
     m_grules.push("conditional_goto_stmts", "conditional_goto_stmt");
@@ -692,9 +746,9 @@ Parser::Parser()
         auto keyword {context.token(0).str()};
         to_upper(keyword);
 
-        context.stack.push_back(std::make_any<BlockContent*>(
-            new GotoStmt(GotoStmt::enumFromStr(keyword),
-                         std::unique_ptr<Expr>{expr})));
+        context.stack.push_back(
+            makeContent<GotoStmt>(GotoStmt::enumFromStr(keyword),
+                                  std::unique_ptr<Expr>{expr}));
     };
     m_semanticActionMap[ m_grules.push("goto_stmt", "GOTO 'N' INTEGER")] = [](ParserContext& context)
     {
@@ -703,66 +757,66 @@ Parser::Parser()
 
         std::unique_ptr<Expr> expr {
             new LiteralExpr{context.token(2).str()}};
-        context.stack.push_back(std::make_any<BlockContent*>(
-            new GotoStmt(GotoStmt::enumFromStr(keyword),
-                         std::move(expr))));
+        context.stack.push_back(
+            makeContent<GotoStmt>(GotoStmt::enumFromStr(keyword),
+                                  std::move(expr)));
     };
     m_semanticActionMap[ m_grules.push("for_stmt", "FOR assignment TO expr")] = [](ParserContext& context)
     {
-        checkControlStructureBlock(context.currentBlock);
+        checkControlStructureBlock(context);
 
         context.currentNestingLevel++;
         context.currentBlock.nestingLevel = context.currentNestingLevel;
 
         auto expr {std::any_cast<Expr*>(context.stack.back())};
         context.stack.pop_back();
-        auto assignment {std::any_cast<BlockContent*>(context.stack.back())};
+        auto assignment {takeContent<LValueAssign>(context.stack.back())};
         context.stack.pop_back();
-        context.stack.push_back(std::make_any<BlockContent*>(
-            new ForStmt(std::unique_ptr<LValueAssign>(dynamic_cast<LValueAssign*>(assignment)),
-                        std::unique_ptr<Expr>(expr))));
+        context.stack.push_back(
+            makeContent<ForStmt>(std::move(assignment),
+                                 std::unique_ptr<Expr>(expr)));
     };
 
     m_semanticActionMap[ m_grules.push("endfor_stmt", "ENDFOR")] = [](ParserContext& context)
     {
-        checkControlStructureBlock(context.currentBlock);
+        checkControlStructureBlock(context);
 
         context.currentBlock.nestingLevel = context.currentNestingLevel;
         context.currentNestingLevel--;
 
-        context.stack.push_back(std::make_any<BlockContent*>(new EndForStmt()));
+        context.stack.push_back(makeContent<EndForStmt>());
     };
 
     m_semanticActionMap[ m_grules.push("if_stmt", "IF expr")] = [](ParserContext& context)
     {
-        checkControlStructureBlock(context.currentBlock);
+        checkControlStructureBlock(context);
 
         context.currentNestingLevel++;
         context.currentBlock.nestingLevel = context.currentNestingLevel;
 
         auto expr {std::any_cast<Expr*>(context.stack.back())};
         context.stack.pop_back();
-        context.stack.push_back(std::make_any<BlockContent*>(
-            new IfStmt(std::unique_ptr<Expr>(expr))));
+        context.stack.push_back(
+            makeContent<IfStmt>(std::unique_ptr<Expr>(expr)));
     };
 
     m_semanticActionMap[ m_grules.push("else_stmt", "ELSE")] = [](ParserContext& context)
     {
-        checkControlStructureBlock(context.currentBlock);
+        checkControlStructureBlock(context);
 
         context.currentBlock.nestingLevel = context.currentNestingLevel;
 
-        context.stack.push_back(std::make_any<BlockContent*>(new ElseStmt()));
+        context.stack.push_back(makeContent<ElseStmt>());
     };
 
     m_semanticActionMap[ m_grules.push("endif_stmt", "ENDIF")] = [](ParserContext& context)
     {
-        checkControlStructureBlock(context.currentBlock);
+        checkControlStructureBlock(context);
 
         context.currentBlock.nestingLevel = context.currentNestingLevel;
         context.currentNestingLevel--;
 
-        context.stack.push_back(std::make_any<BlockContent*>(new EndIfStmt()));
+        context.stack.push_back(makeContent<EndIfStmt>());
     };
 
     using def_t = std::tuple<std::string, std::optional<Value>, std::optional<std::vector<s840d_int_t>>>;
@@ -794,8 +848,8 @@ Parser::Parser()
                 }
             }
 
-            context.stack.push_back(std::make_any<BlockContent*>(
-                new DefStmt(std::move(stmtDefs), std::move(stmtArrayDefs), valueType.value())));
+            context.stack.push_back(
+                makeContent<DefStmt>(std::move(stmtDefs), std::move(stmtArrayDefs), valueType.value()));
         }
         else
             throw std::runtime_error{"can not handle type " + typeStr};
@@ -896,6 +950,15 @@ Parser::Parser()
     addLexerRules(tokens, m_grules, m_lrules);
     m_lrules.push("\\s+", lexertl::rules::skip());
     lexertl::generator::build(m_lrules, m_lsm);
+
+    for (const auto* tokenList : {&tokensLeftAssoc, &tokens})
+        for (const auto& token : *tokenList)
+        {
+            const auto id {m_grules.token_id(token.name)};
+            if (id >= m_tokenCategories.size())
+                m_tokenCategories.resize(id + 1, TokenCategory::Other);
+            m_tokenCategories[id] = tokenCategory(token.name);
+        }
     //m_lsm.minimise();
     //lexertl::debug::dump(m_lsm, std::cout);
     //parsertl::debug::dump(m_grules, std::cout);
@@ -904,6 +967,100 @@ Parser::Parser()
 void Parser::reset() noexcept
 {
     nestingLevel = 0;
+
+    // keep the contents used by the previous run, a rerun after an edit will hit them
+    m_generation++;
+    for (auto it = m_contentCache.begin(); it != m_contentCache.end(); )
+    {
+        if (it->second->generation + 1 < m_generation)
+            it = m_contentCache.erase(it);
+        else
+            ++it;
+    }
+    m_uncachedContent.clear();
+    m_nameIds.clear();
+    m_names.clear();
+}
+
+/**
+ * Moves the parsed content into parser owned storage, shared by all blocks with this text if cacheable.
+ */
+BlockContentSpan Parser::storeContent(std::string_view text, bool cacheable)
+{
+    auto parsed {std::make_unique<ParsedContent>()};
+    parsed->content.reserve(m_content.size());
+    for (auto& c : m_content)
+        parsed->content.push_back(std::move(c));
+    m_content.clear();
+    parsed->generation = m_generation;
+    const BlockContentSpan span {parsed->content.data(), parsed->content.size()};
+
+    if (cacheable)
+    {
+        parsed->text = text;
+        const std::string_view key {parsed->text};
+        m_contentCache.emplace(key, std::move(parsed));
+    }
+    else
+        m_uncachedContent.push_back(std::move(parsed));
+    return span;
+}
+
+void Parser::tokenize(const char* start, const char* end, std::vector<LexicalToken>& tokens) const
+{
+    tokens.clear();
+    for (lexertl::citerator iter {start, end, m_lsm}, last; iter != last; ++iter)
+    {
+        const auto id {iter->id};
+        tokens.push_back({static_cast<std::size_t>(iter->first - start),
+                          static_cast<std::size_t>(iter->second - iter->first),
+                          id < m_tokenCategories.size() ? m_tokenCategories[id] : TokenCategory::Unknown});
+    }
+}
+
+uint32_t Parser::internName(std::string name)
+{
+    const auto id {static_cast<uint32_t>(m_nameIds.size() + 1)};
+    const auto [it, inserted] {m_nameIds.try_emplace(std::move(name), id)};
+    // the keys of an unordered_map don't move on rehashing
+    if (inserted)
+        m_names.push_back(&it->first);
+    return it->second;
+}
+
+std::optional<uint32_t> Parser::findName(const std::string& name) const
+{
+    auto it {m_nameIds.find(name)};
+    if (it == m_nameIds.end())
+        return std::nullopt;
+    return it->second;
+}
+
+const std::string& Parser::name(uint32_t id) const noexcept
+{
+    static const std::string none;
+    return id > 0 && id <= m_names.size() ? *m_names[id - 1] : none;
+}
+
+/**
+ * Returns the representation of the block number "N<digits>" as used in the parsed blocks,
+ * std::nullopt if no block can have this number.
+ */
+std::optional<BlockNumber> Parser::findBlockNumber(const std::string& digits) const
+{
+    if (digits.size() > 9 || (digits.size() > 1 && digits[0] == '0'))
+    {
+        auto id {findName(digits)};
+        if (!id.has_value())
+            return std::nullopt;
+        return BlockNumber {id.value(), BlockNumber::Regular, true};
+    }
+
+    uint32_t number {0};
+    auto [ptr, ec] {std::from_chars(digits.data(), digits.data() + digits.size(), number)};
+    if (ec != std::errc{} || ptr != digits.data() + digits.size())
+        return std::nullopt;
+    return BlockNumber {number, BlockNumber::Regular, false};
 }
 
 
@@ -942,23 +1099,42 @@ NCProgramBlock Parser::parse(const std::string& block)
     if (blockNumberOpt.has_value())
     {
         currentBlock.blockNumber = blockNumberOpt.value();
-        if (currentBlock.blockNumber.m_number.size() > 30)
-            throw S840D_Alarm{12420}; //identifier too long
     }
     p = blockNumberEnd;
 
     // read block number, if any
     auto [labelOpt, labelEnd] {readLabel(p, end)};
     if (labelOpt.has_value())
-        currentBlock.label = labelOpt.value();
+        currentBlock.label = internName(labelOpt.value());
     p = labelEnd;
 
+    // identical block contents share one AST, which is immutable after parsing
+    auto contentEnd {end};
+    while (contentEnd != p && (*(contentEnd - 1) == ' ' || *(contentEnd - 1) == '\t'))
+        contentEnd--;
+    const std::string_view contentText {p, static_cast<std::size_t>(contentEnd - p)};
+    auto cached {m_contentCache.find(contentText)};
+    if (cached != m_contentCache.end())
+    {
+        cached->second->generation = m_generation;
+        const auto& content {cached->second->content};
+        currentBlock.blockContent = BlockContentSpan{content.data(), content.size()};
+        return currentBlock;
+    }
+
+    // most blocks are plain address words, they don't need the full grammar
+    m_content.clear();
+    if (readPlainWords(p, end, m_content))
+    {
+        currentBlock.blockContent = storeContent(contentText, true);
+        return currentBlock;
+    }
+
     lexertl::citerator iter {p, end, m_lsm};
     parsertl::match_results results {iter->id, m_gsm};
     m_productions.clear();
 
-    ParserContext context {currentBlock, nestingLevel, m_stack, m_gsm, results, m_productions};
-    context.currentBlock.blockContent.reserve(10);
+    ParserContext context {currentBlock, m_content, nestingLevel, m_stack, m_gsm, results, m_productions};
 
     do
     {
@@ -1024,6 +1200,7 @@ if (0) {
         std::cout << "accept\n";
     }
 
+    currentBlock.blockContent = storeContent(contentText, context.cacheable);
     return currentBlock;
 }
 
@@ -1060,7 +1237,7 @@ std::pair<std::optional<int>, const char*> Parser::readSkipLevel(const char* sta
     return {0, p};
 }
 
-std::pair<std::optional<BlockNumber>, const char*> Parser::readBlockNumber(const char* start, const char* end) const
+std::pair<std::optional<BlockNumber>, const char*> Parser::readBlockNumber(const char* start, const char* end)
 {
     auto p = start;
     p = skipWS(p, end);
@@ -1072,10 +1249,17 @@ std::pair<std::optional<BlockNumber>, const char*> Parser::readBlockNumber(const
     auto digitStart = p;
     while (p != end && std::isdigit(static_cast<unsigned char>(*p)))
         p++;
-    if (p != digitStart)
-        return {BlockNumber {std::string{digitStart, p}, type}, p};
-
-    throw S840D_Alarm{12080};//Syntax error
+    if (p == digitStart)
+        throw S840D_Alarm{12080};//Syntax error
+    if (p - digitStart > 30)
+        throw S840D_Alarm{12420}; //identifier too long
+
+    // the number is matched as string by GOTO, keep leading zeros
+    if (p - digitStart > 9 || (p - digitStart > 1 && *digitStart == '0'))
+        return {BlockNumber {internName(std::string{digitStart, p}), type, true}, p};
+    uint32_t number {0};
+    std::from_chars(digitStart, p, number);
+    return {BlockNumber {number, type, false}, p};
 }
 
 std::pair<std::optional<std::string>, const char*> Parser::readLabel(const char* start, const char* end) const
@@ -1110,3 +1294,139 @@ std::pair<std::optional<std::string>, const char*> Parser::readLabel(const char*
     }
     return {std::nullopt, idStart};
 }
+
+/**
+ * Fast path for blocks which consist of plain address words only, like
+ * "G2 X-25.12 Y-39.804 I10.608 J0.". Creates the same block content as the grammar
+ * would do. Returns false without touching the words if there is anything else
+ * (expressions, identifiers, keywords etc.), then the block must be parsed by the grammar.
+ */
+bool Parser::readPlainWords(const char* start, const char* end, std::vector<BlockContent>& words) const
+{
+    enum AddressClass
+    {
+        NotPlain,
+        Number,         // ADDRESS_LETTER_EXT_1, ADDRESS_LETTER_EXT_AUX: X10 X-10 X+10
+        SignedNumber,   // ADDRESS_LETTER_EXT_2: L-10 L+10
+        Integer         // 'G', 'D': G1 D1
+    };
+    auto addressClass = [](char c)
+    {
+        switch (c)
+        {
+        case 'A': case 'B': case 'C': case 'E': case 'F': case 'I': case 'J': case 'K':
+        case 'U': case 'V': case 'W': case 'X': case 'Y': case 'Z':
+        case 'M': case 'S': case 'H': case 'T':
+        case 'a': case 'b': case 'c': case 'e': case 'f': case 'i': case 'j': case 'k':
+        case 'u': case 'v': case 'w': case 'x': case 'y': case 'z':
+        case 'm': case 's': case 'h': case 't':
+            return Number;
+        case 'L': case 'l':
+            return SignedNumber;
+        case 'G': case 'g': case 'D': case 'd':
+            return Integer;
+        default:
+            return NotPlain;
+        }
+    };
+    auto isBlank = [](char c)
+    {
+        return c == ' ' || c == '\t';
+    };
+    auto isDigit = [](char c)
+    {
+        return c >= '0' && c <= '9';
+    };
+
+    const auto wordsSize {words.size()};
+    auto fail = [&words, wordsSize]()
+    {
+        while (words.size() > wordsSize)
+            words.pop_back();
+        return false;
+    };
+    auto p = start;
+    for (;;)
+    {
+        while (p != end && isBlank(*p))
+            p++;
+        if (p == end)
+            break;
+
+        const char letter {*p};
+        const auto type {addressClass(letter)};
+        if (type == NotPlain)
+            return fail();
+        p++;
+        while (p != end && isBlank(*p))
+            p++;
+
+        char sign {0};
+        if (p != end && (*p == '-' || *p == '+'))
+        {
+            if (type == Integer)
+                return fail();
+            sign = *p;
+            p++;
+            while (p != end && isBlank(*p))
+                p++;
+        }
+        else if (type == SignedNumber)
+            return fail();
+
+        const auto numberStart {p};
+        while (p != end && isDigit(*p))
+            p++;
+        const auto integerEnd {p};
+        if (p != end && *p == '.')
+        {
+            if (type == Integer)
+                return fail();
+            p++;
+            while (p != end && isDigit(*p))
+                p++;
+        }
+        if (p - numberStart == 0 || (integerEnd == numberStart && p - numberStart == 1))
+            return fail(); // no digits at all
+
+        // the number must end here: anything else may continue the token
+        // (exponent, '=', '[' etc.) and is left to the grammar
+        if (p != end && !isBlank(*p) && addressClass(*p) == NotPlain)
+            return fail();
+        if (p != end && (*p == 'E' || *p == 'e'))
+            return fail();
+
+        Value value;
+        if (integerEnd == p)
+        {
+            s840d_int_t i {};
+            auto [ptr, ec] {std::from_chars(numberStart, p, i)};
+            if (ec == std::errc::result_out_of_range)
+            {
+                if (type == Integer)
+                    return fail(); // let the grammar raise the alarm
+
+                auto d {str_to_double_noexp(numberStart, p)};
+                if (!d.has_value())
+                    return fail();
+                value = d.value();
+            }
+            else
+                value = i;
+        }
+        else
+        {
+            auto d {str_to_double_noexp(numberStart, p)};
+            if (!d.has_value())
+                return fail();
+            value = d.value();
+        }
+
+        std::unique_ptr<Expr> expr {std::make_unique<LiteralExpr>(value)};
+        if (sign == '-')
+            expr = std::make_unique<UnaryOpExpr>(std::move(expr), UnaryOpExpr::UMINUS);
+        words.emplace_back(std::in_place_type<AddressAssign>, std::string(1, letter), std::move(expr));
+    }
+
+    return true;
+}
@@ -13,6 +13,9 @@
 #include <vector>
 #include <any>
 #include <map>
+#include <unordered_map>
+#include <string_view>
+#include <memory>
 //#include <functional>
 
 struct ParserContext;
@@ -30,8 +33,54 @@ class Parser
     std::vector<std::any> m_stack;
     int nestingLevel {0};
 
+    /** parsed content of one or more blocks, cached contents are shared by all blocks with the same text */
+    struct ParsedContent
+    {
+        std::string text;
+        std::vector<BlockContent> content;
+        unsigned generation;
+    };
+    std::unordered_map<std::string_view, std::unique_ptr<ParsedContent>> m_contentCache;
+    std::vector<std::unique_ptr<ParsedContent>> m_uncachedContent;
+    unsigned m_generation {0};
+    std::vector<BlockContent> m_content;
+
+    /** labels and unusual block numbers, ids start at 1 */
+    std::unordered_map<std::string, uint32_t> m_nameIds;
+    std::vector<const std::string*> m_names; // keys of m_nameIds by id - 1
+
+    BlockContentSpan storeContent(std::string_view text, bool cacheable);
+    uint32_t internName(std::string name);
+
     parsertl::rules::string_vector symbols_;
 
+public:
+    /** lexical categories of the terminals, used for syntax highlighting */
+    enum class TokenCategory : uint8_t
+    {
+        Unknown,            // no terminal matches
+        Number,
+        String,
+        GFunction,          // G and the named G functions
+        AuxiliaryFunction,  // D, M, S, H, T
+        AddressLetter,
+        BlockNumber,
+        Keyword,
+        Function,           // arithmetic functions
+        Identifier,         // variables and R parameters
+        Other,              // operators and punctuation
+    };
+
+    struct LexicalToken
+    {
+        std::size_t position;
+        std::size_t length;
+        TokenCategory category;
+    };
+
+private:
+    std::vector<TokenCategory> m_tokenCategories;
+
 public:
     Parser();
     Parser(Parser&) = delete;
@@ -43,10 +92,22 @@ public:
     void reset() noexcept;
     NCProgramBlock parse(const std::string& block);
 
+    std::optional<uint32_t> findName(const std::string& name) const;
+    /** the name of an id from a parsed block, empty if the parser has no such id */
+    const std::string& name(uint32_t id) const noexcept;
+    std::optional<BlockNumber> findBlockNumber(const std::string& digits) const;
+
     const char* skipWS(const char* start, const char* end) const noexcept;
     std::pair<std::optional<int>, const char*> readSkipLevel(const char* start, const char* end) const;
-    std::pair<std::optional<BlockNumber>, const char*> readBlockNumber(const char* start, const char* end) const;
+    std::pair<std::optional<BlockNumber>, const char*> readBlockNumber(const char* start, const char* end);
     std::pair<std::optional<std::string>, const char*> readLabel(const char* start, const char* end) const;
+    bool readPlainWords(const char* start, const char* end, std::vector<BlockContent>& words) const;
+
+    /**
+     * Splits the text into terminals with the lexer of the grammar, whitespace is skipped.
+     * The text must not contain a comment.
+     */
+    void tokenize(const char* start, const char* end, std::vector<LexicalToken>& tokens) const;
 
     template <typename T>
     static std::size_t findCommentStartPos(const typename T::const_iterator& begin,
@@ -0,0 +1,298 @@
+#include "pathrasterizer.h"
+#include "parallel.h"
+#include "plotcolors.h"
+
+#include <glm/common.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+void PathRasterizer::clear() noexcept
+{
+    m_points.clear();
+    m_colors.clear();
+    m_boundingBox.reset();
+}
+
+static uint32_t toRgb(const PlotColors::Color& color)
+{
+    return qRgb(color[0], color[1], color[2]);
+}
+
+/**
+ * Same tessellation as BackplotWidget::plot, the points of each motion go to a known offset,
+ * so the motions are sampled in parallel.
+ */
+void PathRasterizer::plot(const MotionList& motions)
+{
+    clear();
+
+    const auto& items {motions.items()};
+    std::vector<size_t> offsets(items.size());
+    size_t pointTotal {1};
+    for (size_t i {0}; i < items.size(); i++)
+    {
+        offsets[i] = pointTotal;
+        pointTotal += motions.pointCount(i);
+    }
+    m_points.resize(pointTotal);
+    m_colors.resize(pointTotal - 1);
+    m_points[0] = motions.firstPoint();
+    m_boundingBox.include(m_points[0]);
+
+    std::mutex boundingBoxMutex;
+    parallelFor(items.size(), 256, [&](size_t begin, size_t end)
+    {
+        BoundingBox boundingBox;
+        std::vector<glm::dvec3> points;
+        for (size_t i {begin}; i < end; i++)
+        {
+            const uint32_t color {toRgb(PlotColors::ofMotion(items[i]))};
+            points.resize(motions.pointCount(i));
+            motions.samplePoints(i, points.data());
+            for (size_t k {0}; k < points.size(); k++)
+            {
+                m_points[offsets[i] + k] = points[k];
+                m_colors[offsets[i] + k - 1] = color;
+                boundingBox.include(points[k]);
+            }
+        }
+
+        if (boundingBox.isDefined())
+        {
+            std::lock_guard lock {boundingBoxMutex};
+            m_boundingBox.include(boundingBox.lowerCorner());
+            m_boundingBox.include(boundingBox.upperCorner());
+        }
+    });
+}
+
+namespace
+{
+
+// far beyond any tile, lines longer than this many pixels are drawn with longer steps
+constexpr float intLimit {16777216.0f};
+
+// casting NaN or values beyond long long is undefined, NaN becomes -intLimit
+inline float clampToIntLimit(float value)
+{
+    return value > -intLimit ? (value < intLimit ? value : intLimit) : -intLimit;
+}
+
+// std::floor and std::ceil are library calls on plain x86-64
+inline long long floorToInt(float value)
+{
+    value = clampToIntLimit(value);
+    const auto truncated {static_cast<long long>(value)};
+    return truncated - (value < static_cast<float>(truncated));
+}
+
+inline long long ceilToInt(float value)
+{
+    value = clampToIntLimit(value);
+    const auto truncated {static_cast<long long>(value)};
+    return truncated + (value > static_cast<float>(truncated));
+}
+
+/**
+ * One tile of the image with its own depth buffer.
+ */
+struct Tile
+{
+    int x0;
+    int y0;
+    int x1;
+    int y1;
+    uint32_t* pixels; // of the image
+    int stride; // pixels per image line
+    std::array<float, PathRasterizer::tileSize * PathRasterizer::tileSize> depth;
+
+    /**
+     * Steps along the line one pixel at a time in the major direction, only over the part in
+     * the tile. Points are (x, y) in pixels and NDC depth, depth test like GL_LESS.
+     */
+    void drawLine(const glm::vec3& a, const glm::vec3& b, uint32_t color)
+    {
+        const glm::vec3 d {b - a};
+        // like points projected from a degenerate view
+        if (!std::isfinite(a.x) || !std::isfinite(a.y) || !std::isfinite(d.x) || !std::isfinite(d.y))
+            return;
+        float t0 {0.0f};
+        float t1 {1.0f};
+        // Liang-Barsky, p * t <= q
+        auto clip = [&t0, &t1](float p, float q)
+        {
+            if (p == 0.0f)
+                return q >= 0.0f;
+            const float r {q / p};
+            if (p < 0.0f)
+                t0 = std::max(t0, r);
+            else
+                t1 = std::min(t1, r);
+            return t0 <= t1;
+        };
+        // most segments are short and inside the tile, the others are clipped with a pixel more
+        // on each side, so rounding loses no steps at the tile borders
+        const bool inside {std::min(a.x, b.x) >= x0 && std::max(a.x, b.x) < x1 &&
+                           std::min(a.y, b.y) >= y0 && std::max(a.y, b.y) < y1};
+        if (!inside && !(clip(-d.x, a.x - (x0 - 1)) && clip(d.x, (x1 + 1) - a.x) &&
+                         clip(-d.y, a.y - (y0 - 1)) && clip(d.y, (y1 + 1) - a.y)))
+            return;
+
+        // steps of the whole line, so neighbouring tiles continue it seamlessly
+        const auto steps {static_cast<float>(std::max(1ll, ceilToInt(std::max(std::abs(d.x), std::abs(d.y)))))};
+        const float inverseSteps {1.0f / steps};
+        const long long kEnd {floorToInt(t1 * steps)};
+        for (long long k {ceilToInt(t0 * steps)}; k <= kEnd; k++)
+        {
+            const float t {static_cast<float>(k) * inverseSteps};
+            const auto x {static_cast<int>(floorToInt(a.x + t * d.x))};
+            const auto y {static_cast<int>(floorToInt(a.y + t * d.y))};
+            if (x < x0 || x >= x1 || y < y0 || y >= y1)
+                continue;
+            const float z {a.z + t * d.z};
+            float& tileDepth {depth[static_cast<size_t>((y - y0) * PathRasterizer::tileSize + x - x0)]};
+            if (z < tileDepth)
+            {
+                tileDepth = z;
+                pixels[static_cast<size_t>(y) * stride + x] = color;
+            }
+        }
+    }
+};
+
+}
+
+QImage PathRasterizer::render(const OrthographicCamera& camera) const
+{
+    const int width {camera.width()};
+    const int height {camera.height()};
+    if (width <= 0 || height <= 0)
+        return {};
+
+    QImage image {width, height, QImage::Format_RGB32};
+    // detaches once here, not in the workers
+    auto* pixels {reinterpret_cast<uint32_t*>(image.bits())};
+    const int stride {image.bytesPerLine() / 4};
+
+    const glm::mat4& viewProjection {camera.calcViewProjectionMatrix()};
+    auto toScreen = [&viewProjection, width, height](const glm::vec3& point)
+    {
+        const glm::vec4 ndc {viewProjection * glm::vec4(point, 1.0f)};
+        return glm::vec3 {(ndc.x + 1.0f) * 0.5f * width, (1.0f - ndc.y) * 0.5f * height, ndc.z};
+    };
+
+    std::vector<glm::vec3> screen(m_points.size());
+    parallelFor(m_points.size(), 16384, [&](size_t begin, size_t end)
+    {
+        for (size_t i {begin}; i < end; i++)
+            screen[i] = toScreen(m_points[i]);
+    });
+
+    std::vector<std::pair<glm::vec3, glm::vec3>> boxEdges;
+    if (m_boundingBox.isDefined())
+    {
+        BoundingBox box {m_boundingBox};
+        const auto& corners {box.corners()};
+        constexpr std::array<std::pair<int, int>, 12> edges {{
+            {BoundingBox::lower, BoundingBox::lower_upperX},
+            {BoundingBox::lower, BoundingBox::lower_upperY},
+            {BoundingBox::lower, BoundingBox::lower_upperZ},
+            {BoundingBox::lower_upperX, BoundingBox::upper_lowerZ},
+            {BoundingBox::lower_upperX, BoundingBox::upper_lowerY},
+            {BoundingBox::lower_upperY, BoundingBox::upper_lowerX},
+            {BoundingBox::lower_upperY, BoundingBox::upper_lowerZ},
+            {BoundingBox::upper, BoundingBox::upper_lowerX},
+            {BoundingBox::upper, BoundingBox::upper_lowerY},
+            {BoundingBox::upper, BoundingBox::upper_lowerZ},
+            {BoundingBox::lower_upperZ, BoundingBox::upper_lowerX},
+            {BoundingBox::lower_upperZ, BoundingBox::upper_lowerY}
+        }};
+        for (const auto& [first, second] : edges)
+            boxEdges.emplace_back(toScreen(corners[first]), toScreen(corners[second]));
+    }
+
+    // segments are binned to the tiles their screen bounds overlap, in chunks of consecutive
+    // segments, so every tile draws its segments in path order
+    const int tileColumns {(width + tileSize - 1) / tileSize};
+    const int tileRows {(height + tileSize - 1) / tileSize};
+    const size_t tileCount {static_cast<size_t>(tileColumns) * tileRows};
+    const size_t segments {segmentCount()};
+    const size_t chunkCount {std::clamp<size_t>(segments / 4096, 1, std::max(1u, std::thread::hardware_concurrency()))};
+    const size_t chunkSize {(segments + chunkCount - 1) / chunkCount};
+    std::vector<std::vector<std::vector<uint32_t>>> bins(chunkCount, std::vector<std::vector<uint32_t>>(tileCount));
+
+    parallelFor(chunkCount, 1, [&](size_t chunkBegin, size_t chunkEnd)
+    {
+        for (size_t chunk {chunkBegin}; chunk < chunkEnd; chunk++)
+        {
+            auto& chunkBins {bins[chunk]};
+            const size_t end {std::min(segments, (chunk + 1) * chunkSize)};
+            for (size_t i {chunk * chunkSize}; i < end; i++)
+            {
+                const glm::vec3 lower {glm::min(screen[i], screen[i + 1])};
+                const glm::vec3 upper {glm::max(screen[i], screen[i + 1])};
+                // also rejects NaN
+                if (!(upper.x >= 0.0f && lower.x < width && upper.y >= 0.0f && lower.y < height))
+                    continue;
+                const int column0 {static_cast<int>(std::max(lower.x, 0.0f)) / tileSize};
+                const int column1 {static_cast<int>(std::min(upper.x, width - 1.0f)) / tileSize};
+                const int row0 {static_cast<int>(std::max(lower.y, 0.0f)) / tileSize};
+                const int row1 {static_cast<int>(std::min(upper.y, height - 1.0f)) / tileSize};
+                for (int row {row0}; row <= row1; row++)
+                    for (int column {column0}; column <= column1; column++)
+                        chunkBins[static_cast<size_t>(row) * tileColumns + column].push_back(static_cast<uint32_t>(i));
+            }
+        }
+    });
+
+    std::vector<uint32_t> background(height);
+    for (int y {0}; y < height; y++)
+    {
+        const float f {(y + 0.5f) / height};
+        auto channel = [f](int k)
+        {
+            return static_cast<int>(std::lround(PlotColors::backgroundTop[k] * (1.0f - f) + PlotColors::backgroundBottom[k] * f));
+        };
+        background[y] = qRgb(channel(0), channel(1), channel(2));
+    }
+
+    const uint32_t boxColor {toRgb(PlotColors::boundingBox)};
+    parallelFor(tileCount, 1, [&](size_t tileBegin, size_t tileEnd)
+    {
+        Tile tile;
+        tile.pixels = pixels;
+        tile.stride = stride;
+        for (size_t index {tileBegin}; index < tileEnd; index++)
+        {
+            tile.x0 = static_cast<int>(index % tileColumns) * tileSize;
+            tile.y0 = static_cast<int>(index / tileColumns) * tileSize;
+            tile.x1 = std::min(tile.x0 + tileSize, width);
+            tile.y1 = std::min(tile.y0 + tileSize, height);
+            tile.depth.fill(std::numeric_limits<float>::infinity());
+            for (int y {tile.y0}; y < tile.y1; y++)
+                std::fill(pixels + static_cast<size_t>(y) * stride + tile.x0, pixels + static_cast<size_t>(y) * stride + tile.x1,
+                          background[y]);
+
+            for (const auto& chunkBins : bins)
+                for (const uint32_t i : chunkBins[index])
+                    tile.drawLine(screen[i], screen[i + 1], m_colors[i]);
+            for (const auto& [a, b] : boxEdges)
+                tile.drawLine(a, b, boxColor);
+        }
+    });
+    return image;
+}
+
+QImage PathRasterizer::thumbnail(int size) const
+{
+    OrthographicCamera camera;
+    camera.setViewportSize(size, size);
+    camera.fit(m_boundingBox);
+    return render(camera);
+}
@@ -0,0 +1,46 @@
+#ifndef PATHRASTERIZER_H
+#define PATHRASTERIZER_H
+
+#include "boundingbox.h"
+#include "motionlist.h"
+#include "orthographiccamera.h"
+
+#include <QImage>
+
+#include <glm/vec3.hpp>
+
+#include <cstdint>
+#include <vector>
+
+/**
+ * Draws the backplot in software, for images of programs without an OpenGL context. The path
+ * is tessellated and colored like in BackplotWidget and drawn as one pixel wide lines with
+ * a depth test. The image is split into tiles which are drawn concurrently.
+ */
+class PathRasterizer
+{
+public:
+    void clear() noexcept;
+    void plot(const MotionList& motions);
+
+    std::size_t segmentCount() const noexcept { return m_points.empty() ? 0 : m_points.size() - 1; }
+    const BoundingBox& boundingBox() const noexcept { return m_boundingBox; }
+
+    /**
+     * The plot as seen by the camera, in an image of the camera's viewport size.
+     */
+    QImage render(const OrthographicCamera& camera) const;
+    /**
+     * The whole plot in a square image, seen from the top like a new backplot.
+     */
+    QImage thumbnail(int size) const;
+
+    static constexpr int tileSize {64};
+
+private:
+    std::vector<glm::vec3> m_points;
+    std::vector<uint32_t> m_colors; // of each segment, that is of its end point
+    BoundingBox m_boundingBox;
+};
+
+#endif // PATHRASTERIZER_H
@@ -0,0 +1,61 @@
+#include "pathtimeline.h"
+
+#include <glm/geometric.hpp>
+
+#include <algorithm>
+
+void PathTimeline::clear() noexcept
+{
+    m_lengths.clear();
+    m_times.clear();
+}
+
+void PathTimeline::build(const std::vector<glm::vec3>& points, const std::vector<std::size_t>& motionSegments,
+                         const std::vector<double>& motionFeeds)
+{
+    clear();
+    if (points.size() < 2)
+        return;
+
+    m_lengths.resize(points.size());
+    m_times.resize(points.size());
+    m_lengths[0] = 0.0;
+    m_times[0] = 0.0;
+    size_t motion {0};
+    double feed {rapidFeed};
+    for (size_t i {0}; i + 1 < points.size(); i++)
+    {
+        while (motion < motionSegments.size() && motionSegments[motion] <= i)
+        {
+            feed = motionFeeds[motion] > 0.0 ? motionFeeds[motion] : rapidFeed;
+            motion++;
+        }
+        const double length {glm::length(glm::dvec3(points[i + 1]) - glm::dvec3(points[i]))};
+        m_lengths[i + 1] = m_lengths[i] + length;
+        m_times[i + 1] = m_times[i] + length / feed * 60.0;
+    }
+}
+
+PathTimeline::Location PathTimeline::atTime(double seconds) const
+{
+    return locate(m_times, seconds);
+}
+
+PathTimeline::Location PathTimeline::atLength(double length) const
+{
+    return locate(m_lengths, length);
+}
+
+PathTimeline::Location PathTimeline::locate(const std::vector<double>& prefix, double value)
+{
+    if (prefix.size() < 2)
+        return {0, 0.0};
+    if (value >= prefix.back())
+        return {prefix.size() - 2, 1.0};
+
+    // the segment whose range contains the value, segments without extent are skipped
+    const auto it {std::upper_bound(prefix.begin(), prefix.end(), std::max(value, 0.0))};
+    const size_t segment {static_cast<size_t>(it - prefix.begin()) - 1};
+    const double extent {prefix[segment + 1] - prefix[segment]};
+    return {segment, extent > 0.0 ? (std::max(value, 0.0) - prefix[segment]) / extent : 0.0};
+}
@@ -0,0 +1,47 @@
+#ifndef PATHTIMELINE_H
+#define PATHTIMELINE_H
+
+#include <glm/vec3.hpp>
+
+#include <cstddef>
+#include <vector>
+
+/**
+ * Cumulative length and machining time along the segments of a polyline, segment i connects point i
+ * and point i + 1. Locates the tool for a time or a path length by binary search.
+ */
+class PathTimeline
+{
+public:
+    static constexpr double rapidFeed {10000.0}; // in mm/min, assumed for rapid motions
+
+    struct Location
+    {
+        std::size_t segment;
+        double parameter; // 0 at the start point of the segment, 1 at its end point
+    };
+
+    void clear() noexcept;
+    /**
+     * motionSegments are the first segments of the motions in ascending order, motionFeeds their feeds
+     * in mm/min, 0 for rapid motions. Segments before the first motion are rapid.
+     */
+    void build(const std::vector<glm::vec3>& points, const std::vector<std::size_t>& motionSegments,
+               const std::vector<double>& motionFeeds);
+
+    bool isEmpty() const noexcept { return m_lengths.size() < 2; }
+    std::size_t segmentCount() const noexcept { return isEmpty() ? 0 : m_lengths.size() - 1; }
+    double length() const noexcept { return m_lengths.empty() ? 0.0 : m_lengths.back(); }
+    double duration() const noexcept { return m_times.empty() ? 0.0 : m_times.back(); } // in seconds
+
+    Location atTime(double seconds) const;
+    Location atLength(double length) const;
+
+private:
+    static Location locate(const std::vector<double>& prefix, double value);
+
+    std::vector<double> m_lengths; // path length up to each point
+    std::vector<double> m_times;   // machining time up to each point
+};
+
+#endif // PATHTIMELINE_H
@@ -0,0 +1,102 @@
+#include "playbackbar.h"
+
+#include <QComboBox>
+#include <QHBoxLayout>
+#include <QLabel>
+#include <QSignalBlocker>
+#include <QSlider>
+#include <QStyle>
+#include <QToolButton>
+
+#include <algorithm>
+#include <cmath>
+
+static QString formatTime(double seconds)
+{
+    const int tenths {static_cast<int>(std::lround(seconds * 10.0))};
+    return QString("%1:%2.%3").arg(tenths / 600).arg(tenths / 10 % 60, 2, 10, QChar('0')).arg(tenths % 10);
+}
+
+PlaybackBar::PlaybackBar(QWidget* parent)
+    : QWidget(parent),
+      m_playButton(new QToolButton),
+      m_slider(new QSlider(Qt::Horizontal)),
+      m_speedBox(new QComboBox),
+      m_timeLabel(new QLabel)
+{
+    m_slider->setRange(0, sliderSteps);
+    for (int speed : {1, 2, 5, 10, 50, 100})
+        m_speedBox->addItem(QString("%1x").arg(speed), speed);
+    m_speedBox->setCurrentIndex(3);
+
+    auto* layout {new QHBoxLayout(this)};
+    layout->setContentsMargins(2, 2, 2, 2);
+    layout->addWidget(m_playButton);
+    layout->addWidget(m_slider, 1);
+    layout->addWidget(m_timeLabel);
+    layout->addWidget(m_speedBox);
+
+    m_timer.setInterval(frameInterval);
+    connect(&m_timer, &QTimer::timeout, this, &PlaybackBar::advance);
+    connect(m_playButton, &QToolButton::clicked, this, &PlaybackBar::togglePlaying);
+    connect(m_slider, &QSlider::valueChanged, this, [this](int value)
+    {
+        setPosition(m_duration * value / sliderSteps);
+    });
+
+    updateControls();
+}
+
+void PlaybackBar::setDuration(double seconds)
+{
+    m_timer.stop();
+    m_duration = seconds;
+    m_position = seconds;
+    updateControls();
+}
+
+void PlaybackBar::setPosition(double seconds)
+{
+    m_position = std::clamp(seconds, 0.0, m_duration);
+    updateControls();
+    emit positionChanged(m_position);
+}
+
+void PlaybackBar::togglePlaying()
+{
+    if (m_timer.isActive())
+    {
+        m_timer.stop();
+    }
+    else
+    {
+        if (m_position >= m_duration)
+            setPosition(0.0);
+        m_clock.start();
+        m_timer.start();
+    }
+    updateControls();
+}
+
+void PlaybackBar::advance()
+{
+    const double speed {m_speedBox->currentData().toDouble()};
+    setPosition(m_position + m_clock.restart() / 1000.0 * speed);
+    if (m_position >= m_duration)
+    {
+        m_timer.stop();
+        updateControls();
+    }
+}
+
+void PlaybackBar::updateControls()
+{
+    m_playButton->setIcon(style()->standardIcon(m_timer.isActive() ? QStyle::SP_MediaPause : QStyle::SP_MediaPlay));
+    m_playButton->setEnabled(m_duration > 0.0);
+    m_slider->setEnabled(m_duration > 0.0);
+    {
+        const QSignalBlocker blocker {m_slider};
+        m_slider->setValue(m_duration > 0.0 ? static_cast<int>(std::lround(m_position / m_duration * sliderSteps)) : sliderSteps);
+    }
+    m_timeLabel->setText(formatTime(m_position) + " / " + formatTime(m_duration));
+}
@@ -0,0 +1,53 @@
+#ifndef PLAYBACKBAR_H
+#define PLAYBACKBAR_H
+
+#include <QElapsedTimer>
+#include <QTimer>
+#include <QWidget>
+
+class QComboBox;
+class QLabel;
+class QSlider;
+class QToolButton;
+
+/**
+ * Play, pause and scrub controls for moving the simulated tool along the toolpath.
+ * Positions are machining times in seconds.
+ */
+class PlaybackBar : public QWidget
+{
+    Q_OBJECT
+public:
+    explicit PlaybackBar(QWidget* parent = nullptr);
+
+    double position() const noexcept { return m_position; }
+
+    static constexpr int sliderSteps {10000};
+    static constexpr int frameInterval {16}; // in milliseconds
+
+public slots:
+    /**
+     * Stops playing and moves to the end, without emitting positionChanged.
+     */
+    void setDuration(double seconds);
+
+signals:
+    void positionChanged(double seconds);
+
+private:
+    void setPosition(double seconds);
+    void togglePlaying();
+    void advance();
+    void updateControls();
+
+    QToolButton* m_playButton;
+    QSlider* m_slider;
+    QComboBox* m_speedBox;
+    QLabel* m_timeLabel;
+    QTimer m_timer;
+    QElapsedTimer m_clock;
+    double m_duration {0.0};
+    double m_position {0.0};
+};
+
+#endif // PLAYBACKBAR_H
@@ -0,0 +1,32 @@
+#ifndef PLOTCOLORS_H
+#define PLOTCOLORS_H
+
+#include "motionlist.h"
+
+#include <array>
+#include <cstdint>
+
+/**
+ * Colors of the backplot, shared by the OpenGL view and the software rasterizer.
+ */
+namespace PlotColors
+{
+using Color = std::array<uint8_t, 3>;
+
+constexpr Color rapid {255, 50, 50};
+constexpr Color linear {50, 255, 50};
+constexpr Color circular {40, 180, 255};
+constexpr Color boundingBox {100, 100, 100};
+// vertical gradient of the background
+constexpr Color backgroundTop {170, 180, 190};
+constexpr Color backgroundBottom {210, 220, 230};
+
+inline const Color& ofMotion(const MotionList::Item& motion)
+{
+    if (motion.feed <= 0)
+        return rapid;
+    return motion.arc == MotionList::noArc ? linear : circular;
+}
+}
+
+#endif // PLOTCOLORS_H
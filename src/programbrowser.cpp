@@ -0,0 +1,160 @@
+#include "programbrowser.h"
+
+#include <QDialogButtonBox>
+#include <QDir>
+#include <QHeaderView>
+#include <QLabel>
+#include <QLineEdit>
+#include <QTreeWidget>
+#include <QVBoxLayout>
+
+#include <cmath>
+
+enum Column
+{
+    FileColumn,
+    BlocksColumn,
+    MotionsColumn,
+    RapidsColumn,
+    AlarmsColumn,
+    ToolsColumn,
+    PathLengthColumn,
+    SizeColumn
+};
+
+ProgramBrowser::ProgramBrowser(const QString& directory, const QString& indexPath, QWidget* parent)
+    : QDialog(parent),
+      m_directory(directory),
+      m_filter(new QLineEdit),
+      m_list(new QTreeWidget),
+      m_status(new QLabel)
+{
+    setWindowTitle(tr("Browse %1").arg(QDir::toNativeSeparators(directory)));
+
+    m_filter->setPlaceholderText(tr("Filter by name, T<number> for a tool, alarm"));
+    m_filter->setClearButtonEnabled(true);
+    connect(m_filter, &QLineEdit::textChanged, this, &ProgramBrowser::applyFilter);
+
+    m_list->setHeaderLabels({tr("File"), tr("Blocks"), tr("Motions"), tr("Rapids"), tr("Alarms"), tr("Tools"),
+                             tr("Path length"), tr("Size X x Y x Z")});
+    m_list->setRootIsDecorated(false);
+    m_list->setUniformRowHeights(true);
+    m_list->setSelectionMode(QAbstractItemView::ExtendedSelection);
+    m_list->setSortingEnabled(true);
+    m_list->sortByColumn(FileColumn, Qt::AscendingOrder);
+    connect(m_list, &QTreeWidget::itemDoubleClicked, this, &QDialog::accept);
+
+    auto* buttons {new QDialogButtonBox(QDialogButtonBox::Open | QDialogButtonBox::Cancel)};
+    connect(buttons, &QDialogButtonBox::accepted, this, &QDialog::accept);
+    connect(buttons, &QDialogButtonBox::rejected, this, &QDialog::reject);
+
+    auto* layout {new QVBoxLayout(this)};
+    layout->addWidget(m_filter);
+    layout->addWidget(m_list, 1);
+    layout->addWidget(m_status);
+    layout->addWidget(buttons);
+    resize(1000, 600);
+
+    ProgramIndex index {indexPath.toStdString()};
+    index.load();
+    showSummaries(index.summaries());
+
+    m_status->setText(tr("Updating the index..."));
+    m_indexer = std::thread([this, directory = directory.toStdString(), index = std::move(index)]() mutable
+    {
+        // the dialog waits for this thread before it is destroyed, a cancel stops it within a slice
+        const auto evaluated {index.update(directory, [this](size_t done, size_t total)
+        {
+            QMetaObject::invokeMethod(this, [this, done, total]
+            {
+                m_status->setText(tr("Updating the index, %1 of %2 changed programs evaluated...").arg(done).arg(total));
+            }, Qt::QueuedConnection);
+            return !m_cancelled;
+        }, &m_cancelled)};
+        index.save();
+
+        QMetaObject::invokeMethod(this, [this, summaries = index.summaries(), evaluated]
+        {
+            showSummaries(summaries);
+            m_status->setText(tr("%1 programs, %2 evaluated again.").arg(summaries.size()).arg(evaluated));
+        }, Qt::QueuedConnection);
+    });
+}
+
+ProgramBrowser::~ProgramBrowser()
+{
+    m_cancelled = true;
+    m_indexer.join();
+}
+
+QStringList ProgramBrowser::selectedPaths() const
+{
+    QStringList paths;
+    for (const auto* item : m_list->selectedItems())
+    {
+        if (!item->isHidden())
+            paths << QString::fromStdString(m_summaries[item->data(FileColumn, Qt::UserRole).toULongLong()].path);
+    }
+    return paths;
+}
+
+void ProgramBrowser::showSummaries(const std::vector<ProgramIndex::Summary>& summaries)
+{
+    m_summaries = summaries;
+    const QDir directory {m_directory};
+
+    // sorting while adding thousands of items is slow
+    m_list->setSortingEnabled(false);
+    m_list->clear();
+    QList<QTreeWidgetItem*> items;
+    items.reserve(static_cast<int>(m_summaries.size()));
+    for (size_t i {0}; i < m_summaries.size(); i++)
+    {
+        const auto& summary {m_summaries[i]};
+        auto* item {new QTreeWidgetItem};
+        item->setText(FileColumn, QDir::toNativeSeparators(directory.relativeFilePath(QString::fromStdString(summary.path))));
+        item->setData(FileColumn, Qt::UserRole, static_cast<qulonglong>(i));
+        if (!summary.readable)
+        {
+            item->setText(BlocksColumn, tr("unreadable"));
+            items << item;
+            continue;
+        }
+
+        item->setData(BlocksColumn, Qt::DisplayRole, static_cast<qulonglong>(summary.blockCount));
+        item->setData(MotionsColumn, Qt::DisplayRole, static_cast<qulonglong>(summary.motionCount));
+        item->setData(RapidsColumn, Qt::DisplayRole, static_cast<qulonglong>(summary.rapidCount));
+        item->setData(AlarmsColumn, Qt::DisplayRole, static_cast<qulonglong>(summary.alarmCount));
+        if (summary.alarmCount > 0 || summary.jumpLimit)
+            item->setForeground(AlarmsColumn, Qt::red);
+        if (summary.jumpLimit)
+            item->setToolTip(AlarmsColumn, tr("Stopped at the jump limit, likely an endless loop"));
+        QStringList tools;
+        for (const int tool : summary.tools)
+            tools << QStringLiteral("T%1").arg(tool);
+        item->setText(ToolsColumn, tools.join(' '));
+        item->setData(PathLengthColumn, Qt::DisplayRole, std::round(summary.pathLength));
+        if (summary.boundingBox.isDefined())
+        {
+            const auto size {summary.boundingBox.upperCorner() - summary.boundingBox.lowerCorner()};
+            item->setText(SizeColumn, QStringLiteral("%1 x %2 x %3").arg(size.x, 0, 'f', 1).arg(size.y, 0, 'f', 1)
+                                                                   .arg(size.z, 0, 'f', 1));
+        }
+        items << item;
+    }
+    m_list->addTopLevelItems(items);
+    m_list->setSortingEnabled(true);
+    m_list->header()->resizeSections(QHeaderView::ResizeToContents);
+    applyFilter();
+}
+
+void ProgramBrowser::applyFilter()
+{
+    const std::string filter {m_filter->text().toStdString()};
+    for (int i {0}; i < m_list->topLevelItemCount(); i++)
+    {
+        auto* item {m_list->topLevelItem(i)};
+        const auto& summary {m_summaries[item->data(FileColumn, Qt::UserRole).toULongLong()]};
+        item->setHidden(!ProgramIndex::matches(summary, filter));
+    }
+}
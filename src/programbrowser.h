@@ -0,0 +1,44 @@
+#ifndef PROGRAMBROWSER_H
+#define PROGRAMBROWSER_H
+
+#include "programindex.h"
+
+#include <QDialog>
+#include <QStringList>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+class QLabel;
+class QLineEdit;
+class QTreeWidget;
+
+/**
+ * Lists the programs of a folder with their summaries from the folder's index, which is
+ * shown at once and brought up to date in the background.
+ */
+class ProgramBrowser : public QDialog
+{
+    Q_OBJECT
+public:
+    ProgramBrowser(const QString& directory, const QString& indexPath, QWidget* parent = nullptr);
+    ~ProgramBrowser() override;
+
+    QStringList selectedPaths() const;
+
+private:
+    void showSummaries(const std::vector<ProgramIndex::Summary>& summaries);
+    void applyFilter();
+
+    QString m_directory;
+    QLineEdit* m_filter;
+    QTreeWidget* m_list;
+    QLabel* m_status;
+    std::vector<ProgramIndex::Summary> m_summaries; // the items keep their index
+
+    std::thread m_indexer;
+    std::atomic<bool> m_cancelled {false};
+};
+
+#endif // PROGRAMBROWSER_H
@@ -0,0 +1,272 @@
+#include "programindex.h"
+#include "batchverifier.h"
+#include "controller.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <mutex>
+#include <sstream>
+#include <utility>
+
+namespace fs = std::filesystem;
+
+static const std::string header {"# program index 2, evaluation version "};
+
+ProgramIndex::ProgramIndex(std::string indexPath)
+    : m_indexPath(std::move(indexPath))
+{
+}
+
+static uint64_t hashFile(const std::string& path)
+{
+    std::ifstream file {path, std::ios::binary};
+    uint64_t hash {0xcbf29ce484222325};
+    char buffer[65536];
+    while (file)
+    {
+        file.read(buffer, sizeof(buffer));
+        for (std::streamsize i {0}; i < file.gcount(); i++)
+        {
+            hash ^= static_cast<unsigned char>(buffer[i]);
+            hash *= 0x100000001b3;
+        }
+    }
+    return hash;
+}
+
+bool ProgramIndex::load()
+{
+    m_summaries.clear();
+    std::ifstream file {m_indexPath};
+    std::string line;
+    if (!std::getline(file, line) || line != header + std::to_string(Controller::evaluationVersion))
+        return false;
+
+    read(file);
+    return true;
+}
+
+bool ProgramIndex::save() const
+{
+    std::error_code error;
+    fs::create_directories(fs::path(m_indexPath).parent_path(), error);
+    // written aside and renamed, so a concurrent reader never sees half an index
+    const std::string temporaryPath {m_indexPath + ".tmp"};
+    {
+        std::ofstream file {temporaryPath};
+        file << header << Controller::evaluationVersion << '\n';
+        write(file);
+        if (!file)
+            return false;
+    }
+    fs::rename(temporaryPath, m_indexPath, error);
+    return !error;
+}
+
+/**
+ * One line per program with tab separated fields, the bounding box fields are empty if undefined.
+ */
+void ProgramIndex::write(std::ostream& stream) const
+{
+    stream << std::setprecision(9);
+    for (const auto& summary : m_summaries)
+    {
+        if (summary.path.find_first_of("\t\n") != std::string::npos)
+            continue;
+
+        stream << summary.path << '\t' << summary.modified << '\t' << summary.size << '\t'
+               << std::hex << summary.hash << std::dec << '\t' << summary.readable << '\t'
+               << summary.blockCount << '\t' << summary.motionCount << '\t' << summary.rapidCount << '\t'
+               << summary.alarmCount << '\t' << summary.jumpLimit << '\t' << summary.pathLength << '\t';
+        for (size_t i {0}; i < summary.tools.size(); i++)
+            stream << (i > 0 ? "," : "") << summary.tools[i];
+        for (const auto& corner : {summary.boundingBox.lowerCorner(), summary.boundingBox.upperCorner()})
+        {
+            for (int k {0}; k < 3; k++)
+            {
+                stream << '\t';
+                if (summary.boundingBox.isDefined())
+                    stream << corner[k];
+            }
+        }
+        stream << '\n';
+    }
+}
+
+/**
+ * Lines which cannot be read are skipped, their programs are evaluated again on the next update.
+ */
+void ProgramIndex::read(std::istream& stream)
+{
+    std::string line;
+    while (std::getline(stream, line))
+    {
+        std::vector<std::string> fields;
+        std::istringstream lineStream {line};
+        for (std::string field; std::getline(lineStream, field, '\t');)
+            fields.push_back(field);
+        // a trailing empty field is not returned
+        if (!line.empty() && line.back() == '\t')
+            fields.emplace_back();
+        if (fields.size() != 18)
+            continue;
+
+        Summary summary;
+        summary.path = fields[0];
+        std::istringstream numbers {fields[1] + ' ' + fields[2] + ' ' + fields[3] + ' ' + fields[4] + ' ' + fields[5] +
+                                    ' ' + fields[6] + ' ' + fields[7] + ' ' + fields[8] + ' ' + fields[9] + ' ' + fields[10]};
+        numbers >> summary.modified >> summary.size >> std::hex >> summary.hash >> std::dec >> summary.readable
+                >> summary.blockCount >> summary.motionCount >> summary.rapidCount >> summary.alarmCount
+                >> summary.jumpLimit >> summary.pathLength;
+        if (!numbers)
+            continue;
+
+        std::istringstream tools {fields[11]};
+        for (std::string tool; std::getline(tools, tool, ',');)
+            summary.tools.push_back(std::atoi(tool.c_str()));
+
+        if (!fields[12].empty())
+        {
+            std::istringstream box {fields[12] + ' ' + fields[13] + ' ' + fields[14] + ' ' + fields[15] + ' ' +
+                                    fields[16] + ' ' + fields[17]};
+            glm::vec3 lower;
+            glm::vec3 upper;
+            box >> lower.x >> lower.y >> lower.z >> upper.x >> upper.y >> upper.z;
+            if (!box)
+                continue;
+            summary.boundingBox = BoundingBox {lower, upper};
+        }
+        m_summaries.push_back(std::move(summary));
+    }
+    std::sort(m_summaries.begin(), m_summaries.end(),
+              [](const Summary& a, const Summary& b) { return a.path < b.path; });
+}
+
+std::size_t ProgramIndex::update(const std::string& directory,
+                                 const std::function<bool(std::size_t, std::size_t)>& progress,
+                                 const std::atomic<bool>* cancelled)
+{
+    auto find = [this](const std::string& path) -> const Summary*
+    {
+        const auto it {std::lower_bound(m_summaries.begin(), m_summaries.end(), path,
+                                        [](const Summary& summary, const std::string& p) { return summary.path < p; })};
+        return it != m_summaries.end() && it->path == path ? &*it : nullptr;
+    };
+
+    // unchanged programs keep their summaries, changed ones are evaluated below
+    std::vector<Summary> summaries;
+    std::vector<size_t> changed;
+    for (const auto& path : BatchVerifier::findPrograms(directory))
+    {
+        Summary summary;
+        summary.path = path;
+        std::error_code error;
+        summary.modified = static_cast<int64_t>(fs::last_write_time(path, error).time_since_epoch().count());
+        summary.size = static_cast<uint64_t>(fs::file_size(path, error));
+
+        const Summary* old {find(path)};
+        if (old && old->modified == summary.modified && old->size == summary.size)
+        {
+            summaries.push_back(*old);
+            continue;
+        }
+        summary.hash = hashFile(path);
+        if (old && old->hash == summary.hash && old->size == summary.size)
+        {
+            // touched, not changed
+            summaries.push_back(*old);
+            summaries.back().modified = summary.modified;
+            continue;
+        }
+        changed.push_back(summaries.size());
+        summaries.push_back(std::move(summary));
+    }
+
+    const BatchVerifier verifier;
+    std::vector<bool> evaluated(summaries.size(), true);
+    for (const size_t index : changed)
+        evaluated[index] = false;
+    size_t done {0};
+    size_t evaluatedCount {0};
+    std::mutex progressMutex;
+    bool stopped {false};
+    // a stop is seen after the program each worker is evaluating, not after the batch
+    auto proceed = [&]()
+    {
+        std::lock_guard lock {progressMutex};
+        evaluatedCount++;
+        stopped = stopped || (progress && !progress(evaluatedCount, changed.size()));
+        return !stopped;
+    };
+    while (done < changed.size() && !stopped && !(cancelled && *cancelled))
+    {
+        const size_t end {std::min(done + batchSize, changed.size())};
+        std::vector<std::string> paths;
+        for (size_t i {done}; i < end; i++)
+            paths.push_back(summaries[changed[i]].path);
+        const auto results {verifier.verify(paths, proceed, cancelled)};
+        for (size_t i {done}; i < end; i++)
+        {
+            const auto& result {results[i - done]};
+            if (!result.verified)
+                continue;
+            Summary& summary {summaries[changed[i]]};
+            summary.readable = result.readable;
+            summary.blockCount = result.blockCount;
+            summary.motionCount = result.motionCount;
+            summary.rapidCount = result.rapidCount;
+            summary.alarmCount = result.alarms.size();
+            summary.jumpLimit = result.jumpLimit;
+            summary.pathLength = result.pathLength;
+            summary.tools = result.tools;
+            summary.boundingBox = result.boundingBox;
+            evaluated[changed[i]] = true;
+        }
+        done = end;
+    }
+
+    // programs left out by a stop are not in the index, so the next update evaluates them
+    m_summaries.clear();
+    for (size_t i {0}; i < summaries.size(); i++)
+    {
+        if (evaluated[i])
+            m_summaries.push_back(std::move(summaries[i]));
+    }
+    return evaluatedCount;
+}
+
+bool ProgramIndex::matches(const Summary& summary, const std::string& filter)
+{
+    auto lower = [](std::string text)
+    {
+        std::transform(text.begin(), text.end(), text.begin(), [](unsigned char c) { return std::tolower(c); });
+        return text;
+    };
+    const std::string fileName {lower(fs::path(summary.path).filename().string())};
+
+    std::istringstream terms {lower(filter)};
+    for (std::string term; terms >> term;)
+    {
+        const bool toolTerm {term.size() > 1 && term[0] == 't' &&
+                             std::all_of(term.begin() + 1, term.end(), [](unsigned char c) { return std::isdigit(c); })};
+        if (toolTerm)
+        {
+            if (!std::binary_search(summary.tools.begin(), summary.tools.end(), std::atoi(term.c_str() + 1)))
+                return false;
+        }
+        else if (term == "alarm")
+        {
+            if (summary.alarmCount == 0 && !summary.jumpLimit && summary.readable)
+                return false;
+        }
+        else if (fileName.find(term) == std::string::npos)
+        {
+            return false;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,80 @@
+#ifndef PROGRAMINDEX_H
+#define PROGRAMINDEX_H
+
+#include "boundingbox.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+/**
+ * Summaries of the programs in a folder, kept in an index file so a folder can be browsed
+ * without evaluating its programs. An entry is valid as long as the file has the same
+ * modification time and size, or else the same content hash. Only programs which changed
+ * are evaluated again when the index is updated.
+ */
+class ProgramIndex
+{
+public:
+    struct Summary
+    {
+        std::string path;
+        int64_t modified {0}; // file time ticks
+        uint64_t size {0};
+        uint64_t hash {0}; // FNV-1a of the content
+        bool readable {false};
+        std::size_t blockCount {0};
+        std::size_t motionCount {0};
+        std::size_t rapidCount {0};
+        std::size_t alarmCount {0};
+        bool jumpLimit {false}; // the evaluation stopped at the jump limit, likely an endless loop
+        double pathLength {0.0};
+        std::vector<int> tools;
+        BoundingBox boundingBox;
+    };
+
+    explicit ProgramIndex(std::string indexPath);
+
+    /**
+     * Reads the index file. Returns false, leaving the index empty, if there is none or it was
+     * written by another evaluation version.
+     */
+    bool load();
+    bool save() const;
+
+    /**
+     * Brings the index up to date with the programs in the directory, evaluating new and changed
+     * programs in batches. progress(done, total) is called after each program, from the threads
+     * evaluating them one at a time, returning false stops the update. Setting cancelled stops it
+     * within the evaluation of a program, see BatchVerifier::verify. Returns the number of
+     * programs evaluated.
+     */
+    std::size_t update(const std::string& directory,
+                       const std::function<bool(std::size_t, std::size_t)>& progress = {},
+                       const std::atomic<bool>* cancelled = nullptr);
+
+    // sorted by path
+    const std::vector<Summary>& summaries() const noexcept { return m_summaries; }
+
+    /**
+     * Whether the summary matches all space separated terms of the filter: T followed by a number
+     * matches programs using that tool, "alarm" programs with alarms or stopped at the jump limit, any other term a part of the
+     * file name, ignoring case.
+     */
+    static bool matches(const Summary& summary, const std::string& filter);
+
+    static constexpr std::size_t batchSize {64};
+
+private:
+    void read(std::istream& stream);
+    void write(std::ostream& stream) const;
+
+    std::string m_indexPath;
+    std::vector<Summary> m_summaries;
+};
+
+#endif // PROGRAMINDEX_H
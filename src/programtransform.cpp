@@ -0,0 +1,440 @@
+#include "programtransform.h"
+#include "parser.h"
+#include "s840d_alarm.h"
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <charconv>
+#include <cmath>
+#include <cstdlib>
+#include <istream>
+#include <optional>
+#include <ostream>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+ProgramTransform::ProgramTransform(const Options& options)
+    : m_options(options),
+      m_parser(std::make_unique<Parser>())
+{
+}
+
+ProgramTransform::~ProgramTransform() = default;
+
+namespace
+{
+
+/**
+ * Offsets of the digits of the N block number, none for blocks without one and main blocks.
+ */
+std::optional<std::pair<std::size_t, std::size_t>> blockNumberDigits(Parser& parser, const std::string& line)
+{
+    const char* start {line.data()};
+    const char* end {start + Parser::findCommentStartPos<std::string>(line.begin(), line.end())};
+    try
+    {
+        const char* p {parser.readSkipLevel(start, end).second};
+        const auto [number, numberEnd] {parser.readBlockNumber(p, end)};
+        if (!number || number->m_type != BlockNumber::Regular)
+            return std::nullopt;
+        const char* digitStart {numberEnd};
+        while (digitStart != start && std::isdigit(static_cast<unsigned char>(digitStart[-1])))
+            digitStart--;
+        return std::make_pair(static_cast<std::size_t>(digitStart - start), static_cast<std::size_t>(numberEnd - start));
+    }
+    catch (const S840D_Alarm& /*alarm*/)
+    {
+        return std::nullopt;
+    }
+}
+
+/** numbers and negated numbers, the values of plain address words */
+std::optional<double> constantValue(const Expr* expr)
+{
+    if (const auto* literal = dynamic_cast<const LiteralExpr*>(expr))
+    {
+        if (const auto* i = std::get_if<s840d_int_t>(&literal->m_value))
+            return *i;
+        if (const auto* r = std::get_if<s840d_real_t>(&literal->m_value))
+            return *r;
+        return std::nullopt;
+    }
+    if (const auto* unary = dynamic_cast<const UnaryOpExpr*>(expr); unary && unary->m_op == UnaryOpExpr::UMINUS)
+    {
+        if (const auto value {constantValue(unary->m_arg.get())})
+            return -*value;
+    }
+    return std::nullopt;
+}
+
+/** at most 6 decimals without trailing zeros */
+std::string formatNumber(double value)
+{
+    char buffer[64];
+    const auto [end, ec] {std::to_chars(buffer, buffer + sizeof(buffer), value, std::chars_format::fixed, 6)};
+    if (ec != std::errc{})
+        return std::to_string(value);
+    std::string text {buffer, end};
+    text.erase(text.find_last_not_of('0') + 1);
+    if (text.back() == '.')
+        text.pop_back();
+    return text == "-0" ? "0" : text;
+}
+
+}
+
+/**
+ * The new numbers by the old ones, the first block with a number is the target of GOTOs to it.
+ * The number is read before the rest of the block like in transformLine, so blocks with alarms
+ * are numbered in both passes.
+ */
+void ProgramTransform::collectBlockNumbers(std::istream& in)
+{
+    std::string line;
+    for (std::size_t lineCount {1}; std::getline(in, line); lineCount++)
+    {
+        // the block numbers are interned, this bounds the parser's names
+        if (lineCount % 4096 == 0)
+            m_parser->reset();
+        if (const auto digits {blockNumberDigits(*m_parser, line)})
+        {
+            m_newNumbers.try_emplace(line.substr(digits->first, digits->second - digits->first), m_nextNumber);
+            m_nextNumber += m_options.renumberStep;
+        }
+    }
+}
+
+ProgramTransform::Result ProgramTransform::transform(std::istream& in, std::ostream& out)
+{
+    Result result;
+    m_parser->reset();
+    m_newNumbers.clear();
+    m_incremental = false;
+    m_plane = 17;
+    if (m_options.renumber)
+    {
+        const auto start {in.tellg()};
+        m_nextNumber = m_options.renumberStart;
+        collectBlockNumbers(in);
+        in.clear();
+        in.seekg(start);
+        m_nextNumber = m_options.renumberStart;
+    }
+
+    std::string line;
+    std::string output;
+    while (std::getline(in, line))
+    {
+        const bool carriageReturn {!line.empty() && line.back() == '\r'};
+        if (carriageReturn)
+            line.pop_back();
+
+        // blocks are parsed one after another, this bounds the parser's content cache
+        if (++result.blockCount % 4096 == 0)
+            m_parser->reset();
+        transformLine(line, output, result);
+        if (carriageReturn)
+            output += '\r';
+        if (!in.eof())
+            output += '\n';
+
+        if (output.size() > 65536)
+        {
+            out.write(output.data(), static_cast<std::streamsize>(output.size()));
+            output.clear();
+        }
+    }
+    out.write(output.data(), static_cast<std::streamsize>(output.size()));
+    return result;
+}
+
+/**
+ * Appends the line with the changed words replaced, the parsed block tells which words change.
+ * They are found in the text like Parser::readPlainWords reads them, or else by the lexer.
+ */
+void ProgramTransform::transformLine(const std::string& line, std::string& output, Result& result)
+{
+    // most blocks are plain address words, read directly they don't fill the parser's content cache
+    const auto commentPos {Parser::findCommentStartPos<std::string>(line.begin(), line.end())};
+    const char* start {line.data()};
+    const char* end {start + commentPos};
+    const char* wordsStart {nullptr};
+
+    auto& edits {m_edits};
+    edits.clear();
+    if (m_options.renumber)
+    {
+        if (const auto digits {blockNumberDigits(*m_parser, line)})
+        {
+            edits.push_back({digits->first, digits->second, std::to_string(m_nextNumber)});
+            m_nextNumber += m_options.renumberStep;
+        }
+    }
+
+    NCProgramBlock block;
+    BlockContentSpan contents;
+    try
+    {
+        const char* numberEnd {m_parser->readBlockNumber(m_parser->readSkipLevel(start, end).second, end).second};
+        m_words.clear();
+        if (!m_parser->readLabel(numberEnd, end).first && m_parser->readPlainWords(numberEnd, end, m_words))
+        {
+            wordsStart = numberEnd;
+            contents = {m_words.data(), m_words.size()};
+        }
+        else
+        {
+            block = m_parser->parse(line);
+            contents = block.blockContent;
+        }
+
+    }
+    catch (const S840D_Alarm& /*alarm*/)
+    {
+        // only renumbered, the numbers must follow the first pass
+        result.alarmCount++;
+        applyEdits(line, output, result);
+        return;
+    }
+
+    auto letterOf = [](const std::string& address)
+    {
+        return address.size() == 1 ? static_cast<char>(std::toupper(static_cast<unsigned char>(address[0]))) : '\0';
+    };
+
+    // modal states follow the text, G90/G91 and the plane of this block apply to its words
+    for (const auto& content : contents)
+    {
+        const auto* addressAssign {std::get_if<AddressAssign>(&content)};
+        if (!addressAssign || letterOf(addressAssign->m_address) != 'G')
+            continue;
+        const auto value {constantValue(addressAssign->m_expr.get())};
+        if (value == 90.0 || value == 91.0)
+            m_incremental = *value == 91.0;
+        else if (value == 17.0 || value == 18.0 || value == 19.0)
+            m_plane = static_cast<int>(*value);
+    }
+    const auto& mirror {m_options.mirror};
+    const bool flipDirection {m_plane == 17 ? mirror[0] != mirror[1] :
+                              m_plane == 18 ? mirror[2] != mirror[0] : mirror[1] != mirror[2]};
+
+    // reused, most blocks change
+    auto& wordEdits {m_wordEdits};
+    auto& gotoTargets {m_gotoTargets};
+    wordEdits.clear();
+    gotoTargets.clear();
+    std::array<std::size_t, 26> occurrences {};
+    for (std::size_t index {0}; index < contents.size(); index++)
+    {
+        const auto& content {contents[index]};
+        if (m_options.renumber)
+        {
+            auto addTarget = [this, &gotoTargets](const GotoStmt& gotoStmt)
+            {
+                const auto* literal {dynamic_cast<const LiteralExpr*>(gotoStmt.m_expr.get())};
+                const auto* target {literal ? std::get_if<s840d_string_t>(&literal->m_value) : nullptr};
+                if (!target || target->empty() || !std::isdigit(static_cast<unsigned char>((*target)[0])))
+                    return;
+                const auto it {m_newNumbers.find(*target)};
+                gotoTargets.push_back(it != m_newNumbers.end() ? std::to_string(it->second) : std::string{});
+            };
+            if (const auto* gotoStmt = std::get_if<GotoStmt>(&content))
+                addTarget(*gotoStmt);
+            else if (const auto* conditionalGoto = std::get_if<ConditionalGotoStmt>(&content))
+                for (const auto* stmt {conditionalGoto}; stmt; stmt = stmt->m_next.get())
+                    addTarget(*stmt->m_gotoStmt);
+        }
+
+        const auto* addressAssign {std::get_if<AddressAssign>(&content)};
+        const char letter {addressAssign ? letterOf(addressAssign->m_address) : '\0'};
+        if (letter < 'A' || letter > 'Z')
+            continue;
+        const std::size_t occurrence {occurrences[letter - 'A']++};
+        const auto type {addressAssign->m_coordType};
+
+        int axis {-1};
+        bool absolute {false};
+        bool changes {false};
+        if (letter == 'X' || letter == 'Y' || letter == 'Z' || letter == 'I' || letter == 'J' || letter == 'K')
+        {
+            // I, J, K are relative to the start point unless AC
+            axis = letter >= 'X' ? letter - 'X' : letter - 'I';
+            absolute = type == AddressAssign::AC || (type == AddressAssign::DEFAULT && !m_incremental && letter >= 'X');
+            changes = mirror[axis] || (absolute && m_options.offset[axis] != 0.0);
+        }
+        else if (letter == 'F')
+            changes = m_options.feedPercent != 100.0;
+        else if (letter == 'G')
+            changes = flipDirection;
+        if (!changes)
+            continue;
+
+        const auto value {constantValue(addressAssign->m_expr.get())};
+        if (!value)
+        {
+            result.skippedWords++;
+            continue;
+        }
+
+        std::string text;
+        if (axis >= 0)
+        {
+            double newValue {mirror[axis] ? -*value : *value};
+            if (absolute)
+                newValue += m_options.offset[axis];
+            text = formatNumber(newValue);
+        }
+        else if (letter == 'F')
+            text = formatNumber(*value * m_options.feedPercent / 100.0);
+        else
+        {
+            // mirroring one axis of the plane reverses arcs and the side of the cutter radius compensation
+            static constexpr std::array<std::pair<int, int>, 4> swaps {{{2, 3}, {3, 2}, {41, 42}, {42, 41}}};
+            const auto swap {std::find_if(swaps.begin(), swaps.end(), [&value](const auto& s) { return s.first == *value; })};
+            if (swap == swaps.end())
+                continue;
+            text = std::to_string(swap->second);
+        }
+        wordEdits.push_back({letter, occurrence, index, *value, std::move(text)});
+    }
+
+    if (wordsStart && !wordEdits.empty())
+        locatePlainWords(wordsStart, line);
+    else if (!wordEdits.empty() || std::any_of(gotoTargets.begin(), gotoTargets.end(),
+                                               [](const std::string& target) { return !target.empty(); }))
+        result.skippedWords += wordEdits.size() - locateTokens(line, commentPos);
+    applyEdits(line, output, result);
+}
+
+void ProgramTransform::applyEdits(const std::string& line, std::string& output, Result& result)
+{
+    auto& edits {m_edits};
+    if (edits.empty())
+    {
+        output += line;
+        return;
+    }
+    result.changedBlocks++;
+    std::sort(edits.begin(), edits.end(), [](const TextEdit& a, const TextEdit& b) { return a.begin < b.begin; });
+    std::size_t position {0};
+    for (const auto& edit : edits)
+    {
+        output.append(line, position, edit.begin - position);
+        output += edit.text;
+        position = edit.end;
+    }
+    output.append(line, position, std::string::npos);
+}
+
+/**
+ * Adds the edits of plain address words, which are the block contents in order: a letter, an
+ * optional sign and a number, separated by blanks.
+ */
+void ProgramTransform::locatePlainWords(const char* p, const std::string& line)
+{
+    auto isBlank = [](char c)
+    {
+        return c == ' ' || c == '\t';
+    };
+    auto skipBlanks = [&p, &isBlank, end = line.data() + line.size()]()
+    {
+        while (p != end && isBlank(*p))
+            p++;
+    };
+
+    auto wordEdit {m_wordEdits.begin()};
+    for (std::size_t index {0}; wordEdit != m_wordEdits.end(); index++)
+    {
+        skipBlanks();
+        p++; // the address letter
+        skipBlanks();
+        const char* begin {p};
+        if (*p == '-' || *p == '+')
+        {
+            p++;
+            skipBlanks();
+        }
+        while (std::isdigit(static_cast<unsigned char>(*p)) || *p == '.')
+            p++;
+        if (wordEdit->index == index)
+        {
+            m_edits.push_back({static_cast<std::size_t>(begin - line.data()), static_cast<std::size_t>(p - line.data()),
+                               wordEdit->text});
+            ++wordEdit;
+        }
+    }
+}
+
+/**
+ * Adds the edits of the words and GOTO targets found by the lexer, returns the number of word
+ * edits added. A word is only changed if its number is the parsed value.
+ */
+std::size_t ProgramTransform::locateTokens(const std::string& line, std::size_t commentPos)
+{
+    auto& tokens {m_tokens};
+    m_parser->tokenize(line.data(), line.data() + commentPos, tokens);
+    auto tokenText = [&line, &tokens](std::size_t i)
+    {
+        return std::string_view {line.data() + tokens[i].position, tokens[i].length};
+    };
+    auto isGoto = [](std::string_view text)
+    {
+        return text.size() >= 4 && std::equal(text.begin(), text.begin() + 4, "GOTO",
+                                              [](char a, char b) { return std::toupper(static_cast<unsigned char>(a)) == b; });
+    };
+
+    std::array<std::size_t, 26> occurrences {};
+    std::size_t gotoIndex {0};
+    std::size_t applied {0};
+    for (std::size_t i {0}; i < tokens.size(); i++)
+    {
+        const auto category {tokens[i].category};
+        const char letter {static_cast<char>(std::toupper(static_cast<unsigned char>(line[tokens[i].position])))};
+        if (category == Parser::TokenCategory::BlockNumber && i > 0 &&
+            tokens[i - 1].category == Parser::TokenCategory::Keyword && isGoto(tokenText(i - 1)))
+        {
+            // GOTO N<number>
+            if (gotoIndex < m_gotoTargets.size() && !m_gotoTargets[gotoIndex].empty() && i + 1 < tokens.size())
+                m_edits.push_back({tokens[i + 1].position, tokens[i + 1].position + tokens[i + 1].length,
+                                   m_gotoTargets[gotoIndex]});
+            gotoIndex++;
+            continue;
+        }
+        if (tokens[i].length != 1 || letter < 'A' || letter > 'Z' ||
+            (category != Parser::TokenCategory::AddressLetter && category != Parser::TokenCategory::GFunction))
+            continue;
+
+        const std::size_t occurrence {occurrences[letter - 'A']++};
+        const auto wordEdit {std::find_if(m_wordEdits.begin(), m_wordEdits.end(), [letter, occurrence](const WordEdit& e) {
+            return e.letter == letter && e.occurrence == occurrence;
+        })};
+        if (wordEdit == m_wordEdits.end())
+            continue;
+
+        // X=-10, X=AC(-10)
+        std::size_t k {i + 1};
+        if (k < tokens.size() && tokenText(k) == "=")
+            k++;
+        if (k + 1 < tokens.size() && tokens[k].category == Parser::TokenCategory::Keyword && tokenText(k + 1) == "(")
+            k += 2;
+        double sign {1.0};
+        const std::size_t begin {k < tokens.size() ? tokens[k].position : 0};
+        if (k < tokens.size() && (tokenText(k) == "-" || tokenText(k) == "+"))
+        {
+            sign = tokenText(k) == "-" ? -1.0 : 1.0;
+            k++;
+        }
+        if (k >= tokens.size() || tokens[k].category != Parser::TokenCategory::Number)
+            continue;
+        const std::string number {tokenText(k)};
+        char* numberEnd;
+        const double value {sign * std::strtod(number.c_str(), &numberEnd)};
+        if (*numberEnd != '\0' || std::abs(value - wordEdit->oldValue) > 1e-9 * std::max(1.0, std::abs(value)))
+            continue;
+        m_edits.push_back({begin, tokens[k].position + tokens[k].length, wordEdit->text});
+        applied++;
+    }
+    return applied;
+}
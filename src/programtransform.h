@@ -0,0 +1,92 @@
+#ifndef PROGRAMTRANSFORM_H
+#define PROGRAMTRANSFORM_H
+
+#include "parser.h"
+
+#include <glm/vec3.hpp>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * Edits a program block by block, as a stream: renumbers the N words, mirrors and shifts the
+ * coordinates and scales the feeds. The parsed blocks tell which words change, only their
+ * numbers are replaced in the text, so comments and formatting are kept. Words with computed
+ * values are left as they are and counted.
+ */
+class ProgramTransform
+{
+public:
+    struct Options
+    {
+        bool renumber {false};
+        uint32_t renumberStart {10};
+        uint32_t renumberStep {10};
+        std::array<bool, 3> mirror {}; // negates X, Y, Z and I, J, K, before the offset
+        glm::dvec3 offset {0.0}; // added to absolute X, Y, Z
+        double feedPercent {100.0};
+    };
+
+    struct Result
+    {
+        std::size_t blockCount {0};
+        std::size_t changedBlocks {0};
+        std::size_t alarmCount {0}; // blocks which cannot be parsed, they are copied
+        std::size_t skippedWords {0}; // words with computed values
+    };
+
+    explicit ProgramTransform(const Options& options);
+    ~ProgramTransform();
+    ProgramTransform(const ProgramTransform&) = delete;
+    ProgramTransform& operator=(const ProgramTransform&) = delete;
+
+    /**
+     * Writes the transformed program. Renumbering reads the input twice to update GOTO targets,
+     * so then it must be seekable. Line ends are kept.
+     */
+    Result transform(std::istream& in, std::ostream& out);
+
+private:
+    void collectBlockNumbers(std::istream& in);
+    void transformLine(const std::string& line, std::string& output, Result& result);
+    void locatePlainWords(const char* p, const std::string& line);
+    std::size_t locateTokens(const std::string& line, std::size_t commentPos);
+    void applyEdits(const std::string& line, std::string& output, Result& result);
+
+    /** a new value for the n-th word with the address letter */
+    struct WordEdit
+    {
+        char letter;
+        std::size_t occurrence; // among the words with the letter
+        std::size_t index; // of the block content
+        double oldValue;
+        std::string text;
+    };
+
+    struct TextEdit
+    {
+        std::size_t begin;
+        std::size_t end;
+        std::string text;
+    };
+
+    Options m_options;
+    std::unique_ptr<Parser> m_parser;
+    std::vector<BlockContent> m_words;
+    std::vector<WordEdit> m_wordEdits;
+    std::vector<std::string> m_gotoTargets; // new numbers of the N targets in order, empty if unchanged
+    std::vector<TextEdit> m_edits;
+    std::vector<Parser::LexicalToken> m_tokens;
+    std::unordered_map<std::string, uint32_t> m_newNumbers; // by the digits of the old number
+    uint32_t m_nextNumber {0};
+    bool m_incremental {false}; // G91
+    int m_plane {17};
+};
+
+#endif // PROGRAMTRANSFORM_H
@@ -6,7 +6,8 @@
 #include <iostream>
 
 /**
- * Utility class for a simple time measurement. Prints time since object contruction until destruction.
+ * Utility class for a simple time measurement. Prints time since object contruction until destruction
+ * to stderr, stdout is left to the command line reports.
  * Usage:
  * {
  *    ScopedTimer t{"parsing"};
@@ -36,7 +37,7 @@ public:
     {
         auto elapsed =
             std::chrono::duration_cast<Duration>(Clock::now() - start);
-        std::cout << m_message << ": " << elapsed.count() << unitStr << std::endl;;
+        std::cerr << m_message << ": " << elapsed.count() << unitStr << std::endl;
     }
 };
 
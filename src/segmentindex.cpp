@@ -0,0 +1,255 @@
+#include "segmentindex.h"
+
+#include <glm/common.hpp>
+#include <glm/geometric.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+void SegmentIndex::clear() noexcept
+{
+    m_points.clear();
+    m_segments.clear();
+    m_nodes.clear();
+}
+
+/**
+ * Interleaves the lower 21 bits of x, y and z.
+ */
+static uint64_t mortonCode(uint32_t x, uint32_t y, uint32_t z)
+{
+    auto spread = [](uint64_t v)
+    {
+        v &= 0x1fffff;
+        v = (v | v << 32) & 0x1f00000000ffff;
+        v = (v | v << 16) & 0x1f0000ff0000ff;
+        v = (v | v << 8) & 0x100f00f00f00f00f;
+        v = (v | v << 4) & 0x10c30c30c30c30c3;
+        v = (v | v << 2) & 0x1249249249249249;
+        return v;
+    };
+    return spread(x) | spread(y) << 1 | spread(z) << 2;
+}
+
+/**
+ * The segments are ordered along a Morton curve through their centers, so neighbours in the
+ * order are neighbours in space and the hierarchy is built by splitting ranges of the order.
+ */
+void SegmentIndex::build(std::vector<glm::vec3> points)
+{
+    clear();
+    m_points = std::move(points);
+    const std::size_t count {segmentCount()};
+    if (count == 0)
+        return;
+
+    glm::vec3 lower {std::numeric_limits<float>::max()};
+    glm::vec3 upper {std::numeric_limits<float>::lowest()};
+    for (const auto& point : m_points)
+    {
+        lower = glm::min(lower, point);
+        upper = glm::max(upper, point);
+    }
+    const glm::vec3 extent {glm::max(upper - lower, glm::vec3(std::numeric_limits<float>::min()))};
+    constexpr float gridSize {(1 << 21) - 1};
+
+    std::vector<std::pair<uint64_t, uint32_t>> codes(count);
+    for (uint32_t i {0}; i < count; i++)
+    {
+        const glm::vec3 cell {((m_points[i] + m_points[i + 1]) * 0.5f - lower) / extent * gridSize};
+        codes[i] = {mortonCode(static_cast<uint32_t>(cell.x), static_cast<uint32_t>(cell.y),
+                               static_cast<uint32_t>(cell.z)), i};
+    }
+    std::sort(codes.begin(), codes.end());
+
+    m_segments.resize(count);
+    for (std::size_t i {0}; i < count; i++)
+        m_segments[i] = codes[i].second;
+    m_nodes.reserve(2 * count / leafSize + 1);
+    buildNode(codes, 0, static_cast<uint32_t>(count));
+}
+
+/**
+ * Splits at the highest bit in which the Morton codes of the range differ, that is at a grid plane.
+ */
+static uint32_t findSplit(const std::vector<std::pair<uint64_t, uint32_t>>& codes, uint32_t begin, uint32_t end)
+{
+    const uint64_t first {codes[begin].first};
+    const uint64_t last {codes[end - 1].first};
+    if (first == last)
+        return begin + (end - begin) / 2;
+
+    uint64_t highestBit {uint64_t(1) << 63};
+    while (!((first ^ last) & highestBit))
+        highestBit >>= 1;
+    // the first code with the bit set
+    const auto split {std::partition_point(codes.begin() + begin, codes.begin() + end,
+                                           [highestBit](const auto& code) { return !(code.first & highestBit); })};
+    return static_cast<uint32_t>(split - codes.begin());
+}
+
+uint32_t SegmentIndex::buildNode(const std::vector<std::pair<uint64_t, uint32_t>>& codes, uint32_t begin, uint32_t end)
+{
+    const auto index {static_cast<uint32_t>(m_nodes.size())};
+    m_nodes.push_back({});
+
+    if (end - begin <= leafSize)
+    {
+        glm::vec3 lower {std::numeric_limits<float>::max()};
+        glm::vec3 upper {std::numeric_limits<float>::lowest()};
+        for (uint32_t i {begin}; i < end; i++)
+        {
+            const uint32_t segment {m_segments[i]};
+            lower = glm::min(lower, glm::min(m_points[segment], m_points[segment + 1]));
+            upper = glm::max(upper, glm::max(m_points[segment], m_points[segment + 1]));
+        }
+        m_nodes[index] = {lower, upper, begin, end - begin};
+        return index;
+    }
+
+    const uint32_t split {findSplit(codes, begin, end)};
+    const uint32_t left {buildNode(codes, begin, split)};
+    const uint32_t right {buildNode(codes, split, end)};
+    m_nodes[index] = {glm::min(m_nodes[left].lower, m_nodes[right].lower),
+                      glm::max(m_nodes[left].upper, m_nodes[right].upper), right, 0};
+    return index;
+}
+
+static float boxDistance2(const glm::vec3& lower, const glm::vec3& upper, const glm::vec3& point)
+{
+    const glm::vec3 d {glm::max(glm::max(lower - point, point - upper), glm::vec3(0.0f))};
+    return glm::dot(d, d);
+}
+
+std::optional<SegmentIndex::Hit> SegmentIndex::nearest(const glm::vec3& point, float maxDistance) const
+{
+    if (m_nodes.empty())
+        return std::nullopt;
+
+    std::optional<Hit> hit;
+    float best2 {maxDistance * maxDistance};
+    uint32_t stack[128];
+    int top {0};
+    stack[top++] = 0;
+    while (top > 0)
+    {
+        const Node& node {m_nodes[stack[--top]]};
+        if (boxDistance2(node.lower, node.upper, point) > best2)
+            continue;
+
+        if (node.count == 0)
+        {
+            // nearer child last, so it is visited first
+            uint32_t left {static_cast<uint32_t>(&node - m_nodes.data()) + 1};
+            uint32_t right {node.first};
+            if (boxDistance2(m_nodes[left].lower, m_nodes[left].upper, point) <
+                boxDistance2(m_nodes[right].lower, m_nodes[right].upper, point))
+                std::swap(left, right);
+            stack[top++] = left;
+            stack[top++] = right;
+            continue;
+        }
+
+        for (uint32_t i {node.first}; i < node.first + node.count; i++)
+        {
+            const uint32_t segment {m_segments[i]};
+            const glm::vec3& a {m_points[segment]};
+            const glm::vec3 e {m_points[segment + 1] - a};
+            const float ee {glm::dot(e, e)};
+            const float t {ee > 0.0f ? glm::clamp(glm::dot(point - a, e) / ee, 0.0f, 1.0f) : 0.0f};
+            const glm::vec3 closest {a + t * e};
+            const glm::vec3 d {point - closest};
+            const float distance2 {glm::dot(d, d)};
+            if (distance2 <= best2)
+            {
+                best2 = distance2;
+                hit = Hit{segment, std::sqrt(distance2), closest};
+            }
+        }
+    }
+    return hit;
+}
+
+/**
+ * Whether the line intersects the box grown by margin in every direction.
+ */
+static bool lineHitsBox(const glm::vec3& lower, const glm::vec3& upper, float margin,
+                        const glm::vec3& origin, const glm::vec3& direction)
+{
+    float tMin {std::numeric_limits<float>::lowest()};
+    float tMax {std::numeric_limits<float>::max()};
+    for (int k {0}; k < 3; k++)
+    {
+        const float lo {lower[k] - margin};
+        const float hi {upper[k] + margin};
+        if (std::abs(direction[k]) < 1e-12f)
+        {
+            if (origin[k] < lo || origin[k] > hi)
+                return false;
+            continue;
+        }
+        float t1 {(lo - origin[k]) / direction[k]};
+        float t2 {(hi - origin[k]) / direction[k]};
+        if (t1 > t2)
+            std::swap(t1, t2);
+        tMin = std::max(tMin, t1);
+        tMax = std::min(tMax, t2);
+        if (tMin > tMax)
+            return false;
+    }
+    return true;
+}
+
+std::optional<SegmentIndex::Hit> SegmentIndex::pick(const glm::vec3& origin, const glm::vec3& direction, float radius) const
+{
+    if (m_nodes.empty() || glm::dot(direction, direction) == 0.0f)
+        return std::nullopt;
+
+    const glm::vec3 d {glm::normalize(direction)};
+    std::optional<Hit> hit;
+    float best {radius};
+    float bestDepth {std::numeric_limits<float>::max()};
+    uint32_t stack[128];
+    int top {0};
+    stack[top++] = 0;
+    while (top > 0)
+    {
+        const uint32_t index {stack[--top]};
+        const Node& node {m_nodes[index]};
+        if (!lineHitsBox(node.lower, node.upper, best, origin, d))
+            continue;
+
+        if (node.count == 0)
+        {
+            stack[top++] = node.first;
+            stack[top++] = index + 1;
+            continue;
+        }
+
+        for (uint32_t i {node.first}; i < node.first + node.count; i++)
+        {
+            // closest points of the line origin + s * d and the segment a + t * e
+            const uint32_t segment {m_segments[i]};
+            const glm::vec3& a {m_points[segment]};
+            const glm::vec3 e {m_points[segment + 1] - a};
+            const glm::vec3 r {origin - a};
+            const float ee {glm::dot(e, e)};
+            const float de {glm::dot(d, e)};
+            const float dr {glm::dot(d, r)};
+            const float denominator {ee - de * de};
+            const float t {denominator > 1e-12f * ee ? glm::clamp((glm::dot(e, r) - de * dr) / denominator, 0.0f, 1.0f)
+                                                     : 0.0f};
+            const glm::vec3 closest {a + t * e};
+            const float s {glm::dot(closest - origin, d)};
+            const float distance {glm::length(origin + s * d - closest)};
+            if (distance < best || (distance == best && s < bestDepth))
+            {
+                best = distance;
+                bestDepth = s;
+                hit = Hit{segment, distance, closest};
+            }
+        }
+    }
+    return hit;
+}
@@ -0,0 +1,55 @@
+#ifndef SEGMENTINDEX_H
+#define SEGMENTINDEX_H
+
+#include <glm/vec3.hpp>
+
+#include <cstdint>
+#include <optional>
+#include <utility>
+#include <vector>
+
+/**
+ * Bounding volume hierarchy over the segments of a polyline, segment i connects point i and point i + 1.
+ * Answers nearest segment queries for a point (snapping) and for a line of sight (picking).
+ */
+class SegmentIndex
+{
+public:
+    struct Hit
+    {
+        std::size_t segment;
+        float distance;   // from the query point or line
+        glm::vec3 point;  // closest point on the segment
+    };
+
+    void clear() noexcept;
+    void build(std::vector<glm::vec3> points);
+    bool isEmpty() const noexcept { return m_nodes.empty(); }
+    std::size_t segmentCount() const noexcept { return m_points.size() > 1 ? m_points.size() - 1 : 0; }
+
+    std::optional<Hit> nearest(const glm::vec3& point, float maxDistance) const;
+    /**
+     * The segment closest to the line through origin in direction, within radius. Of segments with
+     * equal distance the one nearest to origin wins, so origin should be on the viewer side.
+     */
+    std::optional<Hit> pick(const glm::vec3& origin, const glm::vec3& direction, float radius) const;
+
+    static constexpr std::size_t leafSize {4};
+
+private:
+    struct Node
+    {
+        glm::vec3 lower;
+        glm::vec3 upper;
+        uint32_t first;  // first segment in m_segments for leaves, right child for inner nodes
+        uint32_t count;  // segment count, 0 for inner nodes, the left child follows its parent
+    };
+
+    uint32_t buildNode(const std::vector<std::pair<uint64_t, uint32_t>>& codes, uint32_t begin, uint32_t end);
+
+    std::vector<glm::vec3> m_points;
+    std::vector<uint32_t> m_segments;
+    std::vector<Node> m_nodes;
+};
+
+#endif // SEGMENTINDEX_H
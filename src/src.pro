@@ -1,8 +1,11 @@
 QT += core gui
-greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
+greaterThan(QT_MAJOR_VERSION, 4): QT += widgets concurrent
 
 CONFIG += c++17
 
+# lets the compiler vectorize the row loops of the stock simulation, nothing checks errno or FP exceptions
+gcc: QMAKE_CXXFLAGS_RELEASE += -ftree-vectorize -fno-math-errno -fno-trapping-math
+
 # The following define makes your compiler emit warnings if you use
 # any Qt feature that has been marked deprecated (the exact warnings
 # depend on your compiler). Please consult the documentation of the
@@ -22,40 +25,76 @@ TARGET = cncedit
 
 SOURCES += \
     backplotwidget.cpp \
+    batchverifier.cpp \
     boundingbox.cpp \
     codeeditor.cpp \
     controller.cpp \
+    crossreferenceindex.cpp \
+    cycletimeestimator.cpp \
     documentview.cpp \
+    evaluationcache.cpp \
     expr.cpp \
     geometry.cpp \
     highlighter.cpp \
     main.cpp \
     mainwindow.cpp \
+    motionlist.cpp \
+    motionlog.cpp \
     ncprogramblock.cpp \
+    orthographiccamera.cpp \
     orthographicviewwidget.cpp \
     parser.cpp \
+    pathrasterizer.cpp \
+    pathtimeline.cpp \
+    playbackbar.cpp \
+    programbrowser.cpp \
+    programindex.cpp \
+    programtransform.cpp \
     s840d_alarm.cpp \
+    segmentindex.cpp \
+    stocksimulator.cpp \
+    stockview.cpp \
+    transformdialog.cpp \
     value.cpp \
     variables.cpp
 
 HEADERS += \
     backplotwidget.h \
+    batchverifier.h \
     boundingbox.h \
     codeeditor.h \
     controller.h \
+    crossreferenceindex.h \
+    cycletimeestimator.h \
     documentview.h \
+    evaluationcache.h \
     expr.h \
     geometry.h \
     ggroupenum.h \
     highlighter.h \
     mainwindow.h \
     motion.h \
+    motionlist.h \
+    motionlog.h \
     ncprogramblock.h \
+    orthographiccamera.h \
     orthographicviewwidget.h \
+    parallel.h \
     parser.h \
+    pathrasterizer.h \
+    pathtimeline.h \
+    playbackbar.h \
+    plotcolors.h \
+    programbrowser.h \
+    programindex.h \
+    programtransform.h \
     s840d_alarm.h \
     s840d_def.h \
     scopedtimer.h \
+    segmentindex.h \
+    stocksimulator.h \
+    stockview.h \
+    transformdialog.h \
     util.h \
     value.h \
     variables.h
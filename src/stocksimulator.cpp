@@ -0,0 +1,418 @@
+#include "stocksimulator.h"
+#include "motion.h"
+#include "parallel.h"
+
+#include <glm/common.hpp>
+#include <glm/geometric.hpp>
+#include <glm/gtc/constants.hpp>
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <limits>
+#include <sstream>
+
+// material thinner than this is not counted as cut, so touching the surface does not mark it
+static constexpr float cutTolerance {1e-3f};
+static constexpr std::size_t maxArcSamples {1024};
+
+StockSimulator::StockSimulator(double cellSize)
+    : m_minCellSize(cellSize),
+      m_cellSize(cellSize)
+{
+    clear();
+}
+
+void StockSimulator::setTool(int number, const Tool& tool)
+{
+    m_tools[number] = tool;
+}
+
+std::optional<std::map<int, StockSimulator::Tool>> StockSimulator::parseToolTable(const std::string& text)
+{
+    std::string normalized {text};
+    std::replace(normalized.begin(), normalized.end(), ',', ' ');
+    std::istringstream stream {normalized};
+
+    std::map<int, Tool> tools;
+    std::string entry;
+    while (stream >> entry)
+    {
+        // T<number>=<F|B><diameter>
+        const auto equals {entry.find('=')};
+        if (equals == std::string::npos || equals < 2 || equals + 2 >= entry.size() ||
+            std::toupper(static_cast<unsigned char>(entry[0])) != 'T')
+            return std::nullopt;
+
+        Tool tool;
+        switch (std::toupper(static_cast<unsigned char>(entry[equals + 1])))
+        {
+        case 'F':
+            tool.shape = Tool::FlatEnd;
+            break;
+        case 'B':
+            tool.shape = Tool::BallEnd;
+            break;
+        default:
+            return std::nullopt;
+        }
+
+        try
+        {
+            std::size_t end;
+            const int number {std::stoi(entry.substr(1, equals - 1), &end)};
+            if (end != equals - 1 || number < 0)
+                return std::nullopt;
+            const std::string diameterText {entry.substr(equals + 2)};
+            const double diameter {std::stod(diameterText, &end)};
+            if (end != diameterText.size() || !(diameter > 0.0))
+                return std::nullopt;
+            tool.radius = diameter / 2.0;
+            tools[number] = tool;
+        }
+        catch (const std::exception&)
+        {
+            return std::nullopt;
+        }
+    }
+    return tools;
+}
+
+void StockSimulator::clear() noexcept
+{
+    m_tool = m_defaultTool;
+    m_position = glm::dvec3 {0.0};
+    m_moved = false;
+    m_sweeps.clear();
+    m_lower = glm::dvec2 {std::numeric_limits<double>::max()};
+    m_upper = glm::dvec2 {std::numeric_limits<double>::lowest()};
+    m_stockTop = std::numeric_limits<double>::lowest();
+    m_cellSize = m_minCellSize;
+    m_origin = glm::dvec2 {0.0};
+    m_columns = 0;
+    m_rows = 0;
+    m_heights.clear();
+    m_states.clear();
+}
+
+std::optional<std::size_t> StockSimulator::cellIndex(const glm::dvec2& point) const
+{
+    const glm::dvec2 cell {glm::floor((point - m_origin) / m_cellSize)};
+    if (cell.x < 0.0 || cell.y < 0.0 || cell.x >= m_columns || cell.y >= m_rows)
+        return std::nullopt;
+    return static_cast<std::size_t>(cell.y) * m_columns + static_cast<std::size_t>(cell.x);
+}
+
+double StockSimulator::heightAt(const glm::dvec2& point) const
+{
+    const auto index {cellIndex(point)};
+    return index ? m_heights[*index] : m_stockTop;
+}
+
+StockSimulator::CellState StockSimulator::stateAt(const glm::dvec2& point) const
+{
+    const auto index {cellIndex(point)};
+    return index ? m_states[*index] : Uncut;
+}
+
+void StockSimulator::startPoint(const glm::dvec3& point)
+{
+    clear();
+    m_position = point;
+}
+
+void StockSimulator::blockChange(size_t /*blockNumber*/)
+{
+}
+
+void StockSimulator::toolChange(int tool, int /*edge*/)
+{
+    const auto it {m_tools.find(tool)};
+    m_tool = it != m_tools.end() ? it->second : m_defaultTool;
+}
+
+void StockSimulator::linearMotion(const LinearMotion& linearMotion)
+{
+    if (!std::exchange(m_moved, true))
+    {
+        m_position = linearMotion.getEndPoint();
+        return;
+    }
+    addSweep(linearMotion.getEndPoint(), linearMotion.getFeed() == 0.0);
+}
+
+/**
+ * Enough samples for a chord error of a quarter cell.
+ */
+static std::size_t arcSampleCount(double radius, double sweep, double cellSize)
+{
+    const double tolerance {cellSize / 4.0};
+    const double step {tolerance < radius ? 2.0 * std::acos(1.0 - tolerance / radius) : glm::half_pi<double>()};
+    return std::clamp<std::size_t>(static_cast<std::size_t>(std::ceil(std::abs(sweep) / step)), 1, maxArcSamples);
+}
+
+void StockSimulator::circularMotion(const CircularMotion& circularMotion)
+{
+    const DirectedArc3& arc {circularMotion.getArc()};
+    const double radius {glm::length(arc.arc2.point1 - arc.arc2.center)};
+    std::vector<glm::dvec3> points(arcSampleCount(radius, DirectedArc2Sampler{arc.arc2}.angle(), m_minCellSize));
+    DirectedArc3Sampler {arc}.sampleN(points.size(), points.data());
+
+    if (!std::exchange(m_moved, true))
+    {
+        m_position = points.back();
+        return;
+    }
+    for (const auto& point : points)
+        addSweep(point, circularMotion.getFeed() == 0.0);
+}
+
+void StockSimulator::helicalMotion(const HelicalMotion& helicalMotion)
+{
+    const Helix& helix {helicalMotion.getHelix()};
+    const double radius {glm::length(helix.arc2.point1 - helix.arc2.center)};
+    const double sweep {std::abs(DirectedArc2Sampler{helix.arc2}.angle()) + helix.turn * glm::two_pi<double>()};
+    std::vector<glm::dvec3> points(arcSampleCount(radius, sweep, m_minCellSize));
+    HelixSampler {helix}.sampleN(points.size(), points.data());
+
+    if (!std::exchange(m_moved, true))
+    {
+        m_position = points.back();
+        return;
+    }
+    for (const auto& point : points)
+        addSweep(point, helicalMotion.getFeed() == 0.0);
+}
+
+void StockSimulator::endOfProgram()
+{
+    simulate();
+}
+
+void StockSimulator::addSweep(const glm::dvec3& end, bool rapid)
+{
+    const glm::dvec3 start {std::exchange(m_position, end)};
+    if (start == end)
+        return;
+
+    m_sweeps.push_back({glm::vec3(start), glm::vec3(end), static_cast<float>(m_tool.radius),
+                      m_tool.shape == Tool::BallEnd, rapid});
+    if (!rapid)
+    {
+        const glm::dvec2 radius {m_tool.radius};
+        m_lower = glm::min(m_lower, glm::min(glm::dvec2(start), glm::dvec2(end)) - radius);
+        m_upper = glm::max(m_upper, glm::max(glm::dvec2(start), glm::dvec2(end)) + radius);
+        m_stockTop = std::max({m_stockTop, start.z, end.z});
+    }
+}
+
+void StockSimulator::simulate()
+{
+    if (m_lower.x > m_upper.x)
+        return;
+
+    const glm::dvec2 size {m_upper - m_lower};
+    m_cellSize = std::max(m_minCellSize, std::sqrt(size.x * size.y / maxCellCount));
+    m_origin = m_lower;
+    m_columns = std::max<std::size_t>(1, static_cast<std::size_t>(std::ceil(size.x / m_cellSize)));
+    m_rows = std::max<std::size_t>(1, static_cast<std::size_t>(std::ceil(size.y / m_cellSize)));
+    m_heights.assign(m_columns * m_rows, static_cast<float>(m_stockTop));
+    m_states.assign(m_columns * m_rows, Uncut);
+
+    // the sweeps touching each band, in program order
+    const std::size_t bandCount {(m_rows + bandRows - 1) / bandRows};
+    std::vector<std::vector<uint32_t>> bands(bandCount);
+    for (uint32_t i {0}; i < m_sweeps.size(); i++)
+    {
+        const Sweep& sweep {m_sweeps[i]};
+        // above the stock, like most rapid motions
+        if (std::min(sweep.start.z, sweep.end.z) >= m_stockTop)
+            continue;
+        const double lowerY {std::min(sweep.start.y, sweep.end.y) - sweep.radius - m_origin.y};
+        const double upperY {std::max(sweep.start.y, sweep.end.y) + sweep.radius - m_origin.y};
+        if (upperY < 0.0 || lowerY >= m_rows * m_cellSize)
+            continue;
+        const auto first {static_cast<std::size_t>(std::max(0.0, lowerY / m_cellSize)) / bandRows};
+        const auto last {std::min(static_cast<std::size_t>(upperY / m_cellSize) / bandRows, bandCount - 1)};
+        for (std::size_t band {first}; band <= last; band++)
+            bands[band].push_back(i);
+    }
+
+    parallelFor(bandCount, 1, [this, &bands](std::size_t begin, std::size_t end)
+    {
+        for (std::size_t band {begin}; band < end; band++)
+            cutBand(band, bands[band]);
+    });
+}
+
+/**
+ * A sweep relative to its start point, with the per sweep terms of the row loops.
+ */
+struct SweepTerms
+{
+    glm::vec3 d;          // end - start
+    float z;              // start height
+    float r;
+    float r2;
+    float dd2;            // |d|² in the XY plane
+    float inverseDd2;
+    float inverseDd3;     // 1 / |d|²
+    float cylinderA;      // 1 - d.z² / |d|², 0 for vertical sweeps
+    float inverseCylinderA;
+};
+
+static constexpr float infinity {std::numeric_limits<float>::infinity()};
+
+/**
+ * Lowers the cells to the bottom of the tool, if it is lower by more than the tolerance.
+ */
+static inline void lowerCell(float h, uint8_t cutState, float& height, uint8_t& state)
+{
+    // values instead of conditions and references, so the float and byte parts vectorize together
+    const float oldHeight {height};
+    const uint8_t oldState {state};
+    const bool isCut {h < oldHeight - cutTolerance};
+    const auto mask {static_cast<uint8_t>(-static_cast<uint8_t>(isCut))};
+    height = isCut ? h : oldHeight;
+    state = std::max(oldState, static_cast<uint8_t>(mask & cutState));
+}
+
+/**
+ * A flat end tool covers the cell center for the parameters t in [t0, t1] with |w - t d|² <= r²,
+ * the bottom is the lower of the heights at both of them.
+ */
+static void cutFlatEndRow(const SweepTerms& sweep, float wx, float wy, float cellSize,
+                          uint8_t cutState, float* heights, uint8_t* states, int count)
+{
+    if (sweep.dd2 <= 1e-12f)
+    {
+        // vertical
+        const float bottom {sweep.z + std::min(sweep.d.z, 0.0f)};
+        for (int i {0}; i < count; i++)
+        {
+            const float x {wx + i * cellSize};
+            lowerCell(x * x + wy * wy <= sweep.r2 ? bottom : infinity, cutState, heights[i], states[i]);
+        }
+        return;
+    }
+
+    for (int i {0}; i < count; i++)
+    {
+        const float x {wx + i * cellSize};
+        const float ww {x * x + wy * wy};
+        const float wd {x * sweep.d.x + wy * sweep.d.y};
+        const float discriminant {wd * wd - sweep.dd2 * (ww - sweep.r2)};
+        const float root {std::sqrt(std::max(discriminant, 0.0f))};
+        const float t0 {std::max((wd - root) * sweep.inverseDd2, 0.0f)};
+        const float t1 {std::min((wd + root) * sweep.inverseDd2, 1.0f)};
+        const float h {discriminant >= 0.0f ? sweep.z + std::min(t0 * sweep.d.z, t1 * sweep.d.z) : infinity};
+        lowerCell(t0 <= t1 ? h : infinity, cutState, heights[i], states[i]);
+    }
+}
+
+/**
+ * A ball end tool sweeps a capsule, the balls at both ends and the cylinder between them.
+ * The bottom is the lowest intersection of the vertical line through the cell center with them.
+ */
+static void cutBallEndRow(const SweepTerms& sweep, float wx, float wy, float cellSize,
+                          uint8_t cutState, float* heights, uint8_t* states, int count)
+{
+    const bool hasCylinder {sweep.cylinderA > 1e-6f};
+    for (int i {0}; i < count; i++)
+    {
+        const float x {wx + i * cellSize};
+        const float ww {x * x + wy * wy};
+        const float ex {x - sweep.d.x};
+        const float ey {wy - sweep.d.y};
+        const float ee {ex * ex + ey * ey};
+        const float hStart {ww <= sweep.r2 ? sweep.z + sweep.r - std::sqrt(std::max(sweep.r2 - ww, 0.0f)) : infinity};
+        const float hEnd {ee <= sweep.r2 ? sweep.z + sweep.d.z + sweep.r - std::sqrt(std::max(sweep.r2 - ee, 0.0f))
+                                         : infinity};
+
+        // s relative to the center of the start ball
+        const float wd {x * sweep.d.x + wy * sweep.d.y};
+        const float b {wd * sweep.d.z * sweep.inverseDd3};
+        const float c {ww - wd * wd * sweep.inverseDd3 - sweep.r2};
+        const float discriminant {b * b - sweep.cylinderA * c};
+        const float s {(b - std::sqrt(std::max(discriminant, 0.0f))) * sweep.inverseCylinderA};
+        const float t {(wd + s * sweep.d.z) * sweep.inverseDd3};
+        const float hCylinder {discriminant >= 0.0f && hasCylinder ? sweep.z + sweep.r + s : infinity};
+        const float hBetween {t >= 0.0f ? (t <= 1.0f ? hCylinder : infinity) : infinity};
+
+        lowerCell(std::min(std::min(hStart, hEnd), hBetween), cutState, heights[i], states[i]);
+    }
+}
+
+/**
+ * Lowers the cells of the band to the bottom of the tool moved along the sweeps. The tool
+ * bottom above a cell center is found in closed form. The row loops have no data dependent
+ * branches, so the compiler can vectorize them.
+ */
+void StockSimulator::cutBand(std::size_t band, const std::vector<uint32_t>& sweeps)
+{
+    const auto cellSize {static_cast<float>(m_cellSize)};
+    const std::size_t firstRow {band * bandRows};
+    const std::size_t endRow {std::min(firstRow + bandRows, m_rows)};
+
+    for (const uint32_t index : sweeps)
+    {
+        const Sweep& sweep {m_sweeps[index]};
+        const float r {sweep.radius};
+        const uint8_t cutState {sweep.rapid ? RapidCut : Cut};
+
+        // rows of the bounding box of the sweep
+        const float lowerY {(std::min(sweep.start.y, sweep.end.y) - r - static_cast<float>(m_origin.y)) / cellSize};
+        const float upperY {(std::max(sweep.start.y, sweep.end.y) + r - static_cast<float>(m_origin.y)) / cellSize};
+        if (upperY < 0.0f || lowerY >= endRow)
+            continue;
+        const std::size_t beginRow {std::max(firstRow, static_cast<std::size_t>(std::max(0.0f, lowerY)))};
+        const std::size_t rowEnd {std::min(static_cast<std::size_t>(upperY) + 1, endRow)};
+
+        const glm::vec3 a {sweep.start};
+        SweepTerms terms;
+        terms.d = sweep.end - sweep.start;
+        terms.z = a.z;
+        terms.r = r;
+        terms.r2 = r * r;
+        terms.dd2 = terms.d.x * terms.d.x + terms.d.y * terms.d.y;
+        terms.inverseDd2 = terms.dd2 > 0.0f ? 1.0f / terms.dd2 : 0.0f;
+        terms.inverseDd3 = 1.0f / glm::dot(terms.d, terms.d);
+        terms.cylinderA = terms.dd2 * terms.inverseDd3;
+        terms.inverseCylinderA = terms.cylinderA > 0.0f ? 1.0f / terms.cylinderA : 0.0f;
+        const glm::vec3& d {terms.d};
+
+        for (std::size_t row {beginRow}; row < rowEnd; row++)
+        {
+            const float wy {static_cast<float>(m_origin.y) + (row + 0.5f) * cellSize - a.y};
+
+            // columns within r of the part of the segment within r of the row
+            float tLow {0.0f};
+            float tHigh {1.0f};
+            if (std::abs(d.y) > 1e-12f)
+            {
+                const float t0 {(wy - r) / d.y};
+                const float t1 {(wy + r) / d.y};
+                tLow = std::max(tLow, std::min(t0, t1));
+                tHigh = std::min(tHigh, std::max(t0, t1));
+                if (tLow > tHigh)
+                    continue;
+            }
+            const float lowerX {(a.x + std::min(tLow * d.x, tHigh * d.x) - r - static_cast<float>(m_origin.x)) / cellSize};
+            const float upperX {(a.x + std::max(tLow * d.x, tHigh * d.x) + r - static_cast<float>(m_origin.x)) / cellSize};
+            if (upperX < 0.0f || lowerX >= m_columns)
+                continue;
+            const std::size_t beginColumn {static_cast<std::size_t>(std::max(0.0f, lowerX))};
+            const std::size_t endColumn {std::min(static_cast<std::size_t>(upperX) + 1, m_columns)};
+
+            const float wx {static_cast<float>(m_origin.x) + (beginColumn + 0.5f) * cellSize - a.x};
+            float* heights {&m_heights[row * m_columns + beginColumn]};
+            // the states as their underlying type, which the vectorizer handles
+            auto states {reinterpret_cast<uint8_t*>(&m_states[row * m_columns + beginColumn])};
+            const auto count {static_cast<int>(endColumn - beginColumn)};
+            if (sweep.ballEnd)
+                cutBallEndRow(terms, wx, wy, cellSize, cutState, heights, states, count);
+            else
+                cutFlatEndRow(terms, wx, wy, cellSize, cutState, heights, states, count);
+        }
+    }
+}
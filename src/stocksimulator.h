@@ -0,0 +1,124 @@
+#ifndef STOCKSIMULATOR_H
+#define STOCKSIMULATOR_H
+
+#include "controller.h"
+#include "geometry.h"
+
+#include <glm/vec2.hpp>
+#include <glm/vec3.hpp>
+
+#include <cstdint>
+#include <map>
+#include <optional>
+#include <string>
+#include <vector>
+
+/**
+ * Material removal of a 3-axis program on a Z-map, a grid of stock heights over the XY plane.
+ * The stock is the box around the feed motions, its top at their highest point. Motions are
+ * collected while the program runs and cut at the end, the grid is split into bands of rows
+ * which are cut concurrently.
+ *
+ * Tools are looked up by their T number, tools missing in the table are the default tool.
+ * Program coordinates are taken as the tool tip. The first motion starts at an unknown
+ * position and does not cut.
+ */
+class StockSimulator : public ControllerListener
+{
+public:
+    struct Tool
+    {
+        enum Shape
+        {
+            FlatEnd,
+            BallEnd
+        };
+
+        Shape shape {FlatEnd};
+        double radius {5.0};
+    };
+
+    enum CellState : uint8_t
+    {
+        Uncut,
+        Cut,
+        RapidCut  // a rapid motion removed material, the cell keeps this state
+    };
+
+    explicit StockSimulator(double cellSize = 0.1);
+
+    void setTool(int number, const Tool& tool);
+    void setDefaultTool(const Tool& tool) noexcept { m_defaultTool = tool; }
+
+    /**
+     * Parses a tool table like "T1=F10 T2=B6": T number, F for flat end or B for ball end tools,
+     * and the diameter, separated by spaces or commas.
+     */
+    static std::optional<std::map<int, Tool>> parseToolTable(const std::string& text);
+
+    void clear() noexcept;
+
+    std::size_t columns() const noexcept { return m_columns; }
+    std::size_t rows() const noexcept { return m_rows; }
+    double cellSize() const noexcept { return m_cellSize; }
+    /** Lower corner of the stock in the XY plane, cell (0, 0) starts there. */
+    glm::dvec2 origin() const noexcept { return m_origin; }
+    double stockTop() const noexcept { return m_stockTop; }
+
+    // row-major, columns() * rows()
+    const std::vector<float>& heights() const noexcept { return m_heights; }
+    const std::vector<CellState>& states() const noexcept { return m_states; }
+    /** Height of the cell containing the point, the stock top outside of the grid. */
+    double heightAt(const glm::dvec2& point) const;
+    CellState stateAt(const glm::dvec2& point) const;
+
+    // ControllerListener interface
+    void startPoint(const glm::dvec3& point) override;
+    void blockChange(size_t blockNumber) override;
+    void linearMotion(const LinearMotion& linearMotion) override;
+    void circularMotion(const CircularMotion& circularMotion) override;
+    void helicalMotion(const HelicalMotion& helicalMotion) override;
+    void endOfProgram() override;
+    void toolChange(int tool, int edge) override;
+
+    static constexpr std::size_t maxCellCount {2048 * 2048};
+    static constexpr std::size_t bandRows {16};
+
+private:
+    struct Sweep
+    {
+        glm::vec3 start;
+        glm::vec3 end;
+        float radius;
+        bool ballEnd;
+        bool rapid;
+    };
+
+    void addSweep(const glm::dvec3& end, bool rapid);
+    void simulate();
+    void cutBand(std::size_t band, const std::vector<uint32_t>& sweeps);
+    std::optional<std::size_t> cellIndex(const glm::dvec2& point) const;
+
+    std::map<int, Tool> m_tools;
+    Tool m_defaultTool;
+    Tool m_tool;
+
+    glm::dvec3 m_position {0.0};
+    bool m_moved {false};
+    std::vector<Sweep> m_sweeps;
+
+    // stock, from the feed motions
+    glm::dvec2 m_lower;
+    glm::dvec2 m_upper;
+    double m_stockTop;
+
+    double m_minCellSize;
+    double m_cellSize;
+    glm::dvec2 m_origin {0.0};
+    std::size_t m_columns {0};
+    std::size_t m_rows {0};
+    std::vector<float> m_heights;
+    std::vector<CellState> m_states;
+};
+
+#endif // STOCKSIMULATOR_H
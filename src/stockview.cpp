@@ -0,0 +1,98 @@
+#include "stockview.h"
+#include "stocksimulator.h"
+
+#include <QColor>
+#include <QDialogButtonBox>
+#include <QLabel>
+#include <QScrollArea>
+#include <QVBoxLayout>
+
+#include <glm/geometric.hpp>
+
+#include <algorithm>
+
+StockView::StockView(const QImage& image, const QString& summary, QWidget* parent)
+    : QDialog(parent)
+{
+    setWindowTitle(tr("Stock simulation"));
+
+    auto* imageLabel {new QLabel};
+    imageLabel->setPixmap(QPixmap::fromImage(image));
+    auto* scrollArea {new QScrollArea};
+    scrollArea->setWidget(imageLabel);
+    scrollArea->setAlignment(Qt::AlignCenter);
+
+    auto* buttons {new QDialogButtonBox(QDialogButtonBox::Close)};
+    connect(buttons, &QDialogButtonBox::rejected, this, &QDialog::reject);
+
+    auto* layout {new QVBoxLayout(this)};
+    layout->addWidget(scrollArea, 1);
+    layout->addWidget(new QLabel(summary));
+    layout->addWidget(buttons);
+    resize(1000, 800);
+}
+
+QImage StockView::render(const StockSimulator& simulator)
+{
+    const auto columns {static_cast<int>(simulator.columns())};
+    const auto rows {static_cast<int>(simulator.rows())};
+    QImage image {std::max(columns, 1), std::max(rows, 1), QImage::Format_RGB32};
+    image.fill(uncutColor);
+    if (columns == 0 || rows == 0)
+        return image;
+
+    const auto& heights {simulator.heights()};
+    const auto& states {simulator.states()};
+    const float top {static_cast<float>(simulator.stockTop())};
+    const float bottom {*std::min_element(heights.begin(), heights.end())};
+    const float range {std::max(top - bottom, 1e-3f)};
+    const auto cellSize {static_cast<float>(simulator.cellSize())};
+    const glm::vec3 light {glm::normalize(glm::vec3(-1.0f, 1.0f, 2.0f))};
+
+    for (int row {0}; row < rows; row++)
+    {
+        auto* line {reinterpret_cast<QRgb*>(image.scanLine(rows - 1 - row))};
+        for (int column {0}; column < columns; column++)
+        {
+            const std::size_t index {static_cast<std::size_t>(row) * columns + column};
+            auto height = [&](int c, int r)
+            {
+                return heights[static_cast<std::size_t>(std::clamp(r, 0, rows - 1)) * columns + std::clamp(c, 0, columns - 1)];
+            };
+            const glm::vec3 normal {glm::normalize(glm::vec3(height(column - 1, row) - height(column + 1, row),
+                                                             height(column, row - 1) - height(column, row + 1),
+                                                             2.0f * cellSize))};
+            const float shade {0.45f + 0.55f * std::max(glm::dot(normal, light), 0.0f)};
+
+            QColor color;
+            switch (states[index])
+            {
+            case StockSimulator::Uncut:
+                color = QColor::fromRgb(uncutColor);
+                break;
+            case StockSimulator::Cut:
+                // deep blue at the bottom to pale green near the top
+                color = QColor::fromHsvF(0.62f - 0.3f * (heights[index] - bottom) / range, 0.6f, 0.9f);
+                break;
+            case StockSimulator::RapidCut:
+                color = QColor::fromRgb(rapidCutColor);
+                break;
+            }
+            line[column] = qRgb(static_cast<int>(color.red() * shade), static_cast<int>(color.green() * shade),
+                                static_cast<int>(color.blue() * shade));
+        }
+    }
+    return image;
+}
+
+QString StockView::summary(const StockSimulator& simulator)
+{
+    const auto& states {simulator.states()};
+    const auto rapidCuts {std::count(states.begin(), states.end(), StockSimulator::RapidCut)};
+    const auto uncut {std::count(states.begin(), states.end(), StockSimulator::Uncut)};
+    const double cellArea {simulator.cellSize() * simulator.cellSize()};
+    return tr("%1 x %2 cells of %3 mm, stock top Z%4. Uncut: %5 mm², cut by rapid motions (red): %6 mm².")
+            .arg(simulator.columns()).arg(simulator.rows()).arg(simulator.cellSize(), 0, 'g', 3)
+            .arg(simulator.stockTop(), 0, 'f', 3)
+            .arg(uncut * cellArea, 0, 'f', 1).arg(rapidCuts * cellArea, 0, 'f', 1);
+}
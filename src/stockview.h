@@ -0,0 +1,29 @@
+#ifndef STOCKVIEW_H
+#define STOCKVIEW_H
+
+#include <QDialog>
+#include <QImage>
+
+class StockSimulator;
+
+/**
+ * Top view of a simulated stock, shaded by height. Uncut stock and material removed by
+ * rapid motions stand out in their own colors.
+ */
+class StockView : public QDialog
+{
+    Q_OBJECT
+public:
+    StockView(const QImage& image, const QString& summary, QWidget* parent = nullptr);
+
+    /**
+     * One pixel per cell, +Y up. Can be called from any thread.
+     */
+    static QImage render(const StockSimulator& simulator);
+    static QString summary(const StockSimulator& simulator);
+
+    static constexpr QRgb uncutColor {0xffd2c8b4};
+    static constexpr QRgb rapidCutColor {0xffdc2828};
+};
+
+#endif // STOCKVIEW_H
@@ -3,7 +3,10 @@
 flat in vec4 vColor;
 out vec4 color;
 
+// 1 for full colors, less to fade them
+uniform float uIntensity;
+
 void main()
 {
-   color = vColor;
+   color = vec4(mix(vec3(0.6), vColor.rgb, uIntensity), vColor.a);
 }
@@ -0,0 +1,83 @@
+#include "transformdialog.h"
+
+#include <QCheckBox>
+#include <QDialogButtonBox>
+#include <QDoubleSpinBox>
+#include <QFormLayout>
+#include <QGroupBox>
+#include <QHBoxLayout>
+#include <QLabel>
+#include <QSpinBox>
+#include <QVBoxLayout>
+
+TransformDialog::TransformDialog(QWidget* parent)
+    : QDialog(parent),
+      m_renumber(new QGroupBox(tr("Renumber blocks"))),
+      m_renumberStart(new QSpinBox),
+      m_renumberStep(new QSpinBox),
+      m_feedPercent(new QDoubleSpinBox)
+{
+    setWindowTitle(tr("Transform program"));
+
+    m_renumber->setCheckable(true);
+    m_renumber->setChecked(false);
+    m_renumberStart->setRange(0, 99999999);
+    m_renumberStart->setValue(10);
+    m_renumberStep->setRange(1, 10000);
+    m_renumberStep->setValue(10);
+    auto* renumberLayout {new QFormLayout(m_renumber)};
+    renumberLayout->addRow(tr("Start:"), m_renumberStart);
+    renumberLayout->addRow(tr("Step:"), m_renumberStep);
+
+    auto* offsetLayout {new QHBoxLayout};
+    auto* mirrorLayout {new QHBoxLayout};
+    const char axes[] {"XYZ"};
+    for (size_t axis {0}; axis < 3; axis++)
+    {
+        m_offset[axis] = new QDoubleSpinBox;
+        m_offset[axis]->setRange(-100000.0, 100000.0);
+        m_offset[axis]->setDecimals(4);
+        m_offset[axis]->setPrefix(QStringLiteral("%1 ").arg(axes[axis]));
+        offsetLayout->addWidget(m_offset[axis]);
+        m_mirror[axis] = new QCheckBox(QString(axes[axis]));
+        mirrorLayout->addWidget(m_mirror[axis]);
+    }
+    mirrorLayout->addStretch();
+
+    m_feedPercent->setRange(1.0, 1000.0);
+    m_feedPercent->setValue(100.0);
+    m_feedPercent->setSuffix(QStringLiteral(" %"));
+
+    auto* form {new QFormLayout};
+    form->addRow(tr("Offset:"), offsetLayout);
+    form->addRow(tr("Mirror:"), mirrorLayout);
+    form->addRow(tr("Feed:"), m_feedPercent);
+
+    auto* note {new QLabel(tr("Absolute X, Y, Z are mirrored and then shifted. Words with computed values are kept."))};
+    note->setWordWrap(true);
+
+    auto* buttons {new QDialogButtonBox(QDialogButtonBox::Ok | QDialogButtonBox::Cancel)};
+    connect(buttons, &QDialogButtonBox::accepted, this, &QDialog::accept);
+    connect(buttons, &QDialogButtonBox::rejected, this, &QDialog::reject);
+
+    auto* layout {new QVBoxLayout(this)};
+    layout->addWidget(m_renumber);
+    layout->addLayout(form);
+    layout->addWidget(note);
+    layout->addWidget(buttons);
+}
+
+ProgramTransform::Options TransformDialog::options() const
+{
+    ProgramTransform::Options options;
+    options.renumber = m_renumber->isChecked();
+    options.renumberStart = static_cast<uint32_t>(m_renumberStart->value());
+    options.renumberStep = static_cast<uint32_t>(m_renumberStep->value());
+    for (size_t axis {0}; axis < 3; axis++)
+    {
+        options.offset[static_cast<glm::length_t>(axis)] = m_offset[axis]->value();
+        options.mirror[axis] = m_mirror[axis]->isChecked();
+    }
+    options.feedPercent = m_feedPercent->value();
+    return options;
+}
@@ -0,0 +1,33 @@
+#ifndef TRANSFORMDIALOG_H
+#define TRANSFORMDIALOG_H
+
+#include "programtransform.h"
+
+#include <QDialog>
+
+class QCheckBox;
+class QDoubleSpinBox;
+class QGroupBox;
+class QSpinBox;
+
+/**
+ * Asks for the options of a ProgramTransform.
+ */
+class TransformDialog : public QDialog
+{
+    Q_OBJECT
+public:
+    explicit TransformDialog(QWidget* parent = nullptr);
+
+    ProgramTransform::Options options() const;
+
+private:
+    QGroupBox* m_renumber;
+    QSpinBox* m_renumberStart;
+    QSpinBox* m_renumberStep;
+    std::array<QDoubleSpinBox*, 3> m_offset;
+    std::array<QCheckBox*, 3> m_mirror;
+    QDoubleSpinBox* m_feedPercent;
+};
+
+#endif // TRANSFORMDIALOG_H
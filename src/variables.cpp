@@ -3,6 +3,7 @@
 
 #include <algorithm>
 #include <new>
+#include <stdexcept>
 
 Variables::DefineResult Variables::define(const std::string& name, ValueType type) noexcept
 {
@@ -51,23 +52,21 @@ Variables::DefineResult Variables::defineArray(const std::string& name,
         switch (arrayDimensions.size())
         {
         case 1:
-            valueArrays1[to_upper_copy(name)] = std::vector<Value> {
-                    static_cast<std::size_t>(arrayDimensions[0]), createDefaultValue(type)};
+            valueArrays1[to_upper_copy(name)] = createArrayStorage(
+                type, static_cast<std::size_t>(arrayDimensions[0]));
             break;
         case 2:
             valueArrays2[to_upper_copy(name)] = {
-                std::vector<Value> {
-                    static_cast<std::size_t>(arrayDimensions[0]*arrayDimensions[1]),
-                    createDefaultValue(type)},
-                static_cast<std::size_t>(arrayDimensions[0])};
+                createArrayStorage(
+                    type, static_cast<std::size_t>(arrayDimensions[0]*arrayDimensions[1])),
+                static_cast<std::size_t>(arrayDimensions[1])};
             break;
         case 3:
             valueArrays3[to_upper_copy(name)] = {
-                std::vector<Value> {
-                    static_cast<std::size_t>(arrayDimensions[0]*arrayDimensions[1]*arrayDimensions[2]),
-                    createDefaultValue(type)},
-                static_cast<std::size_t>(arrayDimensions[0]),
-                static_cast<std::size_t>(arrayDimensions[1])};
+                createArrayStorage(
+                    type, static_cast<std::size_t>(arrayDimensions[0]*arrayDimensions[1]*arrayDimensions[2])),
+                static_cast<std::size_t>(arrayDimensions[1]),
+                static_cast<std::size_t>(arrayDimensions[2])};
             break;
         default:
             return DefineResult::InvalidDimensionCount;
@@ -122,10 +121,53 @@ Variables::AccessResult Variables::setValue(const std::string& name, const Value
     return AccessResult::Success;
 }
 
-//template <typename T>
-static bool validIndex(int index, const std::vector<Value>& vector)
+static bool validIndex(std::size_t index, std::size_t size)
+{
+    return index < size;
+}
+
+static bool validIndex(int index, std::size_t size)
+{
+    return index >= 0 && static_cast<std::size_t>(index) < size;
+}
+
+Variables::ArrayStorage Variables::createArrayStorage(ValueType type, std::size_t size)
+{
+    switch (type)
+    {
+    case ValueType::INT:    return std::vector<s840d_int_t>(size, 0);
+    case ValueType::REAL:   return std::vector<s840d_real_t>(size, 0.0);
+    case ValueType::BOOL:   return std::vector<s840d_bool_t>(size, false);
+    case ValueType::CHAR:   return std::vector<s840d_char_t>(size, 0);
+    case ValueType::STRING: return std::vector<s840d_string_t>(size);
+    }
+    throw std::runtime_error{"unreachable"};
+}
+
+std::size_t Variables::arraySize(const ArrayStorage& storage) noexcept
+{
+    return std::visit([](auto& arr) { return arr.size(); }, storage);
+}
+
+Value Variables::loadArrayValue(const ArrayStorage& storage, std::size_t index)
+{
+    return std::visit([=](auto& arr) {
+        using T = typename std::decay_t<decltype(arr)>::value_type;
+        return Value{std::in_place_type<T>, arr[index]};
+    }, storage);
+}
+
+bool Variables::storeArrayValue(ArrayStorage& storage, std::size_t index, const Value& value)
 {
-    return index >= 0 && static_cast<size_t>(index) < vector.size();
+    // element type is fixed at definition time, so no conversion here
+    if (storage.index() != value.index())
+        return false;
+
+    std::visit([&](auto& arr) {
+        using T = typename std::decay_t<decltype(arr)>::value_type;
+        arr[index] = std::get<T>(value);
+    }, storage);
+    return true;
 }
 
 Variables::AccessResult Variables::setArray1Value(const std::string& name, int index, const Value& value) noexcept
@@ -134,13 +176,12 @@ Variables::AccessResult Variables::setArray1Value(const std::string& name, int i
     if (it == valueArrays1.end())
         return AccessResult::DoNotExists;
 
-    if (!validIndex(index, it->second))
+    if (!validIndex(index, arraySize(it->second)))
         return AccessResult::ArrayIndexOutOfBounds;
 
-    if (getValueType(it->second[index]) != getValueType(value))
+    if (!storeArrayValue(it->second, index, value))
         return AccessResult::TypeMismatch;
 
-    it->second[index] = value;
     return AccessResult::Success;
 }
 
@@ -155,13 +196,12 @@ Variables::AccessResult Variables::setArray2Value(const std::string& name, int i
 
     auto& array2 = it->second;
     auto index = array2.index(index1, index2);
-    if (!validIndex(index, array2.arr))
+    if (!validIndex(index, arraySize(array2.arr)))
         return AccessResult::ArrayIndexOutOfBounds;
 
-    if (getValueType(array2.arr[index]) != getValueType(value))
+    if (!storeArrayValue(array2.arr, index, value))
         return AccessResult::TypeMismatch;
 
-    array2.arr[index] = value;
     return AccessResult::Success;
 }
 
@@ -176,13 +216,12 @@ Variables::AccessResult Variables::setArray3Value(const std::string& name, int i
 
     auto& array3 = it->second;
     auto index = array3.index(index1, index2, index3);
-    if (!validIndex(index, array3.arr))
+    if (!validIndex(index, arraySize(array3.arr)))
         return AccessResult::ArrayIndexOutOfBounds;
 
-    if (getValueType(array3.arr[index]) != getValueType(value))
+    if (!storeArrayValue(array3.arr, index, value))
         return AccessResult::TypeMismatch;
 
-    array3.arr[index] = value;
     return AccessResult::Success;
 }
 
@@ -205,10 +244,10 @@ std::pair<Value, Variables::AccessResult> Variables::getArray1Value(const std::s
     if (it == valueArrays1.end())
         return {Value{}, AccessResult::DoNotExists};
 
-    if (!validIndex(index, it->second))
+    if (!validIndex(index, arraySize(it->second)))
         return {Value{}, AccessResult::ArrayIndexOutOfBounds};
 
-    return {it->second[index], AccessResult::Success};
+    return {loadArrayValue(it->second, index), AccessResult::Success};
 }
 
 std::pair<Value, Variables::AccessResult> Variables::getArray2Value(const std::string& name, int index1, int index2) const noexcept
@@ -226,10 +265,10 @@ std::pair<Value, Variables::AccessResult> Variables::getArray2Value(const std::s
 
     auto& array2 = it->second;
     auto index = array2.index(index1, index2);
-    if (!validIndex(index, array2.arr))
+    if (!validIndex(index, arraySize(array2.arr)))
         return {Value{}, AccessResult::ArrayIndexOutOfBounds};
 
-    return {array2.arr[index], AccessResult::Success};
+    return {loadArrayValue(array2.arr, index), AccessResult::Success};
 }
 
 std::pair<Value, Variables::AccessResult> Variables::getArray3Value(const std::string& name, int index1, int index2, int index3) const noexcept
@@ -247,10 +286,10 @@ std::pair<Value, Variables::AccessResult> Variables::getArray3Value(const std::s
 
     auto& array3 = it->second;
     auto index = array3.index(index1, index2, index3);
-    if (!validIndex(index, array3.arr))
+    if (!validIndex(index, arraySize(array3.arr)))
         return {Value{}, AccessResult::ArrayIndexOutOfBounds};
 
-    return {array3.arr[index], AccessResult::Success};
+    return {loadArrayValue(array3.arr, index), AccessResult::Success};
 }
 
 void Variables::clear() noexcept
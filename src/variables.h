@@ -5,6 +5,7 @@
 
 #include <unordered_map>
 #include <vector>
+#include <variant>
 #include <utility>
 
 class Variables
@@ -95,9 +96,21 @@ private:
     bool isArray2(const std::string& name) const;
     bool isArray3(const std::string& name) const;
 
+    // keep in sync with Value i.e. std::variant::index()
+    typedef std::variant<std::vector<s840d_int_t>,
+                         std::vector<s840d_real_t>,
+                         std::vector<s840d_bool_t>,
+                         std::vector<s840d_char_t>,
+                         std::vector<s840d_string_t>> ArrayStorage;
+
+    static ArrayStorage createArrayStorage(ValueType type, std::size_t size);
+    static std::size_t arraySize(const ArrayStorage& storage) noexcept;
+    static Value loadArrayValue(const ArrayStorage& storage, std::size_t index);
+    static bool storeArrayValue(ArrayStorage& storage, std::size_t index, const Value& value);
+
     struct Array2
     {
-        std::vector<Value> arr;
+        ArrayStorage arr;
         std::size_t w;
 
         constexpr size_t index(int index1, int index2) const
@@ -108,7 +121,7 @@ private:
 
     struct Array3
     {
-        std::vector<Value> arr;
+        ArrayStorage arr;
         std::size_t w1;
         std::size_t w2;
 
@@ -119,7 +132,7 @@ private:
     };
 
     std::unordered_map<std::string, Value> values;
-    std::unordered_map<std::string, std::vector<Value>> valueArrays1;
+    std::unordered_map<std::string, ArrayStorage> valueArrays1;
     std::unordered_map<std::string, Array2> valueArrays2;
     std::unordered_map<std::string, Array3> valueArrays3;
 };
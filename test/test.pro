@@ -14,7 +14,21 @@ SOURCES += \
     ../src/value.cpp \
     ../src/variables.cpp \
     ../src/ncprogramblock.cpp \
-    ../src/geometry.cpp
+    ../src/geometry.cpp \
+    ../src/motionlist.cpp \
+    ../src/motionlog.cpp \
+    ../src/evaluationcache.cpp \
+    ../src/boundingbox.cpp \
+    ../src/batchverifier.cpp \
+    ../src/segmentindex.cpp \
+    ../src/pathtimeline.cpp \
+    ../src/cycletimeestimator.cpp \
+    ../src/stocksimulator.cpp \
+    ../src/orthographiccamera.cpp \
+    ../src/pathrasterizer.cpp \
+    ../src/programindex.cpp \
+    ../src/crossreferenceindex.cpp \
+    ../src/programtransform.cpp
 
 
 INCLUDEPATH += ../3rd-party/lexertl14/include \
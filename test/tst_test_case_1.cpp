@@ -1,10 +1,29 @@
 #include <QtTest>
 
+#include "batchverifier.h"
 #include "geometry.h"
 #include "controller.h"
+#include "crossreferenceindex.h"
+#include "cycletimeestimator.h"
+#include "evaluationcache.h"
+#include "motionlist.h"
+#include "motionlog.h"
+#include "parser.h"
+#include "pathrasterizer.h"
+#include "pathtimeline.h"
+#include "programindex.h"
+#include "programtransform.h"
+#include "segmentindex.h"
+#include "stocksimulator.h"
+#include "s840d_alarm.h"
 
 #include <glm/gtc/epsilon.hpp>
 
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <thread>
+
 struct TestMotionHandler : public ControllerListener
 {
     glm::dvec3 m_point;
@@ -35,6 +54,36 @@ struct TestMotionHandler : public ControllerListener
     void endOfProgram() override {}
 };
 
+struct TestMotionRecorder : public ControllerListener
+{
+    std::vector<std::tuple<size_t, glm::dvec3, double>> m_events;
+    size_t m_blockNumber {};
+
+    void startPoint(const glm::dvec3& point) override
+    {
+        m_events.emplace_back(0, point, 0.0);
+    }
+    void blockChange(size_t blockNumber) override
+    {
+        m_blockNumber = blockNumber;
+    }
+    void linearMotion(const LinearMotion& linearMotion) override
+    {
+        m_events.emplace_back(m_blockNumber, linearMotion.getEndPoint(), linearMotion.getFeed());
+    }
+    void circularMotion(const CircularMotion& circularMotion) override
+    {
+        DirectedArc3Sampler s {circularMotion.getArc()};
+        m_events.emplace_back(m_blockNumber, s.sample(1.0), circularMotion.getFeed());
+    }
+    void helicalMotion(const HelicalMotion& helicalMotion) override
+    {
+        HelixSampler s {helicalMotion.getHelix()};
+        m_events.emplace_back(m_blockNumber, s.sample(1.0), helicalMotion.getFeed());
+    }
+    void endOfProgram() override {}
+};
+
 class test_case_1 : public QObject
 {
     Q_OBJECT
@@ -54,6 +103,31 @@ private slots:
     void arc3_create_3_points();
 
     void helix_sampling();
+    void batch_sampling();
+
+    void variables_typed_arrays();
+
+    void parser_plain_words();
+    void parser_shared_content();
+    void parser_tokenize();
+    void controller_goto();
+    void controller_parallel_evaluation();
+    void controller_profiling();
+    void controller_budget();
+    void controller_tool_change();
+
+    void motion_list();
+    void motion_log();
+    void evaluation_cache();
+    void batch_verifier();
+    void segment_index();
+    void path_timeline();
+    void cycle_time_estimator();
+    void stock_simulator();
+    void path_rasterizer();
+    void program_index();
+    void cross_reference_index();
+    void program_transform();
 };
 
 test_case_1::test_case_1()
@@ -214,6 +288,941 @@ void test_case_1::helix_sampling()
     }
 }
 
+void test_case_1::batch_sampling()
+{
+    const double eps {1e-9};
+    {
+        auto arc = DirectedArc3::create3Points({5,10, 0}, {0,0,20}, {25, 1, 0}, 0);
+        DirectedArc3Sampler s(*arc);
+        std::vector<glm::dvec3> points(99);
+        s.sampleN(points.size(), points.data());
+        for (size_t k {1}; k <= points.size(); k++)
+            QVERIFY(glm::all(glm::epsilonEqual(points[k - 1], s.sample(k / 99.0), eps)));
+    }
+    {
+        auto arc = DirectedArc2::create2PointsRadius({5,5}, {10,10}, 5, DirectedArc2::clw, 0);
+        Helix helix {arc.value(), glm::rotate(glm::dmat4(1.0), 1.0, glm::dvec3(1, 2, 3)), -2.0, 5.0, 2};
+        HelixSampler s {helix};
+        std::vector<glm::dvec3> points(299);
+        s.sampleN(points.size(), points.data());
+        for (size_t k {1}; k <= points.size(); k++)
+            QVERIFY(glm::all(glm::epsilonEqual(points[k - 1], s.sample(k / 299.0), eps)));
+    }
+}
+
+void test_case_1::variables_typed_arrays()
+{
+    Variables v;
+    QVERIFY(v.defineArray("A", ValueType::REAL, {100, 100, 3}) == Variables::DefineResult::Success);
+    QVERIFY(v.defineArray("B", ValueType::BOOL, {4}) == Variables::DefineResult::Success);
+    QVERIFY(v.defineArray("S", ValueType::STRING, {2, 2}) == Variables::DefineResult::Success);
+
+    QVERIFY(v.getArray3Value("A", 99, 99, 2).first == Value{0.0});
+    QVERIFY(v.setArray3Value("A", 1, 2, 1, Value{2.5}) == Variables::AccessResult::Success);
+    QVERIFY(v.getArray3Value("a", 1, 2, 1).first == Value{2.5});
+    QVERIFY(v.setArray3Value("A", 1, 2, 1, Value{2}) == Variables::AccessResult::TypeMismatch);
+    QVERIFY(v.setArray3Value("A", 100, 0, 0, Value{1.0}) == Variables::AccessResult::ArrayIndexOutOfBounds);
+
+    QVERIFY(v.setArray1Value("B", 3, Value{true}) == Variables::AccessResult::Success);
+    QVERIFY(v.getArray1Value("B", 3).first == Value{true});
+    QVERIFY(v.getArray1Value("B", 2).first == Value{false});
+
+    QVERIFY(v.setArray2Value("S", 1, 1, Value{std::string{"abc"}}) == Variables::AccessResult::Success);
+    QVERIFY(v.getArray2Value("S", 1, 1).first == Value{std::string{"abc"}});
+}
+
+void test_case_1::parser_plain_words()
+{
+    Parser p;
+    QCOMPARE(p.parse("N10 G1 X10 Y-5.5 Z+.5 F1000").blockContent.size(), size_t{5});
+    QCOMPARE(p.parse("X1EX2 Y=2*3").blockContent.size(), size_t{2});
+    QCOMPARE(p.parse("G1 X10 R1=5").blockContent.size(), size_t{3});
+    QCOMPARE(p.parse("  ").blockContent.size(), size_t{0});
+    QVERIFY_EXCEPTION_THROWN(p.parse("G99999999999"), S840D_Alarm);
+
+    TestMotionHandler h;
+    Controller c;
+    c.setListener(&h);
+    c.addLine(std::string("G1 X10 Y-5.5 Z+.5 F1000"));
+    c.addLine(std::string("X 2 Y - 1.5"));
+    c.run();
+    QVERIFY(h.m_point == glm::dvec3(2, -1.5, 0.5));
+    QVERIFY(h.m_feed == 1000);
+}
+
+void test_case_1::parser_shared_content()
+{
+    Parser p;
+    auto b1 {p.parse("N10 G0 Z51.5")};
+    auto b2 {p.parse("N20 G0 Z51.5 ")};
+    QCOMPARE(b1.blockContent.size(), size_t{2});
+    QVERIFY(b1.blockContent.begin() == b2.blockContent.begin());
+
+    // control structures depend on the nesting level and are not shared
+    auto if1 {p.parse("IF R1==1")};
+    auto if2 {p.parse("IF R1==1")};
+    QCOMPARE(if1.nestingLevel, 1);
+    QCOMPARE(if2.nestingLevel, 2);
+    QVERIFY(if1.blockContent.begin() != if2.blockContent.begin());
+    QVERIFY_EXCEPTION_THROWN(p.parse("/1 IF R1==1"), S840D_Alarm);
+}
+
+void test_case_1::parser_tokenize()
+{
+    using C = Parser::TokenCategory;
+    Parser parser;
+    std::vector<Parser::LexicalToken> tokens;
+
+    const std::string text {"N10 G01 X-5.5 F100 R1=SIN(30) AB=\"x\" IF TRANS ?"};
+    parser.tokenize(text.data(), text.data() + text.size(), tokens);
+    const std::vector<C> expected {C::BlockNumber, C::Number, C::GFunction, C::Number, C::AddressLetter, C::Other,
+                                   C::Number, C::AddressLetter, C::Number, C::Identifier, C::Number, C::Other,
+                                   C::Function, C::Other, C::Number, C::Other, C::Identifier, C::Other, C::String,
+                                   C::Keyword, C::GFunction, C::Unknown};
+    QCOMPARE(tokens.size(), expected.size());
+    for (size_t i {0}; i < tokens.size(); i++)
+        QCOMPARE(tokens[i].category, expected[i]);
+    QCOMPARE(text.substr(tokens[2].position, tokens[2].length), std::string("G"));
+    QCOMPARE(text.substr(tokens[6].position, tokens[6].length), std::string("5.5"));
+    QCOMPARE(text.substr(tokens[18].position, tokens[18].length), std::string("\"x\""));
+}
+
+void test_case_1::controller_goto()
+{
+    TestMotionHandler h;
+    Controller c;
+    c.setListener(&h);
+    c.addLine(std::string("N10 G0 X1"));
+    c.addLine(std::string("GOTOF N0020"));
+    c.addLine(std::string("N20 X5"));
+    c.addLine(std::string("N0020 X7"));
+    c.addLine(std::string("GOTOF LAB1"));
+    c.addLine(std::string("N30 X8"));
+    c.addLine(std::string("LAB1: Y2"));
+    c.run();
+    QVERIFY(h.m_point == glm::dvec3(7, 2, 0));
+}
+
+void test_case_1::controller_parallel_evaluation()
+{
+    const std::vector<std::string> moves {
+        "G91 G1 X1.5 Y-0.25",
+        "G91 G2 X2 Y0 CR=5",
+        "G91 G3 X2 Y2 I2 J0",
+        "G91 G2 X2 Y0 Z-1 CR=5",
+        "G91 G3 X2 Y2 I2 J0 TURN=1",
+        "G90 G0 Z5",
+        "G1 X-3 F150",
+    };
+    auto evaluate = [&](bool parallel, const std::string& insertedBlock)
+    {
+        TestMotionRecorder recorder;
+        Controller c;
+        c.setListener(&recorder);
+        c.setParallelEvaluation(parallel, 8);
+        c.addLine(std::string("G17 G90 G0 X0 Y0 F200"));
+        for (int i {0}; i < 300; i++)
+        {
+            c.addLine(i == 150 ? insertedBlock : moves[i % moves.size()]);
+            c.addLine(std::string("Y") + std::to_string(i % 13));
+        }
+        c.addLine(std::string("M30"));
+        c.run();
+        return recorder.m_events;
+    };
+
+    // a variable assignment splits the straight-line regions
+    auto sequential {evaluate(false, "R1=2 X=R1")};
+    QCOMPARE(sequential.size(), size_t{429});
+    QVERIFY(evaluate(true, "R1=2 X=R1") == sequential);
+
+    // an alarm stops the evaluation at the same block
+    for (const std::string alarmBlock : {"X1 X2", "G91 G2 X20 Y0 CR=1"})
+    {
+        sequential = evaluate(false, alarmBlock);
+        QCOMPARE(std::get<0>(sequential.back()), size_t{299});
+        QVERIFY(evaluate(true, alarmBlock) == sequential);
+    }
+}
+
+void test_case_1::controller_profiling()
+{
+    Controller c;
+    auto addLoop = [&c]()
+    {
+        c.reset();
+        c.addLine(std::string("DEF INT COUNTER=0"));
+        c.addLine(std::string("LOOP1: COUNTER=COUNTER+1"));
+        c.addLine(std::string("IF COUNTER<3 GOTOB LOOP1"));
+        c.addLine(std::string("G0 X1"));
+    };
+    addLoop();
+    c.run();
+    QVERIFY(c.profile().empty());
+
+    addLoop();
+    c.setProfiling(true);
+    c.run();
+    std::vector<uint64_t> counts;
+    for (const auto& block : c.profile())
+        counts.push_back(block.count);
+    QVERIFY(counts == (std::vector<uint64_t>{1, 3, 3, 1}));
+
+    // the blocks of a parallel evaluated region are counted once
+    c.reset();
+    c.setParallelEvaluation(true, 2);
+    c.addLine(std::string("G17 G90 G1 F100"));
+    for (int i {0}; i < 20; i++)
+        c.addLine(std::string("X") + std::to_string(i));
+    c.run();
+    QCOMPARE(c.profile().size(), size_t{21});
+    QVERIFY(std::all_of(c.profile().begin(), c.profile().end(),
+                        [](const Controller::BlockProfile& block) { return block.count == 1; }));
+}
+
+void test_case_1::controller_budget()
+{
+    struct StopRecorder : TestMotionRecorder
+    {
+        size_t m_pauses {0};
+        size_t m_ends {0};
+
+        void endOfProgram() override { m_ends++; }
+        void evaluationPaused() override { m_pauses++; }
+    };
+    auto evaluate = [](const Controller::Budget& budget, std::vector<Controller::StopReason>& stops)
+    {
+        StopRecorder recorder;
+        Controller c;
+        c.setListener(&recorder);
+        c.setBudget(budget);
+        c.addLine(std::string("G17 G90 G0 X0 Y0"));
+        c.addLine(std::string("R1=0"));
+        c.addLine(std::string("LOOP1: R1=R1+1 G1 X=R1 F100"));
+        c.addLine(std::string("IF R1<10 GOTOB LOOP1"));
+        c.addLine(std::string("G0 Z5"));
+        c.addLine(std::string("M30"));
+        c.run();
+        stops.push_back(c.stopReason());
+        while (c.canResume())
+        {
+            c.resume();
+            stops.push_back(c.stopReason());
+        }
+        // the listener is told about every stop, but the program ends once
+        if (recorder.m_pauses != stops.size() - 1 || recorder.m_ends != 1)
+            return decltype(recorder.m_events){};
+        return recorder.m_events;
+    };
+
+    std::vector<Controller::StopReason> stops;
+    const auto unlimited {evaluate({}, stops)};
+    QCOMPARE(unlimited.size(), size_t{13});
+    QVERIFY(stops == std::vector<Controller::StopReason>{Controller::StopReason::EndOfProgram});
+
+    // 24 blocks are evaluated in 5 runs, the motions continue where they stopped
+    stops.clear();
+    QVERIFY(evaluate({std::chrono::milliseconds{0}, 5}, stops) == unlimited);
+    QCOMPARE(stops.size(), size_t{5});
+    QVERIFY(std::all_of(stops.begin(), stops.end() - 1,
+                        [](Controller::StopReason reason) { return reason == Controller::StopReason::Budget; }));
+    QVERIFY(stops.back() == Controller::StopReason::EndOfProgram);
+
+    // the look-ahead of the cycle time continues over the stops
+    auto cycleTime = [](const Controller::Budget& budget)
+    {
+        CycleTimeEstimator estimator;
+        Controller c;
+        c.setListener(&estimator);
+        c.setBudget(budget);
+        c.addLine(std::string("G17 G90 G1 X0 Y0 F1000"));
+        for (int i {1}; i <= 20; i++)
+            c.addLine("X" + std::to_string(i * 10) + " Y" + std::to_string(i % 2 * 5));
+        c.addLine(std::string("M30"));
+        c.run();
+        while (c.canResume())
+            c.resume();
+        return estimator.totalTime();
+    };
+    QVERIFY(std::abs(cycleTime({std::chrono::milliseconds{0}, 3}) - cycleTime({})) < 1e-9);
+
+    TestMotionRecorder recorder;
+    Controller c;
+    c.setListener(&recorder);
+    c.setBudget({std::chrono::milliseconds{0}, 3});
+    c.addLine(std::string("G0 X1"));
+    c.addLine(std::string("G0 X1 X2"));
+    c.addLine(std::string("G0 X3"));
+    c.run();
+    QVERIFY(c.stopReason() == Controller::StopReason::Alarm);
+    QCOMPARE(c.stopBlock(), size_t{1});
+    QVERIFY(!c.canResume());
+
+    // the jumps of an endless loop add up over the slices
+    Controller loop;
+    loop.setBudget({std::chrono::milliseconds{0}, 100000});
+    loop.addLine(std::string("LOOP1:"));
+    loop.addLine(std::string("GOTOB LOOP1"));
+    loop.run();
+    int slices {1};
+    for (; loop.stopReason() == Controller::StopReason::Budget && slices < 100; slices++)
+        loop.resume();
+    QVERIFY(loop.stopReason() == Controller::StopReason::JumpLimit);
+    QVERIFY(slices > 1);
+}
+
+void test_case_1::controller_tool_change()
+{
+    // a tool selected by name is reported as tool 0, the program goes on
+    struct ToolRecorder : TestMotionRecorder
+    {
+        std::vector<std::pair<int, int>> m_tools;
+        void toolChange(int tool, int edge) override { m_tools.emplace_back(tool, edge); }
+    };
+    ToolRecorder recorder;
+    Controller named;
+    named.setListener(&recorder);
+    named.addLine(std::string("T1 D1"));
+    named.addLine(std::string("T=\"DRILL\" D2"));
+    named.addLine(std::string("G0 X5"));
+    named.addLine(std::string("T2"));
+    named.run();
+    QVERIFY(recorder.m_tools == (std::vector<std::pair<int, int>>{{1, 1}, {0, 2}, {2, 2}}));
+    QCOMPARE(recorder.m_events.size(), size_t{2});
+
+    // the simulator cuts with its default tool then, not the one before
+    StockSimulator fallback;
+    fallback.setTool(1, {StockSimulator::Tool::FlatEnd, 10.0});
+    fallback.setDefaultTool({StockSimulator::Tool::FlatEnd, 1.0});
+    Controller drilled;
+    drilled.setListener(&fallback);
+    drilled.addLine(std::string("T1 D1"));
+    drilled.addLine(std::string("G0 X0 Y0 Z5"));
+    drilled.addLine(std::string("T=\"DRILL\""));
+    drilled.addLine(std::string("G1 Z-1 F100"));
+    drilled.addLine(std::string("X40"));
+    drilled.addLine(std::string("Y10"));
+    drilled.run();
+    QCOMPARE(fallback.stateAt({20.0, 0.0}), StockSimulator::Cut);
+    QCOMPARE(fallback.stateAt({20.0, 3.0}), StockSimulator::Uncut);
+}
+
+void test_case_1::motion_list()
+{
+    MotionList motions;
+    Controller c;
+    c.setListener(&motions);
+    c.addLine(std::string("G0 X10"));
+    c.addLine(std::string("G17 G2 X20 I5 F100"));
+    c.addLine(std::string("M30"));
+    c.run();
+    QCOMPARE(motions.items().size(), size_t{2});
+    QVERIFY(std::holds_alternative<LinearMotion>(motions.motion(0)));
+    QCOMPARE(motions.items()[0].blockNumber, uint32_t{0});
+    QVERIFY(std::holds_alternative<CircularMotion>(motions.motion(1)));
+    QCOMPARE(motions.items()[1].blockNumber, uint32_t{1});
+    QCOMPARE(motions.arcs().size(), size_t{1});
+    std::vector<glm::dvec3> points(motions.pointCount(1));
+    motions.samplePoints(1, points.data());
+    QVERIFY(glm::distance(points.back(), motions.items()[1].endPoint) < 1e-9);
+    QVERIFY(glm::distance(motions.items()[1].endPoint, glm::dvec3 {20.0, 0.0, 0.0}) < 1e-9);
+
+    c.run();
+    QCOMPARE(motions.items().size(), size_t{2});
+
+    // the backplot of a tab is restored from the compact list, its motions are replayed as reported
+    c.reset();
+    c.addLine(std::string("G0 X10 Y-2"));
+    c.addLine(std::string("G17 G2 X20 I5 F100"));
+    c.addLine(std::string("G3 X30 Y-2 Z-3 I5 TURN=2"));
+    c.addLine(std::string("M30"));
+    TestMotionRecorder direct;
+    c.setListener(&direct);
+    c.run();
+    c.setListener(&motions);
+    c.run();
+    motions.shrinkToFit();
+    QCOMPARE(motions.arcs().size(), size_t{2});
+    TestMotionRecorder replayed;
+    replayed.startPoint(motions.firstPoint());
+    for (size_t i {0}; i < motions.items().size(); i++)
+    {
+        replayed.blockChange(motions.items()[i].blockNumber);
+        motions.replay(i, replayed);
+    }
+    QCOMPARE(replayed.m_events.size(), direct.m_events.size());
+    for (size_t i {0}; i < direct.m_events.size(); i++)
+    {
+        QCOMPARE(std::get<0>(replayed.m_events[i]), std::get<0>(direct.m_events[i]));
+        QVERIFY(glm::distance(std::get<1>(replayed.m_events[i]), std::get<1>(direct.m_events[i])) < 1e-9);
+        QCOMPARE(std::get<2>(replayed.m_events[i]), std::get<2>(direct.m_events[i]));
+    }
+    QCOMPARE(motions.pointCount(2), size_t{299});
+}
+
+void test_case_1::motion_log()
+{
+    auto evaluate = [](ControllerListener& listener)
+    {
+        Controller c;
+        c.setListener(&listener);
+        c.addLine(std::string("G0 X10 Y-2"));
+        c.addLine(std::string("G17 G2 X20 I5 F100"));
+        c.addLine(std::string("G3 X30 Y-2 Z-3 I5 TURN=2"));
+        c.addLine(std::string("M30"));
+        c.run();
+    };
+
+    MotionLogWriter writer;
+    evaluate(writer);
+    std::stringstream stream;
+    QVERIFY(writer.write(stream));
+
+    MotionLogReader reader;
+    QVERIFY(reader.read(stream));
+    QCOMPARE(reader.motionCount(), size_t{3});
+    QCOMPARE(reader.arcCount(), size_t{2});
+    QCOMPARE(reader.traceCount(), size_t{4});
+    QCOMPARE(reader.block(1), uint32_t{1});
+    QCOMPARE(reader.type(0), MotionLog::Linear);
+    QCOMPARE(reader.type(2), MotionLog::Helical);
+    QCOMPARE(reader.feed(2), 100.0);
+    QVERIFY(reader.endPoint(0) == glm::dvec3(10, -2, 0));
+    QVERIFY(glm::all(glm::epsilonEqual(reader.endPoint(2), glm::dvec3(30, -2, -3), 1e-12)));
+
+    TestMotionRecorder evaluated;
+    evaluate(evaluated);
+    TestMotionRecorder replayed;
+    reader.replay(replayed);
+    QVERIFY(replayed.m_events == evaluated.m_events);
+
+    // truncated data is rejected
+    QVERIFY(!reader.read(stream.str().substr(0, stream.str().size() - 8)));
+    QCOMPARE(reader.motionCount(), size_t{0});
+}
+
+void test_case_1::evaluation_cache()
+{
+    const auto directory {std::filesystem::temp_directory_path() / "tst_evaluation_cache"};
+    std::filesystem::remove_all(directory);
+
+    auto evaluate = [](ControllerListener& listener)
+    {
+        Controller c;
+        c.setListener(&listener);
+        c.addLine(std::string("G0 X10"));
+        c.addLine(std::string("G17 G2 X20 I5 F100"));
+        c.addLine(std::string("G3 X30 I5 TURN=2"));
+        c.addLine(std::string("M30"));
+        c.run();
+    };
+
+    MotionLogWriter recorder;
+    evaluate(recorder);
+    TestMotionRecorder evaluated;
+    evaluate(evaluated);
+
+    std::ostringstream stream;
+    recorder.write(stream);
+    EvaluationCache cache {directory, stream.str().size()};
+    TestMotionRecorder loaded;
+    QVERIFY(!cache.load("a", loaded));
+    QVERIFY(loaded.m_events.empty());
+    QVERIFY(!cache.contains("a"));
+    QVERIFY(cache.store("a", recorder));
+    QVERIFY(cache.contains("a"));
+    QVERIFY(cache.load("a", loaded));
+    QVERIFY(loaded.m_events == evaluated.m_events);
+
+    // the size limit evicts the least recently used entry
+    QVERIFY(cache.store("b", recorder));
+    QVERIFY(!cache.contains("a"));
+    QVERIFY(!cache.load("a", loaded));
+    QVERIFY(cache.load("b", loaded));
+
+    // the same program stored by several threads at once
+    std::vector<std::thread> threads;
+    std::atomic<int> stored {0};
+    for (int i {0}; i < 4; i++)
+        threads.emplace_back([&]() { stored += cache.store("c", recorder); });
+    for (auto& thread : threads)
+        thread.join();
+    QCOMPARE(stored.load(), 4);
+    TestMotionRecorder concurrent;
+    QVERIFY(cache.load("c", concurrent));
+    QVERIFY(concurrent.m_events == evaluated.m_events);
+
+    std::filesystem::remove_all(directory);
+}
+
+void test_case_1::batch_verifier()
+{
+    const auto directory {std::filesystem::temp_directory_path() / "tst_batch_verifier"};
+    std::filesystem::remove_all(directory);
+    std::filesystem::create_directories(directory / "sub");
+
+    auto write = [](const std::filesystem::path& path, const char* text)
+    {
+        std::ofstream file {path};
+        file << text;
+    };
+    write(directory / "a.mpf", "D1 G0 X10 Y10\nG1 X20 F100\nG2 X30 I5\nM30\n");
+    write(directory / "sub" / "b.SPF", "G0 X10\nX1 X2\nG1 X-5 F100\nM30\n");
+    write(directory / "notes.txt", "G0 X10\n");
+
+    const auto paths {BatchVerifier::findPrograms(directory.string())};
+    QCOMPARE(paths.size(), size_t(2));
+
+    const auto results {BatchVerifier {2}.verify(paths)};
+    QCOMPARE(results.size(), size_t(2));
+    QVERIFY(results[0].verified && results[0].readable && results[0].alarms.empty());
+    QCOMPARE(results[0].blockCount, size_t(4));
+    // D without T selects no tool
+    QVERIFY(results[0].tools.empty());
+    QCOMPARE(results[0].motionCount, size_t(3));
+    QVERIFY(glm::all(glm::epsilonEqual(results[0].boundingBox.upperCorner(), glm::vec3(30, 15, 0), 1e-4f)));
+    QVERIFY(results[1].readable);
+    QCOMPARE(results[1].alarms.size(), size_t(1));
+    QCOMPARE(results[1].alarms[0].first, size_t(1));
+
+    std::ostringstream report;
+    BatchVerifier::writeReport(report, results);
+    QVERIFY(report.str().find("# 2 files, 1 failed") != std::string::npos);
+
+    // an endless loop stops at the jump limit without an alarm, it fails all the same
+    write(directory / "loop.txt", "LOOP1:\nGOTOB LOOP1\nM30\n");
+    const auto loop {BatchVerifier {1}.verify({(directory / "loop.txt").string()})};
+    QVERIFY(loop[0].readable && loop[0].alarms.empty() && loop[0].jumpLimit && loop[0].failed());
+    std::ostringstream loopReport;
+    BatchVerifier::writeReport(loopReport, loop);
+    QVERIFY(loopReport.str().find("\tjump limit\t") != std::string::npos);
+    QVERIFY(loopReport.str().find("# 1 files, 1 failed") != std::string::npos);
+
+    // cancellable, evaluated in slices, the jump limit holds across them
+    std::atomic<bool> cancelled {false};
+    const auto sliced {BatchVerifier {1}.verify({(directory / "loop.txt").string()}, {}, &cancelled)};
+    QVERIFY(sliced[0].verified && sliced[0].jumpLimit);
+    std::thread canceller {[&cancelled]()
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        cancelled = true;
+    }};
+    const std::vector<std::string> loops(3, (directory / "loop.txt").string());
+    const auto cancelledLoops {BatchVerifier {1}.verify(loops, {}, &cancelled)};
+    canceller.join();
+    QVERIFY(!cancelledLoops.back().verified);
+    QVERIFY(std::none_of(cancelledLoops.begin(), cancelledLoops.end(), [](const BatchVerifier::Result& result) {
+        return result.verified && !result.jumpLimit;
+    }));
+
+    // stopped after the first file
+    const auto stopped {BatchVerifier {1}.verify(paths, []() { return false; })};
+    QCOMPARE(std::count_if(stopped.begin(), stopped.end(), [](const BatchVerifier::Result& result) {
+        return result.verified;
+    }), std::ptrdiff_t(1));
+
+    std::filesystem::remove_all(directory);
+}
+
+void test_case_1::segment_index()
+{
+    std::mt19937 random {7};
+    std::uniform_real_distribution<float> step {-1.0f, 1.0f};
+    std::vector<glm::vec3> points {glm::vec3(0.0f)};
+    for (int i {0}; i < 5000; i++)
+        points.push_back(points.back() + glm::vec3(step(random), step(random), step(random) * 0.1f));
+
+    SegmentIndex index;
+    index.build(points);
+    QCOMPARE(index.segmentCount(), points.size() - 1);
+
+    auto segmentDistance = [&points](size_t segment, const glm::vec3& p)
+    {
+        const glm::vec3 e {points[segment + 1] - points[segment]};
+        const float t {glm::clamp(glm::dot(p - points[segment], e) / glm::dot(e, e), 0.0f, 1.0f)};
+        return glm::length(p - (points[segment] + t * e));
+    };
+
+    for (int query {0}; query < 50; query++)
+    {
+        const glm::vec3 p {step(random) * 30.0f, step(random) * 30.0f, step(random) * 3.0f};
+        float bruteForce {std::numeric_limits<float>::max()};
+        for (size_t i {0}; i + 1 < points.size(); i++)
+            bruteForce = std::min(bruteForce, segmentDistance(i, p));
+
+        const auto hit {index.nearest(p, 1000.0f)};
+        QVERIFY(hit.has_value());
+        QVERIFY(std::abs(hit->distance - bruteForce) < 1e-4f);
+
+        // looking down the z axis, distances are measured in the xy plane
+        const auto picked {index.pick(glm::vec3(p.x, p.y, 100.0f), glm::vec3(0.0f, 0.0f, -1.0f), 0.5f)};
+        float bruteForceXY {std::numeric_limits<float>::max()};
+        for (size_t i {0}; i + 1 < points.size(); i++)
+        {
+            const glm::vec3 a {points[i].x, points[i].y, 0.0f};
+            const glm::vec3 e {points[i + 1].x - a.x, points[i + 1].y - a.y, 0.0f};
+            const glm::vec3 q {p.x, p.y, 0.0f};
+            const float t {glm::clamp(glm::dot(q - a, e) / glm::dot(e, e), 0.0f, 1.0f)};
+            bruteForceXY = std::min(bruteForceXY, glm::length(q - (a + t * e)));
+        }
+        QCOMPARE(picked.has_value(), bruteForceXY <= 0.5f);
+        if (picked)
+            QVERIFY(std::abs(picked->distance - bruteForceXY) < 1e-3f);
+    }
+
+    QVERIFY(!index.nearest(glm::vec3(1000.0f), 1.0f).has_value());
+}
+
+void test_case_1::path_timeline()
+{
+    const std::vector<glm::vec3> points {{0, 0, 0}, {10, 0, 0}, {10, 10, 0}, {10, 10, 0}, {20, 10, 0}};
+    PathTimeline timeline;
+    // 10 mm at 600 mm/min, 10 mm rapid, 10 mm at 1200 mm/min
+    timeline.build(points, {0, 1, 3}, {600.0, 0.0, 1200.0});
+    QCOMPARE(timeline.segmentCount(), size_t(4));
+    QVERIFY(std::abs(timeline.length() - 30.0) < 1e-9);
+    const double rapid {10.0 / PathTimeline::rapidFeed * 60.0};
+    QVERIFY(std::abs(timeline.duration() - (1.5 + rapid)) < 1e-9);
+
+    auto check = [](PathTimeline::Location location, size_t segment, double parameter)
+    {
+        return location.segment == segment && std::abs(location.parameter - parameter) < 1e-9;
+    };
+    QVERIFY(check(timeline.atTime(-1.0), 0, 0.0));
+    QVERIFY(check(timeline.atTime(0.5), 0, 0.5));
+    QVERIFY(check(timeline.atTime(1.0 + rapid / 2), 1, 0.5));
+    QVERIFY(check(timeline.atTime(1.25 + rapid), 3, 0.5));
+    QVERIFY(check(timeline.atTime(100.0), 3, 1.0));
+    QVERIFY(check(timeline.atLength(15.0), 1, 0.5));
+    QVERIFY(check(timeline.atLength(20.0), 3, 0.0));
+}
+
+void test_case_1::cycle_time_estimator()
+{
+    auto estimate = [](const std::vector<std::string>& lines, size_t lookAhead = 64)
+    {
+        CycleTimeEstimator::MachineLimits limits;
+        limits.maxAcceleration = glm::dvec3(1000.0);
+        limits.maxJerk = glm::dvec3(1e9);
+        limits.lookAhead = lookAhead;
+        auto estimator {std::make_unique<CycleTimeEstimator>(limits)};
+        Controller c;
+        c.setListener(estimator.get());
+        for (const auto& line : lines)
+            c.addLine(line);
+        c.run();
+        return estimator;
+    };
+
+    // 100 mm/s, 0.1 s and 5 mm to accelerate and to decelerate
+    QVERIFY(std::abs(estimate({"G1 X100 F6000"})->totalTime() - 1.1) < 1e-3);
+    QVERIFY(std::abs(estimate({"G1 X50 F6000", "X100"})->totalTime() - 1.1) < 1e-3);
+
+    const auto corner {estimate({"G1 X50 F6000", "Y50"})};
+    // the corner is passed at sqrt(1000 * 0.02 * sin(45) / (1 - sin(45))), about 6.95 mm/s
+    QVERIFY(std::abs(corner->totalTime() - 1.1866) < 1e-3);
+    QCOMPARE(corner->blockTimes().size(), size_t(2));
+    QVERIFY(std::abs(corner->blockTimes()[0] + corner->blockTimes()[1] - corner->totalTime()) < 1e-9);
+
+    // a short look-ahead can't reach the feed on short segments
+    std::vector<std::string> lines {"G1 F6000"};
+    for (int i {1}; i <= 100; i++)
+        lines.push_back("X" + std::to_string(i));
+    QVERIFY(std::abs(estimate(lines)->totalTime() - 1.1) < 1e-3);
+    QVERIFY(estimate(lines, 1)->totalTime() > 2.0);
+}
+
+void test_case_1::stock_simulator()
+{
+    const auto tools {StockSimulator::parseToolTable("T1=F10, T2=B6")};
+    QVERIFY(tools.has_value());
+    QCOMPARE(tools->size(), size_t(2));
+    QVERIFY(tools->at(2).shape == StockSimulator::Tool::BallEnd && tools->at(2).radius == 3.0);
+    QVERIFY(!StockSimulator::parseToolTable("T1=X10").has_value());
+    QVERIFY(!StockSimulator::parseToolTable("T1=F").has_value());
+
+    StockSimulator simulator;
+    for (const auto& [number, tool] : *tools)
+        simulator.setTool(number, tool);
+    Controller c;
+    c.setListener(&simulator);
+    c.addLine(std::string("T1 D1"));
+    c.addLine(std::string("G0 X0 Y0 Z5"));
+    c.addLine(std::string("G1 Z-1 F100"));
+    c.addLine(std::string("X40"));
+    c.addLine(std::string("G0 Z-3"));    // into the material
+    c.addLine(std::string("Z5"));
+    c.addLine(std::string("T2"));
+    c.addLine(std::string("X0 Y20"));
+    c.addLine(std::string("G1 Z-2"));
+    c.addLine(std::string("X40"));
+    c.run();
+
+    // flat end slot, the stock spans the feed motions and their tool radius
+    QCOMPARE(simulator.stockTop(), 5.0);
+    QVERIFY(std::abs(simulator.origin().x + 5.0) < 1e-9 && std::abs(simulator.origin().y + 5.0) < 1e-9);
+    QVERIFY(std::abs(simulator.heightAt({20.0, 0.0}) + 1.0) < 1e-3);
+    QVERIFY(std::abs(simulator.heightAt({20.0, 4.9}) + 1.0) < 1e-3);
+    QCOMPARE(simulator.stateAt({20.0, 0.0}), StockSimulator::Cut);
+    QCOMPARE(simulator.stateAt({40.0, 0.0}), StockSimulator::RapidCut);
+    QVERIFY(std::abs(simulator.heightAt({40.0, 0.0}) + 3.0) < 1e-3);
+
+    // ball end slot, -2 + 3 - sqrt(3² - 2²) at 2 mm from its center line
+    QVERIFY(std::abs(simulator.heightAt({20.0, 20.0}) + 2.0) < 1e-2);
+    QVERIFY(std::abs(simulator.heightAt({20.0, 22.0}) - (1.0 - std::sqrt(5.0))) < 5e-2);
+
+    QCOMPARE(simulator.stateAt({20.0, 10.0}), StockSimulator::Uncut);
+    QCOMPARE(simulator.heightAt({20.0, 10.0}), 5.0);
+}
+
+void test_case_1::cross_reference_index()
+{
+    using Kind = CrossReferenceIndex::SymbolKind;
+    using Usage = CrossReferenceIndex::Usage;
+    Parser parser;
+    CrossReferenceIndex index;
+    auto setLines = [&parser, &index](size_t first, size_t removed, const std::vector<std::string>& lines)
+    {
+        index.replaceLines(first, removed, lines.size());
+        for (size_t i {0}; i < lines.size(); i++)
+            index.setLine(first + i, parser.parse(lines[i]), parser);
+    };
+    auto lines = [&index](Kind kind, const std::string& name)
+    {
+        std::vector<std::pair<size_t, Usage>> result;
+        for (const auto& reference : index.usages({kind, name}))
+            result.emplace_back(reference.line, reference.usage);
+        return result;
+    };
+    using Lines = std::vector<std::pair<size_t, Usage>>;
+
+    setLines(0, 0, {"DEF INT COUNTER=0",
+                    "N10 T5 D1",
+                    "LOOP1: R17=R17+COUNTER",
+                    "counter=COUNTER+1",
+                    "IF COUNTER<3 GOTOB LOOP1",
+                    "GOTOF N20",
+                    "N20 M30"});
+    QCOMPARE(index.lineCount(), size_t(7));
+    QCOMPARE(lines(Kind::RParameter, "17"), (Lines{{2, Usage::Write}, {2, Usage::Read}}));
+    QCOMPARE(lines(Kind::Variable, "COUNTER"), (Lines{{0, Usage::Definition}, {2, Usage::Read}, {3, Usage::Write},
+                                                      {3, Usage::Read}, {4, Usage::Read}}));
+    QCOMPARE(lines(Kind::Tool, "5"), (Lines{{1, Usage::ToolSelect}}));
+    QCOMPARE(lines(Kind::Label, "LOOP1"), (Lines{{2, Usage::Definition}, {4, Usage::Jump}}));
+    QCOMPARE(index.definition({Kind::Label, "LOOP1"}, 4), std::optional<size_t>(2));
+    QCOMPARE(index.definition({Kind::Variable, "COUNTER"}, 3), std::optional<size_t>(0));
+    QCOMPARE(index.definition({Kind::BlockNumber, "20"}, 5), std::optional<size_t>(6));
+    QCOMPARE(index.definition({Kind::RParameter, "17"}), std::optional<size_t>());
+
+    QVERIFY(index.findSymbol("r017") == (CrossReferenceIndex::Symbol{Kind::RParameter, "17"}));
+    QVERIFY(index.findSymbol("LOOP1") == (CrossReferenceIndex::Symbol{Kind::Label, "LOOP1"}));
+    QVERIFY(index.findSymbol("Counter") == (CrossReferenceIndex::Symbol{Kind::Variable, "COUNTER"}));
+    QVERIFY(index.findSymbol("N20") == (CrossReferenceIndex::Symbol{Kind::BlockNumber, "20"}));
+    QVERIFY(!index.findSymbol("R18").has_value());
+
+    // inserting moves the lines after it
+    setLines(1, 0, {"R17=1"});
+    QCOMPARE(lines(Kind::RParameter, "17"), (Lines{{1, Usage::Write}, {3, Usage::Write}, {3, Usage::Read}}));
+    QCOMPARE(index.definition({Kind::Label, "LOOP1"}, 5), std::optional<size_t>(3));
+
+    // replacing drops the symbols of the old line
+    setLines(3, 1, {"R18=0"});
+    QCOMPARE(lines(Kind::RParameter, "17"), (Lines{{1, Usage::Write}}));
+    QCOMPARE(lines(Kind::Label, "LOOP1"), (Lines{{5, Usage::Jump}}));
+    QCOMPARE(index.definition({Kind::Label, "LOOP1"}, 5), std::optional<size_t>());
+
+    setLines(0, 2, {});
+    QCOMPARE(index.lineCount(), size_t(6));
+    QCOMPARE(lines(Kind::Variable, "COUNTER"), (Lines{{2, Usage::Write}, {2, Usage::Read}, {3, Usage::Read}}));
+    QCOMPARE(lines(Kind::Tool, "5"), (Lines{{0, Usage::ToolSelect}}));
+    QCOMPARE(index.definition({Kind::BlockNumber, "20"}), std::optional<size_t>(5));
+
+    // replacing all of many lines sharing a symbol, like select all and paste
+    const std::vector<std::string> counting(100000, "R1=R1+1");
+    setLines(0, index.lineCount(), counting);
+    QCOMPARE(index.usages({Kind::RParameter, "1"}).size(), size_t(200000));
+    setLines(0, counting.size(), {"R1=2", "R2=R1"});
+    QCOMPARE(index.lineCount(), size_t(2));
+    QCOMPARE(lines(Kind::RParameter, "1"), (Lines{{0, Usage::Write}, {1, Usage::Read}}));
+    QVERIFY(!index.findSymbol("COUNTER").has_value());
+}
+
+void test_case_1::program_transform()
+{
+    ProgramTransform::Options options;
+    options.renumber = true;
+    options.renumberStart = 100;
+    options.mirror = {false, true, false};
+    options.offset = {1.0, 2.0, 0.0};
+    options.feedPercent = 50.0;
+
+    std::istringstream in {"; header\n"
+                           "N10 G90 G17 X10 Y-5.5 F100 ; keep X10\n"
+                           "N20 G2 X20 Y0 I5 J0\n"
+                           "N30 G91 X1 Y=R1\n"
+                           "N40 GOTOB N10\n"
+                           "N40 M30"};
+    std::ostringstream out;
+    auto result {ProgramTransform{options}.transform(in, out)};
+    QCOMPARE(out.str(), std::string("; header\n"
+                                    "N100 G90 G17 X11 Y7.5 F50 ; keep X10\n"
+                                    "N110 G3 X21 Y2 I5 J0\n"
+                                    "N120 G91 X1 Y=R1\n"
+                                    "N130 GOTOB N100\n"
+                                    "N140 M30"));
+    QCOMPARE(result.blockCount, size_t(6));
+    QCOMPARE(result.changedBlocks, size_t(5));
+    QCOMPARE(result.skippedWords, size_t(1));
+    QCOMPARE(result.alarmCount, size_t(0));
+
+    // blocks with syntax errors are copied, line ends are kept
+    ProgramTransform::Options shift;
+    shift.offset = {0.0, 0.0, -0.25};
+    std::istringstream in2 {"G0 Z=\r\nG0 Z=AC(10) X5\r\n"};
+    std::ostringstream out2;
+    result = ProgramTransform{shift}.transform(in2, out2);
+    QCOMPARE(out2.str(), std::string("G0 Z=\r\nG0 Z=AC(9.75) X5\r\n"));
+    QCOMPARE(result.alarmCount, size_t(1));
+
+    // blocks with alarms are renumbered too, so the jumps keep their targets
+    ProgramTransform::Options renumber;
+    renumber.renumber = true;
+    std::istringstream in3 {"N10 G0 X1\nN20 X=[[\nN30 X2\nGOTOB N30\nN40 M30"};
+    std::ostringstream out3;
+    result = ProgramTransform{renumber}.transform(in3, out3);
+    QCOMPARE(out3.str(), std::string("N10 G0 X1\nN20 X=[[\nN30 X2\nGOTOB N30\nN40 M30"));
+    renumber.renumberStart = 100;
+    in3.clear();
+    in3.seekg(0);
+    std::ostringstream out4;
+    result = ProgramTransform{renumber}.transform(in3, out4);
+    QCOMPARE(out4.str(), std::string("N100 G0 X1\nN110 X=[[\nN120 X2\nGOTOB N120\nN130 M30"));
+    QCOMPARE(result.alarmCount, size_t(1));
+}
+
 QTEST_APPLESS_MAIN(test_case_1)
 
 #include "tst_test_case_1.moc"
+
+void test_case_1::path_rasterizer()
+{
+    MotionList motions;
+    Controller c;
+    c.setListener(&motions);
+    c.addLine(std::string("G0 X0 Y0"));
+    c.addLine(std::string("G1 X10 F100"));
+    c.addLine(std::string("G0 X0 Y10"));
+    c.run();
+
+    PathRasterizer rasterizer;
+    rasterizer.plot(motions);
+    QCOMPARE(rasterizer.segmentCount(), size_t{3});
+
+    // the 10 x 10 box fills 90 % of the image around its center, seen from the top
+    OrthographicCamera camera;
+    camera.setViewportSize(64, 64);
+    camera.fit(rasterizer.boundingBox());
+    QVERIFY(glm::all(glm::epsilonEqual(camera.worldToNDC({5.0f, 5.0f, 0.0f}), glm::vec2(0.0f), 1e-6f)));
+    QVERIFY(glm::all(glm::epsilonEqual(camera.worldToNDC({10.0f, 0.0f, 0.0f}), glm::vec2(0.9f, -0.9f), 1e-6f)));
+
+    const QImage image {rasterizer.thumbnail(64)};
+    QCOMPARE(image.size(), QSize(64, 64));
+    QCOMPARE(image.pixel(20, 20), qRgb(255, 50, 50));   // on the rapid diagonal
+    QCOMPARE(image.pixel(32, 60), qRgb(50, 255, 50));   // on the feed motion, before the box edge along it
+    QCOMPARE(image.pixel(1, 32), image.pixel(2, 32));
+    QVERIFY(qRed(image.pixel(1, 1)) < qRed(image.pixel(1, 62)));  // background gradient
+
+    PathRasterizer empty;
+    QCOMPARE(empty.thumbnail(16).size(), QSize(16, 16));
+
+    // zoomed in far, the line is longer than any integer of pixels
+    MotionList far;
+    c.reset();
+    c.setListener(&far);
+    c.addLine(std::string("G0 X0 Y0"));
+    c.addLine(std::string("G1 X1000000000000000 F100"));
+    c.run();
+    PathRasterizer farRasterizer;
+    farRasterizer.plot(far);
+    OrthographicCamera closeUp;
+    closeUp.setViewportSize(64, 64);
+    closeUp.fit(BoundingBox {glm::vec3(-0.0001f), glm::vec3(0.0001f)});
+    QCOMPARE(farRasterizer.render(closeUp).size(), QSize(64, 64));
+}
+
+void test_case_1::program_index()
+{
+    const auto directory {std::filesystem::temp_directory_path() / "tst_program_index"};
+    std::filesystem::remove_all(directory);
+    std::filesystem::create_directories(directory / "sub");
+    const std::string indexPath {(directory / "index" / "programs.tsv").string()};
+
+    auto write = [](const std::filesystem::path& path, const char* text)
+    {
+        std::ofstream file {path};
+        file << text;
+    };
+    write(directory / "a.mpf", "T1\nG0 X10 Y10\nG1 X20 F100\nT3\nG2 X30 I5\nM30\n");
+    write(directory / "sub" / "b.spf", "G0 X10\nX1 X2\nM30\n");
+
+    // stopped, at most one program per worker is evaluated and only those are indexed
+    ProgramIndex stopped {indexPath};
+    const size_t stoppedCount {stopped.update(directory.string(), [](size_t, size_t) { return false; })};
+    QVERIFY(stoppedCount >= 1);
+    QCOMPARE(stopped.summaries().size(), stoppedCount);
+
+    ProgramIndex index {indexPath};
+    QVERIFY(!index.load());
+    QCOMPARE(index.update(directory.string()), size_t(2));
+    QVERIFY(index.save());
+    QCOMPARE(index.summaries().size(), size_t(2));
+    const auto& a {index.summaries()[0]};
+    QVERIFY(a.readable);
+    QCOMPARE(a.blockCount, size_t(6));
+    QCOMPARE(a.motionCount, size_t(3));
+    QCOMPARE(a.rapidCount, size_t(1));
+    QCOMPARE(a.alarmCount, size_t(0));
+    QVERIFY(a.tools == std::vector<int>({1, 3}));
+    // diagonal rapid, straight feed and a half circle
+    QVERIFY(std::abs(a.pathLength - (std::sqrt(200.0) + 10.0 + 5.0 * glm::pi<double>())) < 1e-6);
+    QCOMPARE(index.summaries()[1].alarmCount, size_t(1));
+
+    QVERIFY(ProgramIndex::matches(a, "A.MPF t3"));
+    QVERIFY(!ProgramIndex::matches(a, "t2"));
+    QVERIFY(!ProgramIndex::matches(a, "alarm"));
+    QVERIFY(ProgramIndex::matches(index.summaries()[1], "alarm b"));
+
+    // read back, unchanged and touched programs are not evaluated again
+    ProgramIndex loaded {indexPath};
+    QVERIFY(loaded.load());
+    QCOMPARE(loaded.summaries().size(), size_t(2));
+    QVERIFY(loaded.summaries()[0].tools == a.tools);
+    QVERIFY(glm::all(glm::epsilonEqual(loaded.summaries()[0].boundingBox.upperCorner(),
+                                       a.boundingBox.upperCorner(), 1e-4f)));
+    QCOMPARE(loaded.update(directory.string()), size_t(0));
+    std::filesystem::last_write_time(directory / "a.mpf", std::filesystem::last_write_time(directory / "a.mpf") -
+                                     std::chrono::hours(1));
+    QCOMPARE(loaded.update(directory.string()), size_t(0));
+
+    // changed, new and removed programs
+    write(directory / "sub" / "b.spf", "G0 X10\nM30\n");
+    write(directory / "c.mpf", "G0 Z5\n");
+    std::filesystem::remove(directory / "a.mpf");
+    QCOMPARE(loaded.update(directory.string()), size_t(2));
+    QCOMPARE(loaded.summaries().size(), size_t(2));
+    QCOMPARE(loaded.summaries()[1].alarmCount, size_t(0));
+
+    // an endless loop is found like an alarm, also after reading the index back
+    write(directory / "d.mpf", "LOOP1:\nGOTOB LOOP1\nM30\n");
+    QCOMPARE(loaded.update(directory.string()), size_t(1));
+    QVERIFY(loaded.save());
+    ProgramIndex looped {indexPath};
+    QVERIFY(looped.load());
+    QCOMPARE(looped.summaries().size(), size_t(3));
+    const auto& d {looped.summaries()[1]};
+    QVERIFY(d.jumpLimit && d.alarmCount == 0);
+    QVERIFY(ProgramIndex::matches(d, "alarm"));
+    QVERIFY(!looped.summaries()[0].jumpLimit);
+
+    std::filesystem::remove_all(directory);
+}